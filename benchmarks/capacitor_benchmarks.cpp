@@ -0,0 +1,557 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <cmath>
+#include <cstdio>
+
+#include "capacitors.h"
+#include "capacitor_tank.h"
+#include "capacitor_compiled.h"
+#include "capacitor_kernels.h"
+#include "capacitor_static.h"
+#include "capacitor_faults.h"
+#include "capacitor_harmonics.h"
+#include "capacitor_waveform.h"
+#include "capacitor_monitor.h"
+#include "capacitor_catalog.h"
+#include "capacitor_spec_parser.h"
+
+#include <benchmark/benchmark.h>
+namespace {
+
+std::vector<CapacitorSpecification> synthetic_catalog(size_t size)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> cap(0.5f, 30.0f);
+    std::uniform_real_distribution<float> volt(200.0f, 1200.0f);
+    std::uniform_real_distribution<float> amp(100.0f, 1000.0f);
+    std::uniform_real_distribution<float> power(1e5f, 1e6f);
+
+    std::vector<CapacitorSpecification> catalog;
+    catalog.reserve(size);
+    for (size_t k = 0; k < size; ++k)
+    {
+        catalog.push_back({cap(rng) * 1e-6f, amp(rng), "part" + std::to_string(k), power(rng), volt(rng)});
+    }
+    return catalog;
+}
+
+json catalog_json(const std::vector<CapacitorSpecification> &catalog)
+{
+    json data = json::array();
+    for (auto &spec : catalog)
+    {
+        data.push_back({{"name", spec.name},
+                        {"capacitance", spec.capacitance},
+                        {"voltage", spec.voltage},
+                        {"current", spec.current},
+                        {"power", spec.power}});
+    }
+    return data;
+}
+
+// Owns the nodes of a composite built for a benchmark.
+struct Tree
+{
+    std::vector<std::unique_ptr<CapacitorInterface>> nodes;
+
+    CapacitorInterface *add(CapacitorInterface *cap)
+    {
+        nodes.emplace_back(cap);
+        return cap;
+    }
+
+    CapacitorInterface *capacitor(size_t k)
+    {
+        return add(new Capacitor(1 + k % 23, 500 + k % 500, 500, 500e3, "c" + std::to_string(k)));
+    }
+
+    std::vector<CapacitorInterface *> capacitors(size_t width)
+    {
+        std::vector<CapacitorInterface *> caps;
+        for (size_t k = 0; k < width; ++k)
+        {
+            caps.push_back(capacitor(k));
+        }
+        return caps;
+    }
+
+    // Binary tree of the given depth whose levels alternate between series and parallel groups.
+    CapacitorInterface *nested(size_t depth, bool series = true)
+    {
+        if (depth == 0)
+        {
+            return capacitor(nodes.size());
+        }
+        std::vector<CapacitorInterface *> children = {nested(depth - 1, !series), nested(depth - 1, !series)};
+        if (series)
+        {
+            return add(new SeriesCapacitor(children));
+        }
+        return add(new ParallelCapacitor(children));
+    }
+};
+
+void BM_CapacitorXc(benchmark::State &state)
+{
+    Capacitor cap(23, 500, 900, 500e3, "23uF_500V");
+    double f = 10000;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(f);
+        benchmark::DoNotOptimize(cap.xc(f));
+    }
+}
+BENCHMARK(BM_CapacitorXc);
+
+void BM_ParallelCapacitorCurrent(benchmark::State &state)
+{
+    Tree tree;
+    ParallelCapacitor parallel(tree.capacitors(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(parallel.current(10000, 100));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParallelCapacitorCurrent)->RangeMultiplier(4)->Range(1, 256);
+
+void BM_SeriesCapacitorCurrent(benchmark::State &state)
+{
+    Tree tree;
+    SeriesCapacitor series(tree.capacitors(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(series.current(10000, 100));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SeriesCapacitorCurrent)->RangeMultiplier(4)->Range(1, 256);
+
+void BM_SeriesCapacitorAllowedCurrent(benchmark::State &state)
+{
+    Tree tree;
+    SeriesCapacitor series(tree.capacitors(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(series.allowed_current(10000));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SeriesCapacitorAllowedCurrent)->RangeMultiplier(4)->Range(1, 256);
+
+void BM_NestedTankCurrent(benchmark::State &state)
+{
+    Tree tree;
+    CapacitorInterface *root = tree.nested(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(root->current(10000, 100));
+    }
+    state.SetItemsProcessed(state.iterations() * tree.nodes.size());
+}
+BENCHMARK(BM_NestedTankCurrent)->DenseRange(2, 10, 2);
+
+void BM_CompiledNestedTankCurrent(benchmark::State &state)
+{
+    Tree tree;
+    CompiledTank tank(*tree.nested(state.range(0)));
+    CompiledTankEvaluator evaluator(tank);
+    for (auto _ : state)
+    {
+        evaluator.prepare(10000);
+        benchmark::DoNotOptimize(evaluator.current(100));
+    }
+    state.SetItemsProcessed(state.iterations() * tank.size());
+}
+BENCHMARK(BM_CompiledNestedTankCurrent)->DenseRange(2, 10, 2);
+
+struct Part23uF { static constexpr double cap_uF = 23, v_max = 500, i_max = 1000, power_max = 500e3; };
+struct Part1uF { static constexpr double cap_uF = 1, v_max = 1000, i_max = 500, power_max = 500e3; };
+using StaticTank = Series<Parallel<Cap<Part23uF>, Cap<Part1uF>>, Parallel<Cap<Part1uF>>>;
+
+// The demo tank as a compile-time topology, against the same tank built from the composite classes.
+void BM_StaticTankCurrent(benchmark::State &state)
+{
+    double f = 10000;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(f);
+        benchmark::DoNotOptimize(StaticTank::current(f, 100));
+    }
+}
+BENCHMARK(BM_StaticTankCurrent);
+
+void BM_CompositeTankCurrent(benchmark::State &state)
+{
+    Capacitor c1(23, 500, 1000, 500e3), c2(1, 1000, 500, 500e3), c3(1, 1000, 500, 500e3);
+    ParallelCapacitor parallel1({&c1, &c2}), parallel2({&c3});
+    SeriesCapacitor serial({&parallel1, &parallel2});
+    double f = 10000;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(f);
+        benchmark::DoNotOptimize(serial.current(f, 100));
+    }
+}
+BENCHMARK(BM_CompositeTankCurrent);
+
+// Every single-part failure of two parallel banks in series; linear in the number of parts.
+void BM_FaultAnalysis(benchmark::State &state)
+{
+    Tree tree;
+    ParallelCapacitor bank1(tree.capacitors(state.range(0)));
+    ParallelCapacitor bank2(tree.capacitors(state.range(0)));
+    SeriesCapacitor serial({&bank1, &bank2});
+    CompiledTank tank(serial);
+    FaultOptions options;
+    options.current = 100;
+    options.frequency = 10000;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_fault_analysis(tank, options));
+    }
+    state.SetItemsProcessed(state.iterations() * 2 * state.range(0));
+}
+BENCHMARK(BM_FaultAnalysis)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// Reactance and current of 4096 (f, C) pairs, per instruction set.
+void BM_CapacitorKernels(benchmark::State &state)
+{
+    const CapacitorKernels *kernels = capacitor_kernels(static_cast<KernelIsa>(state.range(0)));
+    if (!kernels)
+    {
+        state.SkipWithError("instruction set not supported");
+        return;
+    }
+    state.SetLabel(kernel_isa_name(kernels->isa));
+
+    const size_t n = 4096;
+    std::vector<double> f(n), cap_F(n), xc(n), voltage(n, 100), current(n), power(n);
+    for (size_t k = 0; k < n; ++k)
+    {
+        f[k] = 50 + k;
+        cap_F[k] = (1 + k % 23) * 1e-6;
+    }
+    for (auto _ : state)
+    {
+        kernels->xc(f.data(), cap_F.data(), xc.data(), n);
+        kernels->current(voltage.data(), xc.data(), current.data(), power.data(), n);
+        benchmark::DoNotOptimize(kernels->parallel_xc(xc.data(), n));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_CapacitorKernels)->DenseRange(static_cast<int>(KernelIsa::Scalar), static_cast<int>(KernelIsa::AVX512));
+
+// The decorator stack of calculate_capacitors_tank, at a point without violations.
+void BM_CalculateCapacitorsTank(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1(state.range(0), "part0");
+    std::vector<std::string> group2(state.range(0), "part1");
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tank_calculator.calculate_capacitors_tank(50, 1));
+    }
+}
+BENCHMARK(BM_CalculateCapacitorsTank)->DenseRange(1, 5, 2);
+
+void BM_CalculateAllowedCurrent(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1(5, "part0");
+    std::vector<std::string> group2(5, "part1");
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    float f = 50;
+    for (auto _ : state)
+    {
+        // A new frequency every iteration, so the reactances are not reused.
+        f = f == 50 ? 60 : 50;
+        benchmark::DoNotOptimize(tank_calculator.calculate_allowed_current(f));
+    }
+}
+BENCHMARK(BM_CalculateAllowedCurrent);
+
+// Double and single precision sweeps of the same points, SweepLanes<T>::size points per evaluation.
+template <typename T>
+void BM_SweepCapacitorsTank(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1 = {"part0", "part1", "part2", "part3", "part4"};
+    std::vector<std::string> group2 = {"part5", "part6", "part7", "part8", "part9"};
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    const size_t points = 4096;
+    std::vector<float> frequencies(points), currents(points);
+    for (size_t p = 0; p < points; ++p)
+    {
+        frequencies[p] = 50 + p;
+        currents[p] = 1 + p % 100;
+    }
+    BasicTankSweepResult<T> result;
+    for (auto _ : state)
+    {
+        tank_calculator.sweep_capacitors_tank(frequencies, currents, result);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * points);
+}
+BENCHMARK_TEMPLATE(BM_SweepCapacitorsTank, double);
+BENCHMARK_TEMPLATE(BM_SweepCapacitorsTank, float);
+
+// Same queries as BM_CalculateAllowedCurrent, answered from the envelope.
+void BM_AllowedCurrentEnvelope(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1(5, "part0");
+    std::vector<std::string> group2(5, "part1");
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    AllowedCurrentEnvelope envelope = tank_calculator.allowed_current_envelope(10, 1e6);
+    double f = 50;
+    for (auto _ : state)
+    {
+        f = f == 50 ? 60 : 50;
+        benchmark::DoNotOptimize(envelope(f));
+    }
+}
+BENCHMARK(BM_AllowedCurrentEnvelope);
+
+// Spectra of 200 harmonics through the 10-part tank, with the limit check.
+void BM_HarmonicSpectrum(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1 = {"part0", "part1", "part2", "part3", "part4"};
+    std::vector<std::string> group2 = {"part5", "part6", "part7", "part8", "part9"};
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    std::vector<Harmonic> harmonics;
+    for (int h = 1; h <= 200; ++h)
+    {
+        harmonics.push_back({50.0 * h, 100.0 / h});
+    }
+    HarmonicEvaluator evaluator(tank_calculator.compiled());
+    ViolationReport report(64);
+    for (auto _ : state)
+    {
+        report.clear();
+        benchmark::DoNotOptimize(evaluator.evaluate(harmonics));
+        evaluator.check_limits(report);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HarmonicSpectrum);
+
+// Samples per second through the analyzer alone, and streamed from a (cached) file with the reader thread.
+void BM_WaveformProcess(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1 = {"part0", "part1", "part2", "part3", "part4"};
+    std::vector<std::string> group2 = {"part5", "part6", "part7", "part8", "part9"};
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    std::vector<float> samples(1 << 20);
+    for (size_t k = 0; k < samples.size(); ++k)
+    {
+        samples[k] = static_cast<float>(100 * std::sin(2 * M_PI * 1000 * k / 1e6));
+    }
+    WaveformAnalyzer analyzer(tank_calculator.compiled(), WaveformOptions());
+    for (auto _ : state)
+    {
+        analyzer.process(samples.data(), samples.size(), [](uint64_t, const ViolationReport &) {});
+    }
+    benchmark::DoNotOptimize(analyzer.node_statistics(0));
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK(BM_WaveformProcess)->Unit(benchmark::kMillisecond);
+
+void BM_WaveformStream(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1 = {"part0", "part1", "part2", "part3", "part4"};
+    std::vector<std::string> group2 = {"part5", "part6", "part7", "part8", "part9"};
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    std::vector<float> samples(1 << 22);
+    for (size_t k = 0; k < samples.size(); ++k)
+    {
+        samples[k] = static_cast<float>(100 * std::sin(2 * M_PI * 1000 * k / 1e6));
+    }
+    std::FILE *file = std::tmpfile();
+    std::fwrite(samples.data(), sizeof(float), samples.size(), file);
+    for (auto _ : state)
+    {
+        std::rewind(file);
+        WaveformAnalyzer analyzer(tank_calculator.compiled(), WaveformOptions());
+        benchmark::DoNotOptimize(stream_waveform(analyzer, file, [](uint64_t, const ViolationReport &) {}));
+    }
+    std::fclose(file);
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK(BM_WaveformStream)->Unit(benchmark::kMillisecond);
+
+// One live telemetry update of a 10 part tank, alternating over and within the limits so events are raised and cleared.
+void BM_MonitorUpdate(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(10);
+    std::vector<std::string> group1 = {"part0", "part1", "part2", "part3", "part4"};
+    std::vector<std::string> group2 = {"part5", "part6", "part7", "part8", "part9"};
+    TankCalculator tank_calculator(catalog);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    MonitorOptions options;
+    options.debounce = 1;
+    TankMonitor monitor(tank_calculator.compiled(), options);
+    TelemetrySample samples[2] = {{100000, 50}, {1, 10000}};
+    size_t k = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(monitor.update(samples[(k++ >> 10) & 1]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MonitorUpdate);
+
+// TankCalculator construction stores the whole catalog, so composing scales with the catalog size.
+void BM_ComposeCapacitorsTank(benchmark::State &state)
+{
+    std::vector<CapacitorSpecification> catalog = synthetic_catalog(state.range(0));
+    std::vector<std::string> group1 = {"part0", "part1", "part2"};
+    std::vector<std::string> group2 = {"part3", "part4"};
+    for (auto _ : state)
+    {
+        TankCalculator tank_calculator(catalog);
+        tank_calculator.compose_capacitors_tank(group1, group2);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ComposeCapacitorsTank)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// With the catalog interned once and shared, as the daemon does, composing by id does not depend on the catalog size.
+void BM_ComposeCapacitorsTankById(benchmark::State &state)
+{
+    auto parts = std::make_shared<const PartIndex>(synthetic_catalog(state.range(0)));
+    std::vector<PartId> group1 = {0, 1, 2};
+    std::vector<PartId> group2 = {3, 4};
+    for (auto _ : state)
+    {
+        TankCalculator tank_calculator(parts);
+        tank_calculator.compose_capacitors_tank(group1, group2);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ComposeCapacitorsTankById)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// One calculator recomposed for every candidate, as a design search does: the nodes are reused in place.
+void BM_RecomposeCapacitorsTank(benchmark::State &state)
+{
+    auto parts = std::make_shared<const PartIndex>(synthetic_catalog(100));
+    std::vector<PartId> group1(state.range(0)), group2(state.range(0));
+    TankCalculator tank_calculator(parts);
+    PartId next = 0;
+    for (auto _ : state)
+    {
+        for (size_t k = 0; k < group1.size(); ++k)
+        {
+            group1[k] = next++ % 100;
+            group2[k] = next++ % 100;
+        }
+        tank_calculator.compose_capacitors_tank(group1, group2);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_RecomposeCapacitorsTank)->Arg(3)->Arg(10)->Arg(50)->Unit(benchmark::kMicrosecond);
+
+void BM_ParseCapacitorSpecifications(benchmark::State &state)
+{
+    json data = catalog_json(synthetic_catalog(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(parse_capacitor_specifications(data));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParseCapacitorSpecifications)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// Text to specifications through the document.
+void BM_ParseCapacitorSpecificationText(benchmark::State &state)
+{
+    std::string text = catalog_json(synthetic_catalog(state.range(0))).dump();
+    for (auto _ : state)
+    {
+        json data = json::parse(text);
+        benchmark::DoNotOptimize(parse_capacitor_specifications(data));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ParseCapacitorSpecificationText)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// The same text straight into specifications, on one thread and, as parse_capacitor_specifications_file
+// does, on all cores.
+void BM_StreamCapacitorSpecificationText(benchmark::State &state)
+{
+    std::string text = catalog_json(synthetic_catalog(state.range(0))).dump();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(parse_capacitor_specifications_text(text, state.range(1)));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_StreamCapacitorSpecificationText)->ArgsProduct({{10, 1000, 100000, 1000000}, {1, 0}})->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// The same catalogs from the binary format: mapping and validation alone, then with a lookup of every part
+// and the copy into specifications.
+void BM_OpenCapacitorCatalog(benchmark::State &state)
+{
+    std::string path = "capacitor_benchmark_catalog.tcat";
+    write_capacitor_catalog(synthetic_catalog(state.range(0)), path);
+    for (auto _ : state)
+    {
+        CapacitorCatalog catalog(path);
+        benchmark::DoNotOptimize(catalog.size());
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OpenCapacitorCatalog)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+void BM_LoadCapacitorCatalog(benchmark::State &state)
+{
+    std::string path = "capacitor_benchmark_catalog.tcat";
+    write_capacitor_catalog(synthetic_catalog(state.range(0)), path);
+    for (auto _ : state)
+    {
+        CapacitorCatalog catalog(path);
+        benchmark::DoNotOptimize(catalog.find("part1"));
+        benchmark::DoNotOptimize(catalog.specifications());
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadCapacitorCatalog)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// The part index the command line and the daemon build over a mapped catalog, names viewed in place.
+void BM_IndexCapacitorCatalog(benchmark::State &state)
+{
+    std::string path = "capacitor_benchmark_catalog.tcat";
+    write_capacitor_catalog(synthetic_catalog(state.range(0)), path);
+    for (auto _ : state)
+    {
+        PartIndex parts(std::make_shared<const CapacitorCatalog>(path));
+        benchmark::DoNotOptimize(parts.find("part1"));
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IndexCapacitorCatalog)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "capacitor_tank.h"
+
+struct BatchStats
+{
+    uint64_t points = 0;
+    uint64_t skipped_lines = 0;
+};
+
+// Streams "current,frequency" lines from input through the composed tank and writes one
+// "current,frequency,tank_current,allowed_current,violations" row per point to output, where violations
+// counts the exceeded node limits. Input and output go through large buffers; blank lines and a
+// non-numeric header line are skipped, other malformed lines are reported on stderr and skipped.
+BatchStats run_batch(TankCalculator &tank_calculator, std::FILE *input, std::FILE *output);
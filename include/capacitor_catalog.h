@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "capacitor_tank.h"
+
+// Binary capacitor catalog, all numbers in host byte order:
+//
+//   CatalogHeader
+//   float capacitance[count], voltage[count], current[count], power[count]   (F, V, A, W)
+//   uint32 name_offset[count + 1]    name of part k is strings[name_offset[k], name_offset[k + 1])
+//   uint32 by_name[count]            parts ordered by name, ties in file order
+//   char strings[strings_size]
+//
+// The checksum is FNV-1a over the 64-bit words of everything after the header, the last partial word
+// padded with zeros.
+struct CatalogHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint64_t strings_size;
+    uint64_t checksum;
+};
+
+constexpr uint32_t catalog_version = 1;
+
+// Read-only view of a binary catalog mapped into memory. The columns and names are used in place; opening
+// only validates the layout and the checksum.
+class CapacitorCatalog
+{
+    void *_mapping = nullptr;
+    size_t _mapped = 0;
+    size_t _count = 0;
+    const float *_capacitance = nullptr;
+    const float *_voltage = nullptr;
+    const float *_current = nullptr;
+    const float *_power = nullptr;
+    const uint32_t *_name_offset = nullptr;
+    const uint32_t *_by_name = nullptr;
+    const char *_strings = nullptr;
+
+public:
+    static constexpr size_t npos = SIZE_MAX;
+
+    // Maps and validates the file. Throws std::runtime_error when it cannot be read, is not a catalog of
+    // this version, is truncated or inconsistent, or fails the checksum.
+    explicit CapacitorCatalog(const std::string &path);
+    ~CapacitorCatalog();
+    CapacitorCatalog(const CapacitorCatalog &) = delete;
+    CapacitorCatalog &operator=(const CapacitorCatalog &) = delete;
+
+    size_t size() const { return _count; }
+    const float *capacitance() const { return _capacitance; }
+    const float *voltage() const { return _voltage; }
+    const float *current() const { return _current; }
+    const float *power() const { return _power; }
+    std::string_view name(size_t part) const
+    {
+        return std::string_view(_strings + _name_offset[part], _name_offset[part + 1] - _name_offset[part]);
+    }
+
+    // Part of that name by binary search, the last one in file order like the JSON loading, or npos.
+    size_t find(std::string_view name) const;
+
+    CapacitorSpecification specification(size_t part) const;
+    std::vector<CapacitorSpecification> specifications() const;
+};
+
+// Writes specs as a binary catalog. Throws std::runtime_error when the file cannot be written.
+void write_capacitor_catalog(const std::vector<CapacitorSpecification> &specs, const std::string &path);
+
+// True for a path ending in .tcat, the extension the command line reads as a binary catalog.
+bool is_capacitor_catalog_path(const std::string &path);
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "capacitors.h"
+#include "capacitor_lanes.h"
+#include "capacitor_string_recycler.h"
+#include "capacitor_violation_report.h"
+
+// Capacitor composite lowered into a flat program. Nodes are stored in postfix order (children before their
+// group, siblings in composition order) as struct-of-arrays, so evaluation is a few linear passes over
+// contiguous memory without virtual calls. Decorators are transparent and do not appear in the program.
+class CompiledTank
+{
+    std::vector<CapacitorKind> _kind;
+    std::vector<uint32_t> _parent;
+    std::vector<uint8_t> _first_child;
+    std::vector<double> _cap_uF;
+    std::vector<double> _cap_F;
+    std::vector<double> _v_max;
+    std::vector<double> _i_max;
+    std::vector<double> _power_max;
+    std::vector<std::string> _names;
+    StringRecycler _recycled_names;
+
+    // Scratch of the post-order walk, kept so recompiling does not allocate.
+    struct Frame
+    {
+        const CapacitorInterface* cap;
+        size_t next_child;
+        size_t pending_begin;
+    };
+    std::vector<Frame> _stack;
+    // Ids of emitted nodes whose group has not been emitted yet.
+    std::vector<uint32_t> _pending;
+
+    uint32_t _add_node(const CapacitorInterface& cap);
+
+public:
+    static constexpr uint32_t no_parent = UINT32_MAX;
+
+    CompiledTank() = default;
+    explicit CompiledTank(const CapacitorInterface& root);
+
+    // Replaces the program by the one of root, reusing the storage of the previous one.
+    void compile(const CapacitorInterface& root);
+
+    size_t size() const { return _kind.size(); }
+    uint32_t root() const { return static_cast<uint32_t>(_kind.size() - 1); }
+
+    const std::vector<CapacitorKind>& kind() const { return _kind; }
+    const std::vector<uint32_t>& parent() const { return _parent; }
+    const std::vector<uint8_t>& first_child() const { return _first_child; }
+    const std::vector<double>& cap_uF() const { return _cap_uF; }
+    const std::vector<double>& cap_F() const { return _cap_F; }
+    const std::vector<double>& v_max() const { return _v_max; }
+    const std::vector<double>& i_max() const { return _i_max; }
+    const std::vector<double>& power_max() const { return _power_max; }
+    const std::vector<std::string>& names() const { return _names; }
+};
+
+// Node values of a tank driven by a current, per unit of that current. A parallel group splits its current
+// between its members by capacitance alone, so every node carries the same share of the tank current at
+// every frequency, and its voltage, that current over 2 pi f C, falls as 1/f. A tank current I at f thus
+// puts current_share * I and unit_voltage * I / f on a node, and the evaluators of a current-driven tank
+// only scale these. Computed by one evaluation at 1 A and 1 Hz.
+struct CurrentDriveResponse
+{
+    std::vector<double> current_share; // node current per ampere of tank current
+    std::vector<double> unit_voltage;  // node voltage at 1 A and 1 Hz
+
+    CurrentDriveResponse() = default;
+    explicit CurrentDriveResponse(const CompiledTank& tank);
+};
+
+// Evaluates a CompiledTank with the same floating point operations, in the same order, as the
+// CapacitorInterface methods of the tree it was compiled from, so results are bit-identical.
+// The reactance of every node is computed once per frequency into a scratch buffer and reused by
+// the current, voltage and allowed current queries. One evaluator per thread.
+//
+// T is the number type of the evaluation, double for CompiledTankEvaluator. Other types go through the
+// same formulas (capacitor_formulas.h): Interval for worst-case bounds, float and SweepLanes for sweeps,
+// Dual for sensitivities.
+// They are instantiated in capacitor_compiled.cpp.
+template <typename T>
+class BasicCompiledTankEvaluator
+{
+    const CompiledTank& tank;
+    std::vector<T> _cap_F;
+    std::vector<T> _xc;
+    std::vector<T> _current;
+    std::vector<T> _voltage;
+    std::vector<T> _allowed_current;
+
+    bool _prepared = false;
+    T _frequency = 0.0;
+    uint64_t _xc_visits = 0;
+
+    void _ensure_prepared(const T& f);
+
+public:
+    explicit BasicCompiledTankEvaluator(const CompiledTank& tank);
+
+    // Follows a compile() of the tank: capacitances back to the compiled values, nothing prepared.
+    // Reuses the buffers, so it does not allocate unless the tank grew.
+    void reset();
+
+    // Replaces the capacitance of a single capacitor node, the compiled value until then. Takes effect
+    // at the next prepare().
+    void set_cap_F(uint32_t node, const T& cap_F)
+    {
+        _cap_F[node] = cap_F;
+        _prepared = false;
+    }
+    const std::vector<T>& node_cap_F() const { return _cap_F; }
+
+    // Computes the reactance of every node at f. The queries without a frequency use it.
+    void prepare(const T& f);
+
+    // Root xc at the prepared frequency.
+    T xc() const { return _xc[tank.root()]; }
+
+    // Root current(f, voltage). Node currents and voltages are the values the decorators see on the reference tree.
+    T current(const T& voltage);
+
+    // Root voltage(f, current). Parallel groups split the current between their members by admittance.
+    T voltage(const T& current);
+
+    // Root allowed_current(f).
+    T allowed_current();
+
+    // Same as the queries above, preparing f first unless it is the frequency already prepared.
+    T xc(const T& f);
+    T current(const T& f, const T& voltage);
+    T voltage(const T& f, const T& current);
+    T allowed_current(const T& f);
+
+    // Records every node whose current, voltage or power of the last current()/voltage() query exceeds
+    // its limit, in node order, with the upper bound as the value. Does not allocate.
+    void check_limits(ViolationReport& report) const;
+
+    // Number of node reactances computed since construction, to check each node is visited once per frequency.
+    uint64_t xc_visits() const { return _xc_visits; }
+
+    const std::vector<T>& node_xc() const { return _xc; }
+    const std::vector<T>& node_current() const { return _current; }
+    const std::vector<T>& node_voltage() const { return _voltage; }
+    const std::vector<T>& node_allowed_current() const { return _allowed_current; }
+    T node_power(uint32_t node) const { return _current[node] * _voltage[node]; }
+};
+
+using CompiledTankEvaluator = BasicCompiledTankEvaluator<double>;
+
+// Sweep points evaluated together by one evaluator, 64 bytes of them: 8 doubles or 16 floats.
+template <typename T>
+using SweepLanes = Lanes<T, 64 / sizeof(T)>;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+
+#include "capacitor_lanes.h"
+
+// Forward-mode dual number: a value and its derivatives with respect to N parameters, carried through
+// the arithmetic by the chain rule. Seeding parameter k with a unit derivative in slot k and evaluating
+// once gives every result with its N partial derivatives.
+template <size_t N>
+struct Dual
+{
+    static constexpr size_t size = N;
+
+    double value;
+    Lanes<double, N> d;
+
+    Dual(double value = 0.0) : value(value), d(0.0) {}
+    Dual(double value, const Lanes<double, N> &d) : value(value), d(d) {}
+
+    // value with derivative scale in slot parameter.
+    static Dual seed(double value, size_t parameter, double scale = 1.0)
+    {
+        Dual dual(value);
+        dual.d.v[parameter] = scale;
+        return dual;
+    }
+};
+
+template <size_t N>
+Dual<N> operator+(const Dual<N> &a, const Dual<N> &b)
+{
+    return {a.value + b.value, a.d + b.d};
+}
+
+template <size_t N>
+Dual<N> operator-(const Dual<N> &a, const Dual<N> &b)
+{
+    return {a.value - b.value, a.d - b.d};
+}
+
+template <size_t N>
+Dual<N> operator*(const Dual<N> &a, const Dual<N> &b)
+{
+    return {a.value * b.value, a.d * Lanes<double, N>(b.value) + Lanes<double, N>(a.value) * b.d};
+}
+
+template <size_t N>
+Dual<N> operator/(const Dual<N> &a, const Dual<N> &b)
+{
+    double quotient = a.value / b.value;
+    return {quotient, (a.d - Lanes<double, N>(quotient) * b.d) / Lanes<double, N>(b.value)};
+}
+
+template <size_t N>
+bool operator==(const Dual<N> &a, const Dual<N> &b)
+{
+    return a.value == b.value && a.d == b.d;
+}
+
+template <size_t N>
+bool operator!=(const Dual<N> &a, const Dual<N> &b)
+{
+    return !(a == b);
+}
+
+// The smaller operand with its derivatives, the branch the double evaluation takes.
+template <size_t N>
+Dual<N> smaller(const Dual<N> &a, const Dual<N> &b)
+{
+    return a.value < b.value ? a : b;
+}
+
+template <size_t N>
+double upper(const Dual<N> &value)
+{
+    return value.value;
+}
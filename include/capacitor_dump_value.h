@@ -1,6 +1,7 @@
 #pragma once
 
 #include "capacitors.h"
+#include "capacitor_result_table.h"
 
 
 // Decorator base class for current violation
@@ -13,17 +14,24 @@ public:
 
     virtual double xc(double f) const override;
     
-    virtual std::string name() const override;
+    virtual const std::string& name() const override;
     
     virtual const CapacitorSpec& spec() const override;
     
     virtual double allowed_current(double f) const override;
+
+    virtual CapacitorKind kind() const override;
+
+    virtual const std::vector<CapacitorInterface*>& capacitors() const override;
 };
 
-// Decorator for max current violation
+// Decorator appending the current, voltage and power of the node to a result table
 class CapacitoDumpValueDecorator : public CapacitoDumpValueDecoratorBase {
+    TankResultTable& table;
+    uint32_t name_id;
+
 public:
-    CapacitoDumpValueDecorator(CapacitorInterface* cap);
+    CapacitoDumpValueDecorator(CapacitorInterface* cap, TankResultTable& table);
 
     virtual double current(double f, double voltage) const override;
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "capacitor_compiled.h"
+
+// Allowed current over [f_begin, f_end] of one limit of one node: coefficient * f^exponent. With the
+// node values of CurrentDriveResponse, a current limit gives a constant (exponent 0), a voltage limit a
+// line (1) and a power limit a square root (0.5).
+struct EnvelopePiece
+{
+    double f_begin;
+    double f_end;
+    uint32_t node;
+    ViolationKind limit;
+    double coefficient;
+    double exponent;
+};
+
+// Largest tank current that keeps every node within its current, voltage and power limits, as a function
+// of the frequency over a range: the lower envelope of the limits of all nodes, reduced once from the tank.
+// Pieces are contiguous, in frequency order, and change where the limiting node or limit changes.
+class AllowedCurrentEnvelope
+{
+    std::vector<EnvelopePiece> _pieces;
+
+public:
+    AllowedCurrentEnvelope() = default;
+    AllowedCurrentEnvelope(const CompiledTank &tank, double f_min, double f_max);
+
+    const std::vector<EnvelopePiece> &pieces() const { return _pieces; }
+    double f_min() const { return _pieces.front().f_begin; }
+    double f_max() const { return _pieces.back().f_end; }
+
+    // Piece covering f, found by binary search. Throws std::invalid_argument outside [f_min, f_max].
+    const EnvelopePiece &piece(double f) const;
+
+    // Allowed current at f.
+    double operator()(double f) const;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "capacitor_compiled.h"
+
+struct FaultOptions
+{
+    double current = 0.0;
+    double frequency = 0.0;
+};
+
+// Highest stress of one kind over the surviving nodes: value / limit, above 1 when the limit is exceeded.
+struct StressPeak
+{
+    uint32_t node = CompiledTank::no_parent;
+    double utilization = 0.0;
+};
+
+// One part failed open. The part takes its enclosing series groups with it, and a parallel group whose
+// last member fails opens too. The surviving members of the group where the current has another path
+// take over the current; group limits are re-aggregated without the failed members.
+struct FaultScenario
+{
+    uint32_t part;            // failed part, CompiledTank node id
+    bool tank_open = false;   // no path left for the current
+    StressPeak current;
+    StressPeak voltage;
+    StressPeak power;
+
+    bool violates() const
+    {
+        return tank_open || current.utilization > 1 || voltage.utilization > 1 || power.utilization > 1;
+    }
+};
+
+struct FaultAnalysisResult
+{
+    StressPeak current; // of the intact tank
+    StressPeak voltage;
+    StressPeak power;
+    std::vector<FaultScenario> scenarios; // one per part, in node order
+};
+
+// Evaluates every single-part open-circuit scenario of the tank driven by options.current at
+// options.frequency (CompiledTankEvaluator::voltage). The intact tank is evaluated once. Each group keeps
+// prefix and suffix aggregates of its members' reactance terms, limits and subtree stress peaks, so a
+// scenario only recomputes the groups on the path from the failure to the root: O(parts * depth) in all
+// instead of one rebuild and evaluation per part.
+FaultAnalysisResult run_fault_analysis(const CompiledTank &tank, const FaultOptions &options);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath>
+
+// Formulas shared by the composite classes and the compiled evaluators. T is double for the reference
+// model and any type with the arithmetic operators of double, such as float, Interval or Lanes, for the
+// other analyses. Every formula is written once here, so the evaluation code is the same whatever T is.
+// Constants are converted to T first, so a float evaluation stays in float.
+
+// Reactance of a capacitor at f.
+template <typename T>
+constexpr T capacitor_xc(const T &f, const T &cap_F)
+{
+    return T(1) / (T(2 * M_PI) * f * cap_F);
+}
+
+// Current through a reactance under a voltage.
+template <typename T>
+constexpr T reactance_current(const T &voltage, const T &xc)
+{
+    return voltage / xc;
+}
+
+// Voltage across a reactance carrying a current.
+template <typename T>
+constexpr T reactance_voltage(const T &current, const T &xc)
+{
+    return current * xc;
+}
+
+// Current that puts v_max across a reactance.
+template <typename T>
+constexpr T reactance_allowed_current(const T &v_max, const T &xc)
+{
+    return v_max / xc;
+}
+
+// Term a member adds to the reciprocal reactance of its parallel group, and the group reactance from the sum.
+template <typename T>
+constexpr T admittance(const T &xc)
+{
+    return T(1.0) / xc;
+}
+
+// a when it is smaller than b, else b, as std::min_element keeps the first smallest.
+constexpr double smaller(double a, double b)
+{
+    return a < b ? a : b;
+}
+
+// Upper bound of a value, to compare it against a limit.
+constexpr double upper(double value)
+{
+    return value;
+}
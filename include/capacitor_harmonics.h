@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "capacitor_compiled.h"
+
+// One harmonic of the tank current: frequency in Hz and RMS current in A.
+struct Harmonic
+{
+    double frequency;
+    double current;
+};
+
+// Evaluates the tank driven by a current made of several harmonics. Every harmonic reaches the nodes
+// through the same CurrentDriveResponse, so a spectrum reduces to three sums over the harmonics: sum(I^2),
+// sum((I/f)^2) and sum(I^2/f), computed several harmonics per instruction. The node RMS current, RMS
+// voltage and reactive power (the sum over harmonics of current times voltage) follow in one pass over
+// the nodes. The response is computed once at construction.
+class HarmonicEvaluator
+{
+    const CompiledTank &tank;
+    CurrentDriveResponse _response;
+    std::vector<double> _current;
+    std::vector<double> _voltage;
+    std::vector<double> _reactive_power;
+
+public:
+    explicit HarmonicEvaluator(const CompiledTank &tank);
+
+    // Evaluates the spectrum and returns the tank RMS current. Throws std::invalid_argument, keeping the
+    // last results, when a harmonic frequency is not positive.
+    double evaluate(const Harmonic *harmonics, size_t count);
+    double evaluate(const std::vector<Harmonic> &harmonics) { return evaluate(harmonics.data(), harmonics.size()); }
+
+    // Records every node whose RMS current, RMS voltage or reactive power of the last spectrum exceeds
+    // its current, voltage or power limit, in node order. Does not allocate.
+    void check_limits(ViolationReport &report) const;
+
+    // Largest tank RMS current of a spectrum of the same shape as the last one within every limit; 0 before
+    // the first evaluation and after a spectrum without current.
+    double allowed_current() const;
+
+    const std::vector<double> &node_current() const { return _current; }
+    const std::vector<double> &node_voltage() const { return _voltage; }
+    const std::vector<double> &node_reactive_power() const { return _reactive_power; }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "capacitor_formulas.h"
+
+// Closed interval [lo, hi] of reals. Every operation rounds its bounds outwards by one unit in the last
+// place, so the result contains the exact result for every point of the operands, and also the double
+// result of the same operations on any points of the operands.
+struct Interval
+{
+    double lo;
+    double hi;
+
+    Interval(double value = 0.0) : lo(value), hi(value) {}
+    Interval(double lo, double hi) : lo(lo), hi(hi) {}
+
+    // value * (1 - tolerance) to value * (1 + tolerance), for a positive value.
+    static Interval around(double value, double tolerance)
+    {
+        return outward(value * (1 - tolerance), value * (1 + tolerance));
+    }
+
+    static Interval outward(double lo, double hi)
+    {
+        return {std::nextafter(lo, -HUGE_VAL), std::nextafter(hi, HUGE_VAL)};
+    }
+
+    bool contains(double value) const { return lo <= value && value <= hi; }
+    double width() const { return hi - lo; }
+
+    Interval &operator+=(const Interval &other) { return *this = outward(lo + other.lo, hi + other.hi); }
+};
+
+inline Interval operator+(const Interval &a, const Interval &b)
+{
+    return Interval::outward(a.lo + b.lo, a.hi + b.hi);
+}
+
+inline Interval operator-(const Interval &a, const Interval &b)
+{
+    return Interval::outward(a.lo - b.hi, a.hi - b.lo);
+}
+
+inline Interval operator*(const Interval &a, const Interval &b)
+{
+    double products[] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+    return Interval::outward(*std::min_element(products, products + 4), *std::max_element(products, products + 4));
+}
+
+inline Interval operator/(const Interval &a, const Interval &b)
+{
+    if (b.lo <= 0.0 && b.hi >= 0.0)
+    {
+        return {-HUGE_VAL, HUGE_VAL};
+    }
+    double quotients[] = {a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi};
+    return Interval::outward(*std::min_element(quotients, quotients + 4), *std::max_element(quotients, quotients + 4));
+}
+
+inline bool operator==(const Interval &a, const Interval &b)
+{
+    return a.lo == b.lo && a.hi == b.hi;
+}
+
+inline bool operator!=(const Interval &a, const Interval &b)
+{
+    return !(a == b);
+}
+
+// Bounds of min(a, b) over the points of a and b, the interval counterpart of the std::min_element choice.
+inline Interval smaller(const Interval &a, const Interval &b)
+{
+    return {std::min(a.lo, b.lo), std::min(a.hi, b.hi)};
+}
+
+inline double upper(const Interval &value)
+{
+    return value.hi;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class KernelIsa {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Capacitor formulas over contiguous arrays, one set per instruction set. The element-wise kernels perform
+// the same IEEE operations as the CapacitorBase methods and give bit-identical results; the sums add
+// several lanes at once, so they differ from the group xc() only by rounding.
+struct CapacitorKernels
+{
+    KernelIsa isa;
+
+    // xc[k] = 1 / (2 * pi * f[k] * cap_F[k]), as CapacitorBase::xc.
+    void (*xc)(const double *f, const double *cap_F, double *xc, size_t n);
+
+    // 1 / sum(1 / xc[k]), as ParallelCapacitor::xc over members with these reactances.
+    double (*parallel_xc)(const double *xc, size_t n);
+
+    // sum(xc[k]), as SeriesCapacitor::xc over members with these reactances.
+    double (*series_xc)(const double *xc, size_t n);
+
+    // current[k] = voltage[k] / xc[k], as CapacitorBase::current, and power[k] = current[k] * voltage[k].
+    void (*current)(const double *voltage, const double *xc, double *current, double *power, size_t n);
+
+    // voltage[k] = current[k] * xc[k], as CapacitorBase::voltage, and power[k] = current[k] * voltage[k].
+    void (*voltage)(const double *current, const double *xc, double *voltage, double *power, size_t n);
+
+    // exceeded[k] = value[k] > limit[k], as the violation checks. Returns the number of exceeded limits.
+    size_t (*exceeds)(const double *value, const double *limit, uint8_t *exceeded, size_t n);
+};
+
+// Kernels of the widest instruction set the CPU supports, selected on the first call.
+const CapacitorKernels &capacitor_kernels();
+
+// Kernels of one instruction set, nullptr when the CPU or the build does not support it.
+const CapacitorKernels *capacitor_kernels(KernelIsa isa);
+
+const char *kernel_isa_name(KernelIsa isa);
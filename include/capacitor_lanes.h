@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// N independent values of T in one vector register (or several, when the build targets narrower vectors),
+// with the arithmetic operators of T applied lane by lane. Each lane rounds exactly like T, so an
+// evaluation over Lanes gives, in every lane, the bit-identical result of the same evaluation over T.
+// Comparisons summarise the lanes: == holds when every lane is equal.
+template <typename T, size_t N>
+struct Lanes
+{
+    typedef T vec __attribute__((vector_size(N * sizeof(T))));
+    static constexpr size_t size = N;
+
+    vec v;
+
+    Lanes(double value = 0.0) : v(vec{} + static_cast<T>(value)) {}
+
+    // By reference: a vector wider than the build's registers passed by value has no stable ABI (-Wpsabi).
+    static Lanes from(const vec &v)
+    {
+        Lanes lanes;
+        lanes.v = v;
+        return lanes;
+    }
+
+    static Lanes load(const T *p)
+    {
+        Lanes lanes;
+        std::memcpy(&lanes.v, p, sizeof(vec));
+        return lanes;
+    }
+
+    void store(T *p) const { std::memcpy(p, &v, sizeof(vec)); }
+
+    T operator[](size_t lane) const { return v[lane]; }
+};
+
+template <typename T, size_t N>
+Lanes<T, N> operator+(const Lanes<T, N> &a, const Lanes<T, N> &b)
+{
+    return Lanes<T, N>::from(a.v + b.v);
+}
+
+template <typename T, size_t N>
+Lanes<T, N> operator-(const Lanes<T, N> &a, const Lanes<T, N> &b)
+{
+    return Lanes<T, N>::from(a.v - b.v);
+}
+
+template <typename T, size_t N>
+Lanes<T, N> operator*(const Lanes<T, N> &a, const Lanes<T, N> &b)
+{
+    return Lanes<T, N>::from(a.v * b.v);
+}
+
+template <typename T, size_t N>
+Lanes<T, N> operator/(const Lanes<T, N> &a, const Lanes<T, N> &b)
+{
+    return Lanes<T, N>::from(a.v / b.v);
+}
+
+template <typename T, size_t N>
+bool operator==(const Lanes<T, N> &a, const Lanes<T, N> &b)
+{
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+        if (a.v[lane] != b.v[lane])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T, size_t N>
+bool operator!=(const Lanes<T, N> &a, const Lanes<T, N> &b)
+{
+    return !(a == b);
+}
+
+// smaller() of every lane.
+template <typename T, size_t N>
+Lanes<T, N> smaller(const Lanes<T, N> &a, const Lanes<T, N> &b)
+{
+    Lanes<T, N> result;
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+        result.v[lane] = a.v[lane] < b.v[lane] ? a.v[lane] : b.v[lane];
+    }
+    return result;
+}
+
+// Largest lane, so a limit check reports a node when any lane exceeds its limit.
+template <typename T, size_t N>
+double upper(const Lanes<T, N> &value)
+{
+    double largest = value.v[0];
+    for (size_t lane = 1; lane < N; ++lane)
+    {
+        largest = value.v[lane] > largest ? value.v[lane] : largest;
+    }
+    return largest;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "capacitor_compiled.h"
+#include "capacitor_server.h"
+#include "capacitor_violation_report.h"
+
+// One telemetry update, the measured RMS tank current in A at a frequency in Hz. Also the record of the
+// binary feeds, in host byte order.
+struct TelemetrySample
+{
+    float current;
+    float frequency;
+};
+
+struct MonitorOptions
+{
+    double hysteresis = 0.05;   // relative; a raised limit clears below limit * (1 - hysteresis)
+    uint32_t debounce = 3;      // consecutive updates beyond the threshold before a limit is raised or cleared
+};
+
+// A limit of a node raised or cleared by an update, with the value and limit at that update.
+struct MonitorEvent
+{
+    uint64_t update;
+    bool raised;
+    Violation violation;
+};
+
+// Evaluates telemetry updates against the current, voltage and power limits of every node of a compiled
+// tank and turns them into debounced raise and clear events. The node values are the CurrentDriveResponse
+// of the tank scaled by the update, so an update costs a few multiplications per node. The state and the
+// event buffer are allocated at construction; update() never allocates.
+class TankMonitor
+{
+    const CompiledTank &tank;
+    MonitorOptions options;
+    CurrentDriveResponse _response;
+    std::vector<uint8_t> _active;
+    std::vector<uint32_t> _count;
+    std::vector<MonitorEvent> _events;
+    size_t _event_count = 0;
+    uint64_t _updates = 0;
+    uint64_t _invalid = 0;
+
+    void _check(uint32_t node, ViolationKind kind, double value, double limit) noexcept;
+
+public:
+    // Throws std::invalid_argument for a hysteresis outside [0, 1) or a debounce of 0.
+    TankMonitor(const CompiledTank &tank, const MonitorOptions &options);
+
+    // Evaluates one update and returns the number of events it raised or cleared. An update without a
+    // positive finite frequency is only counted as invalid.
+    size_t update(const TelemetrySample &sample) noexcept;
+
+    // Events of the last update.
+    const MonitorEvent *begin() const { return _events.data(); }
+    const MonitorEvent *end() const { return _events.data() + _event_count; }
+
+    uint64_t updates() const { return _updates; }
+    uint64_t invalid_updates() const { return _invalid; }
+    bool raised(uint32_t node, ViolationKind kind) const { return _active[3 * node + static_cast<size_t>(kind)] != 0; }
+};
+
+// Single-producer single-consumer ring of telemetry samples in POSIX shared memory, for a producer in
+// another process. The consumer creates the ring and removes it when destroyed; the producer opens it by
+// name, pushes samples and closes it when done.
+class TelemetryRing
+{
+    struct Header
+    {
+        alignas(64) std::atomic<uint64_t> head;     // written by the producer
+        alignas(64) std::atomic<uint64_t> tail;     // written by the consumer
+        alignas(64) std::atomic<uint32_t> closed;
+        std::atomic<uint32_t> magic;                // released by the creator after capacity
+        uint64_t capacity;
+    };
+
+    std::string _name;
+    bool _owner = false;
+    Header *_header = nullptr;
+    TelemetrySample *_samples = nullptr;
+    size_t _mapped = 0;
+    uint64_t _mask = 0;
+
+    void _map(int fd, size_t size);
+
+public:
+    // Creates the ring (a name like "/tank", capacity a power of two), replacing a stale one.
+    // Throws std::invalid_argument for the capacity and std::runtime_error when the memory cannot be set up.
+    TelemetryRing(const std::string &name, size_t capacity);
+    // Opens a ring created by the consumer. Throws std::runtime_error when there is none.
+    explicit TelemetryRing(const std::string &name);
+    ~TelemetryRing();
+    TelemetryRing(const TelemetryRing &) = delete;
+    TelemetryRing &operator=(const TelemetryRing &) = delete;
+
+    // Producer side. push() returns false when the ring is full.
+    bool push(const TelemetrySample &sample) noexcept;
+    void close() noexcept;
+
+    // Consumer side. Moves up to count samples into out and returns how many.
+    size_t pop(TelemetrySample *out, size_t count) noexcept;
+    bool closed() const noexcept;
+};
+
+struct MonitorStats
+{
+    uint64_t updates = 0;
+    uint64_t events = 0;
+    // Time from taking an update off the feed to its events handled.
+    LatencyHistogram latency;
+};
+
+using MonitorEventCallback = std::function<void(const MonitorEvent &event)>;
+
+// Runs the monitor over a binary TelemetrySample stream on a file descriptor (a pipe, a FIFO or a file)
+// until end of file. Updates are evaluated as soon as read() returns them, not when a buffer is full.
+MonitorStats run_monitor(TankMonitor &monitor, int fd, const MonitorEventCallback &on_event);
+
+// Runs the monitor over the ring, polling it, until the producer has closed it and it is empty.
+MonitorStats run_monitor(TankMonitor &monitor, TelemetryRing &ring, const MonitorEventCallback &on_event);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "capacitor_compiled.h"
+
+enum class ToleranceDistribution {
+    Uniform, // factor uniform in [1 - spread, 1 + spread]
+    Normal   // factor normal with mean 1 and standard deviation spread
+};
+
+struct Tolerance
+{
+    ToleranceDistribution distribution = ToleranceDistribution::Uniform;
+    double spread = 0.0;
+};
+
+struct MonteCarloOptions
+{
+    double current = 0.0;
+    double frequency = 0.0;
+    uint64_t samples = 100000;
+    uint64_t seed = 1;
+    // Relative spread of the capacitance of every part.
+    Tolerance capacitance{ToleranceDistribution::Uniform, 0.05};
+    // Relative spread of the voltage, current and power limits of every part, one factor per limit.
+    Tolerance limits;
+    size_t threads = 0; // 0 uses every hardware thread
+};
+
+// Distribution of one node over the samples. Percentiles come from a histogram of the current relative to
+// the nominal current, with bins 0.3% wide between a quarter and four times the nominal current, and are
+// kept within the smallest and largest current of the samples.
+struct NodeStatistics
+{
+    std::string name;
+    double nominal_current;
+    double current_p50;
+    double current_p95;
+    double current_p99;
+    double current_max;
+    double overcurrent_probability;
+    double overvoltage_probability;
+    double overpower_probability;
+    double violation_probability; // any of the three
+};
+
+struct MonteCarloResult
+{
+    uint64_t samples = 0;
+    std::vector<NodeStatistics> nodes; // CompiledTank node order
+    double violation_probability = 0.0; // any node violating a limit
+};
+
+// Philox4x32-10 counter-based generator: the same counter and key always give the same four words.
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+// Evaluates options.samples copies of the tank, each part perturbed by its own random factors, with the
+// tank driven by options.current at options.frequency (CompiledTankEvaluator::voltage). The random
+// numbers of a part in a sample depend only on the seed, the sample and the node, and the statistics
+// are integer counts, so results do not depend on the number of threads. Samples are evaluated in
+// blocks, node by node over the whole block, with scratch memory allocated once per thread.
+MonteCarloResult run_monte_carlo(const CompiledTank &tank, const MonteCarloOptions &options);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "capacitors.h"
+#include "capacitor_tank.h"
+
+using json = nlohmann::json;
+
+// Capacitor tank of any series/parallel topology, described by a netlist over the specification catalog
+// and built from the composite classes. The netlist owns every node; a part or group repeated with `*n`
+// is the same object listed n times in its group, so wide banks stay small. Parsing, building and
+// destruction are iterative, and CompiledTank(root()) evaluates trees of any depth in linear time.
+//
+// Text grammar, whitespace and `#` comments to the end of the line are ignored:
+//   node  := item ['*' count]
+//   item  := part-name | ('series' | 'parallel') ['[' group-name ']'] '(' node {',' node} ')'
+// e.g. `series[serial](parallel[parallel1](23uF_500V, 1uF_1000V), parallel[parallel2](1uF_1000V*4))`
+//
+// JSON form: a node is a part name, {"part": name, "count": n} or {"series" | "parallel": [nodes],
+// "name": group-name, "count": n}, "name" and "count" being optional.
+//
+// Malformed netlists, and netlists expanding to more nodes than a tank can be compiled with, throw
+// std::invalid_argument, with the character offset for the text grammar.
+class TankNetlist
+{
+    std::deque<Capacitor> _capacitors;
+    std::deque<ParallelCapacitor> _parallel;
+    std::deque<SeriesCapacitor> _series;
+    const CapacitorInterface *_root = nullptr;
+
+    friend class NetlistBuilder;
+
+public:
+    TankNetlist() = default;
+    TankNetlist(TankNetlist &&) = default;
+    TankNetlist &operator=(TankNetlist &&) = default;
+    TankNetlist(const TankNetlist &) = delete;
+    TankNetlist &operator=(const TankNetlist &) = delete;
+
+    const CapacitorInterface &root() const { return *_root; }
+    // Distinct node objects; the tree itself can list repeated nodes many times.
+    size_t objects() const { return _capacitors.size() + _parallel.size() + _series.size(); }
+};
+
+TankNetlist parse_netlist_text(const std::string &text, const std::vector<CapacitorSpecification> &catalog);
+TankNetlist parse_netlist_json(const json &netlist, const std::vector<CapacitorSpecification> &catalog);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Node store of a composition. Nodes live in chunks of ChunkSize that are neither moved nor freed before
+// the pool, so a node keeps its address for the lifetime of the pool however much it grows. reset() only
+// rewinds the pool: the nodes stay constructed and are handed out again by next(), to be reinitialised in
+// place by the next composition. Once a composition of the same size has been built, no memory is allocated.
+template <typename T, size_t ChunkSize = 32>
+class NodePool
+{
+    std::vector<std::unique_ptr<T[]>> _chunks;
+    size_t _size = 0;
+
+public:
+    NodePool() = default;
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+
+    // The next node, default constructed the first time the pool reaches it, as its previous use left it
+    // after a reset().
+    T &next()
+    {
+        if (_size == capacity())
+        {
+            _chunks.emplace_back(new T[ChunkSize]);
+        }
+        T &node = _chunks[_size / ChunkSize][_size % ChunkSize];
+        ++_size;
+        return node;
+    }
+
+    // Hands the nodes out again from the first one, in O(1).
+    void reset() { _size = 0; }
+
+    T &operator[](size_t k) { return _chunks[k / ChunkSize][k % ChunkSize]; }
+    const T &operator[](size_t k) const { return _chunks[k / ChunkSize][k % ChunkSize]; }
+
+    // Nodes handed out since the last reset().
+    size_t size() const { return _size; }
+    // Nodes constructed so far.
+    size_t capacity() const { return _chunks.size() * ChunkSize; }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct CapacitorSpecification;
+class CapacitorCatalog;
+
+// Dense id of a catalog part, its position in PartIndex.
+using PartId = uint32_t;
+constexpr PartId no_part = UINT32_MAX;
+
+// Catalog part names interned once into dense ids, in catalog order, with the specs in columns. A name
+// listed more than once keeps the id of its first listing and the specs of its last, like a map filled in
+// catalog order. Names are hashed only by find(), where they enter; composition works on ids.
+//
+// An index of a binary catalog keeps the catalog mapped and views its names in place: the ids are the
+// catalog positions and find() is the catalog's binary search, which returns the last listing of a name.
+class PartIndex
+{
+    std::shared_ptr<const CapacitorCatalog> _catalog;
+    std::vector<std::string> _owned_names;
+    std::unordered_map<std::string_view, PartId> _ids;
+    std::vector<std::string_view> _names;
+    std::vector<double> _cap_uF;
+    std::vector<double> _v_max;
+    std::vector<double> _i_max;
+    std::vector<double> _power_max;
+
+public:
+    explicit PartIndex(const std::vector<CapacitorSpecification> &specs);
+    explicit PartIndex(std::shared_ptr<const CapacitorCatalog> catalog);
+
+    size_t size() const { return _names.size(); }
+    // Id of the named part, or no_part.
+    PartId find(std::string_view name) const;
+
+    std::string_view name(PartId part) const { return _names[part]; }
+    double cap_uF(PartId part) const { return _cap_uF[part]; }
+    double v_max(PartId part) const { return _v_max[part]; }
+    double i_max(PartId part) const { return _i_max[part]; }
+    double power_max(PartId part) const { return _power_max[part]; }
+};
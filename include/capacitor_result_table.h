@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "capacitor_string_recycler.h"
+#include "capacitor_violation_report.h"
+
+// One evaluated node, name indexes TankResultTable::names.
+struct NodeResult
+{
+    uint32_t name;
+    double current;
+    double voltage;
+    double power;
+};
+
+// Per-node results of an evaluation, rows in the order the nodes finished (members before their group).
+// The calculation code only fills it, the renderers below turn it into text.
+struct TankResultTable
+{
+    std::vector<std::string> names;
+    std::vector<NodeResult> rows;
+    StringRecycler recycled_names;
+
+    // Index of name in names, added on first use.
+    uint32_t name_id(const std::string &name);
+
+    // Empties names and rows, keeping the name strings for the next name_id() calls.
+    void clear()
+    {
+        recycled_names.clear(names);
+        rows.clear();
+    }
+
+    void add(uint32_t name, double current, double voltage)
+    {
+        rows.push_back({name, current, voltage, current * voltage});
+    }
+};
+
+// The classic console output. Violations, with node ids being row indices, follow the row of their node.
+void render_console(std::ostream &os, const TankResultTable &table, const ViolationReport *violations = nullptr);
+
+// One "name,current,voltage,power" line per row after a header line.
+void render_csv(std::ostream &os, const TankResultTable &table);
+
+// {"nodes": [{"name", "current", "voltage", "power"}...], "violations": [{"node", "kind", "value", "limit"}...]}
+void render_json(std::ostream &os, const TankResultTable &table, const ViolationReport *violations = nullptr);
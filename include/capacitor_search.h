@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "capacitors.h"
+#include "capacitor_tank.h"
+
+// Number of capacitors allowed in a group (CON-01, CON-02).
+constexpr size_t min_group_capacitors = 1;
+constexpr size_t max_group_capacitors = 5;
+
+struct DesignSearchOptions
+{
+    float current;      // target RMS current through the tank
+    float frequency;
+    size_t max_group_size = max_group_capacitors;
+    size_t top = 10;    // number of ranked designs to return
+    size_t threads = 0; // 0 uses every hardware thread
+};
+
+struct TankDesign
+{
+    std::vector<std::string> group1;
+    std::vector<std::string> group2;
+    double rated_current;
+    double margin; // rated_current - target current
+};
+
+struct DesignSearchResult
+{
+    std::vector<TankDesign> designs; // best first
+    uint64_t evaluated_groups = 0;
+    uint64_t pruned_branches = 0;
+};
+
+// Rated current of a parallel group: the largest RMS current it carries without exceeding the aggregated
+// limits of its spec, voltage v_max at 1/(2*pi*f*C), current i_max and reactive power power_max. Not the
+// allowed_current of the capacitors, which only checks the voltage limit.
+double parallel_group_rated_current(const CapacitorSpec &group_spec, double frequency);
+
+// Ranks every tank of two parallel groups with 1..max_group_size catalog parts each that carries the
+// target current, by rated current margin. Groups are enumerated as multisets and branches whose
+// upper bound on the rated current cannot reach the ranking are pruned. Runs on a ThreadPool.
+DesignSearchResult search_tank_designs(const std::vector<CapacitorSpecification> &catalog, const DesignSearchOptions &options);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "capacitor_compiled.h"
+
+struct SensitivityOptions
+{
+    double current = 0.0;
+    double frequency = 0.0;
+};
+
+// Dense Jacobian of the node stress with respect to the parts and the frequency, row-major in one buffer.
+// Rows: current, voltage and power of node n at 3 * n, 3 * n + 1 and 3 * n + 2 (CompiledTank node
+// order), then the allowed current of the tank. Columns: the capacitance in uF of every part, in node
+// order, then the frequency in Hz.
+struct SensitivityResult
+{
+    std::vector<uint32_t> parts; // node id of each capacitance column
+    size_t rows = 0;
+    size_t columns = 0;
+    std::vector<double> jacobian;
+    std::vector<double> values; // the value of every row
+
+    size_t current_row(uint32_t node) const { return 3 * node; }
+    size_t voltage_row(uint32_t node) const { return 3 * node + 1; }
+    size_t power_row(uint32_t node) const { return 3 * node + 2; }
+    size_t allowed_current_row() const { return rows - 1; }
+    size_t frequency_column() const { return columns - 1; }
+
+    double at(size_t row, size_t column) const { return jacobian[row * columns + column]; }
+};
+
+// Evaluates the tank driven by options.current at options.frequency (CompiledTankEvaluator::voltage) in
+// forward-mode dual numbers, which carry the derivatives with respect to sensitivity_width parameters
+// through one evaluation. Tanks with more parts take one evaluation per sensitivity_width parameters.
+constexpr size_t sensitivity_width = 16;
+SensitivityResult run_sensitivity(const CompiledTank &tank, const SensitivityOptions &options);
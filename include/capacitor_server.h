@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "capacitor_tank.h"
+#include "capacitor_violation_report.h"
+
+// Framed protocol of the calculation daemon. Every message is a uint32 payload length followed by the payload,
+// all numbers in host byte order (the socket is local). A request payload starts with a ServerOp byte, a
+// response payload with a ServerStatus byte; an error response carries the message text after the status.
+//
+//   Compose         u8 group1 count, u8 group2 count, then per part u8 name length + name -> u32 tank id.
+//                   Only the most recently composed tanks are kept: the id of an evicted tank is unknown
+//                   to the other requests and the client composes the groups again.
+//   Evaluate        u32 tank id, f64 current, f64 frequency -> f64 tank current, f64 allowed current,
+//                   u32 violation count, then per violation u32 node, u8 kind, f64 value, f64 limit
+//   AllowedCurrent  u32 tank id, f64 frequency -> f64 allowed current
+//   Stats           -> u64 requests, u32 cached tanks, u64 p50, p90, p99, p999 and max latency in ns
+enum class ServerOp : uint8_t {
+    Compose = 1,
+    Evaluate = 2,
+    AllowedCurrent = 3,
+    Stats = 4
+};
+
+enum class ServerStatus : uint8_t {
+    Ok = 0,
+    Error = 1
+};
+
+// Largest accepted payload; longer frames close the connection.
+constexpr uint32_t max_frame_payload = 1 << 16;
+
+// Response bytes a client may leave unread before the server stops reading its requests.
+constexpr size_t max_pending_output = 1 << 20;
+
+// Composed tanks kept by default.
+constexpr size_t default_cached_tanks = 1024;
+
+// Request latency histogram with 8 linear sub-buckets per power of two, so percentiles are within 12.5%.
+class LatencyHistogram
+{
+    static constexpr size_t linear_buckets = 16;
+    static constexpr size_t sub_buckets = 8;
+    std::array<uint64_t, linear_buckets + 60 * sub_buckets> _buckets{};
+    uint64_t _count = 0;
+    uint64_t _max = 0;
+
+    static size_t _bucket(uint64_t ns);
+    static uint64_t _bucket_upper(size_t bucket);
+
+public:
+    void record(uint64_t ns);
+    uint64_t count() const { return _count; }
+    uint64_t max() const { return _max; }
+    // Upper bound in ns of the bucket holding the q-quantile, 0 < q <= 1.
+    uint64_t percentile(double q) const;
+};
+
+// Answers protocol requests against a catalog loaded once. Composed tanks are cached by their group signature
+// of part ids, so a client composing the same groups again gets the same tank id without a new composition.
+// The cache holds the last max_tanks tanks; the oldest is evicted and its calculator recomposed in place.
+class TankServer
+{
+    // Interned once and shared by every composed tank.
+    std::shared_ptr<const PartIndex> parts;
+    size_t max_tanks;
+    // Tank id k lives in slot k % max_tanks while it is one of the last max_tanks composed.
+    std::vector<std::unique_ptr<TankCalculator>> tanks;
+    std::vector<std::string> signatures;
+    std::unordered_map<std::string, uint32_t> tank_ids;
+    uint32_t next_id = 0;
+    ViolationReport report;
+    LatencyHistogram latency;
+
+    void _compose(const uint8_t *request, size_t size, std::vector<uint8_t> &response);
+    void _evaluate(const uint8_t *request, size_t size, std::vector<uint8_t> &response);
+    void _allowed_current(const uint8_t *request, size_t size, std::vector<uint8_t> &response);
+    void _stats(std::vector<uint8_t> &response) const;
+    TankCalculator *_tank(const uint8_t *request, size_t size, std::vector<uint8_t> &response);
+
+public:
+    explicit TankServer(const std::vector<CapacitorSpecification> &catalog, size_t max_tanks = default_cached_tanks);
+    explicit TankServer(std::shared_ptr<const PartIndex> parts, size_t max_tanks = default_cached_tanks);
+
+    // Replaces response with the answer to one request payload and records the time spent in the histogram.
+    void handle(const uint8_t *request, size_t size, std::vector<uint8_t> &response);
+
+    size_t cached_tanks() const { return tanks.size(); }
+    const LatencyHistogram &request_latency() const { return latency; }
+};
+
+// Buffers the byte stream of one client and answers every complete frame in it. Responses are sent without
+// blocking; what the socket does not take is kept until it is writable again.
+class ServerConnection
+{
+    int fd;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    std::vector<uint8_t> response;
+
+    bool _flush();
+
+public:
+    explicit ServerConnection(int fd) : fd(fd) {}
+
+    // Reads what is available on the socket and sends the responses. Returns false once the client has
+    // closed the connection or sent an invalid frame.
+    bool on_readable(TankServer &server);
+    // Sends the pending responses. Returns false once the client has closed the connection.
+    bool on_writable() { return _flush(); }
+
+    size_t pending_output() const { return output.size(); }
+};
+
+// Listens on the Unix socket path, replacing a stale socket file, and serves clients until the process is
+// stopped. Throws std::runtime_error when the socket cannot be set up or waiting for clients fails.
+void serve_unix_socket(TankServer &server, const std::string &path);
+
+// Client side helpers, used by the tests and by tools talking to the daemon.
+std::vector<uint8_t> encode_compose_request(const std::vector<std::string> &group1, const std::vector<std::string> &group2);
+std::vector<uint8_t> encode_evaluate_request(uint32_t tank, double current, double frequency);
+std::vector<uint8_t> encode_allowed_current_request(uint32_t tank, double frequency);
+std::vector<uint8_t> encode_stats_request();
+bool write_frame(int fd, const std::vector<uint8_t> &payload);
+bool read_frame(int fd, std::vector<uint8_t> &payload);
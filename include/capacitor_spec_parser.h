@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "capacitor_tank.h"
+
+// Parses a JSON catalog, an array of {"name", "capacitance", "voltage", "current", "power"} objects (other
+// members are skipped), straight into specifications with the SAX interface of nlohmann::json instead of
+// building a document, so memory stays proportional to the text and the result. threads != 1 splits a
+// large catalog at record boundaries and parses the parts in parallel, threads == 0 using every hardware
+// thread; the result is the same. Throws std::invalid_argument with the byte offset of the first error in
+// the text.
+std::vector<CapacitorSpecification> parse_capacitor_specifications_text(std::string_view text, size_t threads = 1);
+
+// Parses a JSON catalog file in place from a read-only mapping; a file that cannot be mapped, such as a
+// pipe, is read first. Throws std::runtime_error when the file cannot be opened or read, and
+// std::invalid_argument like parse_capacitor_specifications_text.
+std::vector<CapacitorSpecification> parse_capacitor_specifications_json_file(const std::string &path, size_t threads = 0);
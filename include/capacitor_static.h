@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+
+#include "capacitors.h"
+#include "capacitor_formulas.h"
+
+// Tank topologies fixed at compile time, e.g. Series<Parallel<Cap<A>, Cap<B>>, Parallel<Cap<C>>>, for
+// products whose parts never change. The aggregated specs are constexpr and computed like the
+// ParallelCapacitor/SeriesCapacitor constructors; the static methods compute like the CapacitorInterface
+// methods of the same tree, so results are bit-identical, but without composition or virtual calls they
+// inline into straight-line code.
+//
+// A part is a type with constexpr cap_uF, v_max, i_max and power_max members:
+//     struct Part23uF { static constexpr double cap_uF = 23, v_max = 500, i_max = 1000, power_max = 500e3; };
+
+namespace static_tank_detail {
+
+// First smallest value, as std::min_element.
+constexpr double smallest(std::initializer_list<double> values)
+{
+    double result = *values.begin();
+    for (double value : values)
+    {
+        if (value < result)
+        {
+            result = value;
+        }
+    }
+    return result;
+}
+
+// The SeriesCapacitor::allowed_current loop over the member results.
+constexpr double series_allowed(std::initializer_list<double> values)
+{
+    double allowed = *values.begin();
+    for (const double *it = values.begin() + 1; it != values.end(); ++it)
+    {
+        allowed = smaller(*it, allowed);
+    }
+    return allowed;
+}
+
+} // namespace static_tank_detail
+
+template <typename Part>
+struct Cap
+{
+    static constexpr CapacitorKind kind = CapacitorKind::Single;
+    static constexpr size_t size = 1;
+    static constexpr CapacitorSpec spec{Part::cap_uF, Part::v_max, Part::i_max, Part::power_max};
+
+    static constexpr double xc(double f) { return capacitor_xc(f, spec.get_cap_F()); }
+    static constexpr double current(double f, double voltage) { return reactance_current(voltage, xc(f)); }
+    static constexpr double voltage(double f, double current) { return reactance_voltage(current, xc(f)); }
+    static constexpr double allowed_current(double f) { return reactance_allowed_current(spec.get_v_max(), xc(f)); }
+};
+
+template <typename... Members>
+struct Parallel
+{
+    static_assert(sizeof...(Members) > 0, "A parallel group needs at least one member.");
+
+    static constexpr CapacitorKind kind = CapacitorKind::Parallel;
+    static constexpr size_t size = (1 + ... + Members::size);
+    static constexpr CapacitorSpec spec{
+        (0.0 + ... + Members::spec.get_cap_uF()),
+        static_tank_detail::smallest({Members::spec.get_v_max()...}),
+        (0.0 + ... + Members::spec.get_i_max()),
+        (0.0 + ... + Members::spec.get_power_max())};
+
+    static constexpr double xc(double f) { return admittance((0.0 + ... + admittance(Members::xc(f)))); }
+    static constexpr double current(double f, double voltage) { return (0.0 + ... + Members::current(f, voltage)); }
+    static constexpr double voltage(double f, double current) { return reactance_voltage(current, xc(f)); }
+    static constexpr double allowed_current(double f) { return reactance_allowed_current(spec.get_v_max(), xc(f)); }
+};
+
+template <typename... Members>
+struct Series
+{
+    static_assert(sizeof...(Members) > 0, "A series group needs at least one member.");
+
+    static constexpr CapacitorKind kind = CapacitorKind::Series;
+    static constexpr size_t size = (1 + ... + Members::size);
+    static constexpr CapacitorSpec spec{
+        1.0 / (0.0 + ... + (1.0 / Members::spec.get_cap_uF())),
+        (0.0 + ... + Members::spec.get_v_max()),
+        static_tank_detail::smallest({Members::spec.get_i_max()...}),
+        (0.0 + ... + Members::spec.get_power_max())};
+
+    static constexpr double xc(double f) { return (0.0 + ... + Members::xc(f)); }
+    static constexpr double current(double f, double voltage) { return reactance_current(voltage, xc(f)); }
+    static constexpr double voltage(double f, double current) { return (0.0 + ... + Members::voltage(f, current)); }
+    static constexpr double allowed_current(double f)
+    {
+        return static_tank_detail::series_allowed({Members::allowed_current(f)...});
+    }
+};
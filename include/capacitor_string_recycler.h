@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Keeps the strings of a list that is emptied and rebuilt, such as the node names of a composition, and
+// appends into them again in the same order. A string assigned a value no longer than its capacity keeps
+// its buffer, so once every position has held its longest name, rebuilding the list does not allocate.
+class StringRecycler
+{
+    std::vector<std::string> _spare;
+
+public:
+    // Empties list, keeping its strings for the next push_back() calls, first string first.
+    void clear(std::vector<std::string> &list)
+    {
+        _spare.reserve(_spare.size() + list.size());
+        while (!list.empty())
+        {
+            _spare.push_back(std::move(list.back()));
+            list.pop_back();
+        }
+    }
+
+    // Appends value to list, in a kept string when there is one.
+    void push_back(std::vector<std::string> &list, const std::string &value)
+    {
+        if (_spare.empty())
+        {
+            list.push_back(value);
+            return;
+        }
+        list.push_back(std::move(_spare.back()));
+        _spare.pop_back();
+        list.back() = value;
+    }
+};
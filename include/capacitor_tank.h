@@ -1,8 +1,18 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <memory>
+#include <optional>
 #include <string>
 #include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_dump_value.h"
+#include "capacitor_envelope.h"
+#include "capacitor_node_pool.h"
+#include "capacitor_part_index.h"
+#include "capacitor_result_table.h"
+#include "capacitor_violation_check.h"
+#include "capacitor_violation_report.h"
 
 using json = nlohmann::json;
 
@@ -16,6 +26,34 @@ struct ProgramData
     std::vector<std::string> group1;
     std::vector<std::string> group2;
     std::string capacitor_spec_file;
+    bool search;
+    int top;
+    std::string format;
+    std::string batch;
+    std::string output;
+    std::string serve;
+    std::string netlist;
+    int monte_carlo;
+    float tolerance;
+    float limit_tolerance;
+    std::string distribution;
+    int seed;
+    bool worst_case;
+    float f_tolerance;
+    float i_tolerance;
+    bool sensitivity;
+    bool faults;
+    float envelope;
+    std::string spectrum;
+    std::string waveform;
+    float sample_rate;
+    int window;
+    float highpass;
+    std::string monitor;
+    std::string feed;
+    float hysteresis;
+    int debounce;
+    std::string write_catalog;
 };
 
 struct CapacitorSpecification
@@ -27,29 +65,96 @@ struct CapacitorSpecification
     float voltage;
 };
 
+// Per-node results of a frequency sweep, stored point-major: value[point * node_names.size() + node].
+// Nodes follow the console dump order: group 1 parts, parallel1, group 2 parts, parallel2, serial.
+template <typename T>
+struct BasicTankSweepResult
+{
+    std::vector<std::string> node_names;
+    std::vector<T> current;
+    std::vector<T> voltage;
+    std::vector<T> power;
+    std::vector<T> allowed_current;
+};
+
+using TankSweepResult = BasicTankSweepResult<double>;
+
 ProgramData get_commnad_line_params(int argc, char **argv);
+// Throws std::invalid_argument naming the first malformed record.
 std::vector<CapacitorSpecification> parse_capacitor_specifications(json& json_data);
 
 class TankCalculator
 {
-    ParallelCapacitor parallel1;
-    ParallelCapacitor parallel2;
-    
-    // Pointers are initialize during composition with the value of coresponding capacitors in parallel1 and parallel2. 
+    // A catalog part of the composition with the decorator recording its results.
+    struct PartNode
+    {
+        Capacitor part;
+        std::optional<CapacitoDumpValueDecorator> dump;
+    };
+
+    std::shared_ptr<const PartIndex> parts;
+
+    // Nodes of the composition, reinitialised in place by every composition so pointers between them stay
+    // valid and recomposing allocates nothing once the tank has been composed at its size.
+    NodePool<PartNode> part_nodes;
     std::vector<CapacitorInterface*> caps1;
     std::vector<CapacitorInterface*> caps2;
+    ParallelCapacitor parallel1;
+    ParallelCapacitor parallel2;
+
+    // Decorated serial(parallel1, parallel2) of calculate_capacitors_tank.
+    std::optional<CapacitoDumpValueDecorator> dump_parallel1;
+    std::optional<CapacitoDumpValueDecorator> dump_parallel2;
+    std::optional<CapacitorMaxViolationCheckDecorator> check_parallel1;
+    std::optional<CapacitorMaxViolationCheckDecorator> check_parallel2;
+    std::vector<CapacitorInterface*> chain;
+    SeriesCapacitor serial;
+    std::optional<CapacitoDumpValueDecorator> dump_serial;
+
+    // Flat form of serial(parallel1, parallel2), recompiled on every composition.
+    CompiledTank compiled_tank;
+    std::unique_ptr<CompiledTankEvaluator> evaluator;
 
-    // Pool of capacitor objects, created during Contrutor and initialized during composition.
-    std::vector<Capacitor> capacitors_group1;
-    std::vector<Capacitor> capacitors_group2;
+    // Results of the last calculate_capacitors_tank, filled by the dump decorators and violation checks.
+    TankResultTable results;
+    ViolationReport violations;
 
-    std::unordered_map<std::string, std::unique_ptr<CapacitorSpecification>> stored_specs;
+    void _add_part(PartId part, std::vector<CapacitorInterface*> &caps);
     
 public:
     TankCalculator(std::vector<CapacitorSpecification> &specs);
+    // Shares an interned catalog, e.g. between the tanks of the daemon.
+    explicit TankCalculator(std::shared_ptr<const PartIndex> parts);
+    // The nodes point at each other, so a calculator stays where it was built.
+    TankCalculator(const TankCalculator &) = delete;
+    TankCalculator &operator=(const TankCalculator &) = delete;
+    // Looks the names up once, then composes by id.
     void compose_capacitors_tank(std::vector<std::string> &group1, std::vector<std::string> &group2);
+    // Replaces the previous composition, if any. Recomposing, e.g. for every candidate of a design search,
+    // does not allocate once a tank of as many parts with names as long has been composed: the nodes and
+    // their name strings are reused, whatever the length of the names.
+    void compose_capacitors_tank(const std::vector<PartId> &group1, const std::vector<PartId> &group2);
+    const PartIndex &part_index() const { return *parts; }
+    // Evaluates the decorated tank into last_results()/last_violations(). Without LOG_CONSOLE the first
+    // violation is thrown as std::runtime_error.
     double calculate_capacitors_tank(float frequency, float current);
+    // Same evaluation on the compiled tank, appending one row per node to a table from make_result_table().
+    double calculate_capacitors_tank(float frequency, float current, TankResultTable &table);
+    TankResultTable make_result_table() const;
+    // Flat form of the composed tank, for the analyses working on CompiledTank.
+    const CompiledTank &compiled() const { return compiled_tank; }
+    const TankResultTable &last_results() const { return results; }
+    const ViolationReport &last_violations() const { return violations; }
     double calculate_allowed_current(float frequency);
-    ~TankCalculator();
+    // Allowed current of the composed tank over [f_min, f_max] against all node limits, reduced once.
+    AllowedCurrentEnvelope allowed_current_envelope(float f_min, float f_max) const;
+    // Evaluates like calculate_capacitors_tank, but appends every exceeded limit of every node (ids in
+    // TankSweepResult node order) to report instead of printing or throwing. Does not allocate.
+    double check_capacitors_tank(float frequency, float current, ViolationReport &report);
+    // Evaluates calculate_capacitors_tank and calculate_allowed_current for every (frequency, current) pair in one pass.
+    void sweep_capacitors_tank(const std::vector<float> &frequencies, const std::vector<float> &currents, TankSweepResult &result);
+    // Same sweep in single precision, twice as many points per vector. Every value is within a relative
+    // error of (2 * parts + 16) * 2^-24 of the double sweep, e.g. 3.1e-6 for a tank of 18 parts.
+    void sweep_capacitors_tank(const std::vector<float> &frequencies, const std::vector<float> &currents, BasicTankSweepResult<float> &result);
 };
 
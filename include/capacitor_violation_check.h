@@ -1,6 +1,7 @@
 #pragma once
 
 #include "capacitors.h"
+#include "capacitor_violation_report.h"
 
 // Decorator base class for current violation
 class CapacitorMaxViolationCheckDecoratorBase : public CapacitorInterface {
@@ -12,18 +13,30 @@ public:
 
     virtual double xc(double f) const override;
     
-    virtual std::string name() const override;
+    virtual const std::string& name() const override;
     
     virtual const CapacitorSpec& spec() const override;
     
     virtual double allowed_current(double f) const override;
+
+    virtual CapacitorKind kind() const override;
+
+    virtual const std::vector<CapacitorInterface*>& capacitors() const override;
 };
 
 // Decorator for max current violation
 class CapacitorMaxViolationCheckDecorator : public CapacitorMaxViolationCheckDecoratorBase {
+    ViolationReport* report = nullptr;
+    uint32_t node = 0;
+
+    void _violation(ViolationKind kind, double value, double limit) const;
+
 public:
     CapacitorMaxViolationCheckDecorator(CapacitorInterface* cap);
 
+    // Records the violations of the node into report instead of logging or throwing them.
+    CapacitorMaxViolationCheckDecorator(CapacitorInterface* cap, ViolationReport* report, uint32_t node);
+
     virtual double current(double f, double voltage) const override;
 
     virtual double voltage(double f, double current) const override;
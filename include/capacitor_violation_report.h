@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ViolationKind : uint8_t {
+    Overcurrent,
+    Overvoltage,
+    Overpower
+};
+
+// One exceeded limit of one node. Plain data, names are only looked up when a message is formatted.
+struct Violation {
+    uint32_t node;
+    ViolationKind kind;
+    double value;
+    double limit;
+};
+
+// Collects violations into a buffer allocated once at construction. record() never allocates or throws;
+// violations beyond the capacity are only counted.
+class ViolationReport {
+    std::vector<Violation> _violations;
+    size_t _count = 0;
+    uint64_t _dropped = 0;
+
+public:
+    explicit ViolationReport(size_t capacity = 64);
+
+    void record(uint32_t node, ViolationKind kind, double value, double limit) noexcept
+    {
+        if (_count < _violations.size())
+        {
+            _violations[_count++] = {node, kind, value, limit};
+        }
+        else
+        {
+            ++_dropped;
+        }
+    }
+
+    void clear() noexcept
+    {
+        _count = 0;
+        _dropped = 0;
+    }
+
+    size_t size() const { return _count; }
+    bool empty() const { return _count == 0 && _dropped == 0; }
+    size_t capacity() const { return _violations.size(); }
+    uint64_t dropped() const { return _dropped; }
+
+    const Violation& operator[](size_t index) const { return _violations[index]; }
+    const Violation* begin() const { return _violations.data(); }
+    const Violation* end() const { return _violations.data() + _count; }
+};
+
+// Console warning for a violation of the named node.
+std::string format_violation(const Violation& violation, const std::string& name);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "capacitor_compiled.h"
+#include "capacitor_interval.h"
+
+struct WorstCaseOptions
+{
+    double current = 0.0;
+    double frequency = 0.0;
+    // Relative tolerances: every value lies anywhere in value * [1 - tolerance, 1 + tolerance].
+    double current_tolerance = 0.0;
+    double frequency_tolerance = 0.0;
+    double capacitance_tolerance = 0.05; // of every part, independently
+};
+
+// Bounds of one node over every combination of the toleranced values.
+struct NodeBounds
+{
+    std::string name;
+    Interval current;
+    Interval voltage;
+    Interval power;
+    Interval allowed_current;
+};
+
+struct WorstCaseResult
+{
+    std::vector<NodeBounds> nodes; // CompiledTank node order
+    Interval allowed_current;      // of the whole tank
+    // Limits that some combination within the bounds may exceed, with the upper bound as the value.
+    ViolationReport violations;
+};
+
+// Evaluates the tank driven by options.current at options.frequency (CompiledTankEvaluator::voltage) once,
+// in interval arithmetic. The bounds are guaranteed, rounding included, but not tight: a value used twice,
+// like the capacitance of a part in a parallel split, is bounded as if it could take two different values.
+WorstCaseResult run_worst_case(const CompiledTank &tank, const WorstCaseOptions &options);
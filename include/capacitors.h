@@ -2,26 +2,38 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 
-// CapacitorSpec class definition
-class CapacitorSpec {
+// CapacitorSpec class definition. T is the scalar type of the limits: double for the composite classes,
+// float for the single precision sweep.
+template <typename T>
+class BasicCapacitorSpec {
 private:
-    double cap_uF;
-    double cap_F;
-    double i_max;
-    double v_max;
-    double power_max;
+    T cap_uF;
+    T cap_F;
+    T i_max;
+    T v_max;
+    T power_max;
 
 public:
-    CapacitorSpec() : cap_uF(0.0), cap_F(0.0), i_max(0.0), v_max(0.0), power_max(0.0) {}
-    CapacitorSpec(double cap_uF, double v_max, double i_max, double power_max)
-        : cap_uF(cap_uF), cap_F(cap_uF * 1e-6), i_max(i_max), v_max(v_max), power_max(power_max) {}
-
-    double get_i_max() const { return i_max; }
-    double get_v_max() const { return v_max; }
-    double get_power_max() const { return power_max; }
-    double get_cap_F() const { return cap_F; }
-    double get_cap_uF() const { return cap_uF; }
+    constexpr BasicCapacitorSpec() : cap_uF(0.0), cap_F(0.0), i_max(0.0), v_max(0.0), power_max(0.0) {}
+    constexpr BasicCapacitorSpec(T cap_uF, T v_max, T i_max, T power_max)
+        : cap_uF(cap_uF), cap_F(cap_uF * T(1e-6)), i_max(i_max), v_max(v_max), power_max(power_max) {}
+
+    constexpr T get_i_max() const { return i_max; }
+    constexpr T get_v_max() const { return v_max; }
+    constexpr T get_power_max() const { return power_max; }
+    constexpr T get_cap_F() const { return cap_F; }
+    constexpr T get_cap_uF() const { return cap_uF; }
+};
+
+using CapacitorSpec = BasicCapacitorSpec<double>;
+
+// Kind of a node in the capacitor composite, used to walk the tree without knowing the concrete classes.
+enum class CapacitorKind {
+    Single,
+    Parallel,
+    Series
 };
 
 // CapacitorInterface class definition
@@ -32,7 +44,9 @@ public:
     virtual double allowed_current(double f) const = 0;
     virtual double voltage(double f, double current) const = 0;
     virtual const CapacitorSpec& spec() const = 0;
-    virtual std::string name() const = 0;
+    virtual const std::string& name() const = 0;
+    virtual CapacitorKind kind() const = 0;
+    virtual const std::vector<CapacitorInterface*>& capacitors() const = 0;
 
     virtual ~CapacitorInterface() {}
 };
@@ -48,7 +62,9 @@ public:
     virtual double allowed_current(double f) const;
     virtual double voltage(double f, double current) const;
     virtual const CapacitorSpec& spec() const;
-    virtual std::string name() const;
+    virtual const std::string& name() const;
+    virtual CapacitorKind kind() const;
+    virtual const std::vector<CapacitorInterface*>& capacitors() const;
 };
 
 // Capacitor class definition
@@ -56,6 +72,8 @@ class Capacitor : public CapacitorBase {
 public:
     Capacitor() = default;
     Capacitor(double cap_uF, double vmax, double imax, double power_max, std::string cap_name = "");
+    // Reinitialises the capacitor in place, reusing the storage of its name.
+    void assign(double cap_uF, double vmax, double imax, double power_max, std::string_view cap_name = "");
 };
 
 class GroupCapacitorBase : public CapacitorBase 
@@ -63,9 +81,11 @@ class GroupCapacitorBase : public CapacitorBase
 protected:
     std::vector<CapacitorInterface*> _capacitors;
 
+public:
+    const std::vector<CapacitorInterface*>& capacitors() const override;
+
 protected:
     GroupCapacitorBase() = default;
-    GroupCapacitorBase(const std::vector<CapacitorInterface*>& capacitors);
     static const std::string _get_name(const std::string& cap_name, const CapacitorSpec& cap_spec, const std::string& type = "group");
 };
 
@@ -75,6 +95,10 @@ class ParallelCapacitor : public GroupCapacitorBase
 public:
     ParallelCapacitor() = default;
     ParallelCapacitor(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name = "");
+    // Regroups the capacitor in place, reusing the storage of its member list and name.
+    void assign(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name = "");
+    CapacitorKind kind() const override;
+
     double xc(double f) const override;
 
     double current(double f, double voltage) const override;
@@ -87,7 +111,11 @@ public:
 // SeriesCapacitor class definition
 class SeriesCapacitor : public GroupCapacitorBase {
 public:
+    SeriesCapacitor() = default;
     SeriesCapacitor(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name = "");
+    // Regroups the capacitor in place, reusing the storage of its member list and name.
+    void assign(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name = "");
+    CapacitorKind kind() const override;
 
     double xc(double f) const override;
 
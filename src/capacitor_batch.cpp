@@ -0,0 +1,159 @@
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "capacitor_batch.h"
+
+namespace {
+
+constexpr size_t read_chunk = 1 << 20;
+constexpr size_t write_chunk = 1 << 20;
+// Longest output row: five fields of at most 24 characters plus separators.
+constexpr size_t max_row = 160;
+
+const char *skip_blanks(const char *first, const char *last)
+{
+    while (first != last && (*first == ' ' || *first == '\t' || *first == '\r'))
+    {
+        ++first;
+    }
+    return first;
+}
+
+// Parses "current,frequency" between first and last.
+bool parse_point(const char *first, const char *last, float &current, float &frequency)
+{
+    first = skip_blanks(first, last);
+    auto parsed = std::from_chars(first, last, current);
+    if (parsed.ec != std::errc())
+    {
+        return false;
+    }
+    first = skip_blanks(parsed.ptr, last);
+    if (first == last || *first != ',')
+    {
+        return false;
+    }
+    first = skip_blanks(first + 1, last);
+    parsed = std::from_chars(first, last, frequency);
+    if (parsed.ec != std::errc())
+    {
+        return false;
+    }
+    return skip_blanks(parsed.ptr, last) == last;
+}
+
+class RowWriter
+{
+    std::FILE *output;
+    std::vector<char> buffer;
+    size_t used = 0;
+
+public:
+    explicit RowWriter(std::FILE *output) : output(output), buffer(write_chunk) {}
+
+    void flush()
+    {
+        std::fwrite(buffer.data(), 1, used, output);
+        used = 0;
+    }
+
+    void text(const char *line)
+    {
+        size_t size = std::strlen(line);
+        std::memcpy(buffer.data() + used, line, size);
+        used += size;
+    }
+
+    void row(double current, double frequency, double tank_current, double allowed_current, size_t violations)
+    {
+        if (buffer.size() - used < max_row)
+        {
+            flush();
+        }
+        char *out = buffer.data() + used;
+        char *end = buffer.data() + buffer.size();
+        out = std::to_chars(out, end, current).ptr;
+        *out++ = ',';
+        out = std::to_chars(out, end, frequency).ptr;
+        *out++ = ',';
+        out = std::to_chars(out, end, tank_current).ptr;
+        *out++ = ',';
+        out = std::to_chars(out, end, allowed_current).ptr;
+        *out++ = ',';
+        out = std::to_chars(out, end, violations).ptr;
+        *out++ = '\n';
+        used = out - buffer.data();
+    }
+};
+
+} // namespace
+
+BatchStats run_batch(TankCalculator &tank_calculator, std::FILE *input, std::FILE *output)
+{
+    BatchStats stats;
+    ViolationReport report;
+    RowWriter writer(output);
+    writer.text("current,frequency,tank_current,allowed_current,violations\n");
+
+    std::vector<char> buffer(read_chunk);
+    size_t pending = 0;
+    uint64_t line_number = 0;
+    bool at_end = false;
+
+    while (!at_end)
+    {
+        size_t read = std::fread(buffer.data() + pending, 1, buffer.size() - pending, input);
+        at_end = read == 0;
+        size_t filled = pending + read;
+
+        const char *first = buffer.data();
+        const char *last = buffer.data() + filled;
+        for (;;)
+        {
+            const char *newline = static_cast<const char *>(std::memchr(first, '\n', last - first));
+            if (!newline)
+            {
+                // Keep the incomplete line for the next chunk, or take it as the last line at the end.
+                if (!at_end || first == last)
+                {
+                    break;
+                }
+                newline = last;
+            }
+
+            ++line_number;
+            float current;
+            float frequency;
+            if (parse_point(first, newline, current, frequency))
+            {
+                report.clear();
+                double tank_current = tank_calculator.check_capacitors_tank(frequency, current, report);
+                double allowed_current = tank_calculator.calculate_allowed_current(frequency);
+                writer.row(current, frequency, tank_current, allowed_current, report.size() + report.dropped());
+                ++stats.points;
+            }
+            else if (skip_blanks(first, newline) != newline && !(line_number == 1 && stats.points == 0))
+            {
+                std::cerr << "Warning: Skipping malformed line " << line_number << std::endl;
+                ++stats.skipped_lines;
+            }
+
+            first = newline == last ? last : newline + 1;
+        }
+
+        pending = last - first;
+        std::memmove(buffer.data(), first, pending);
+        if (pending == buffer.size())
+        {
+            // A single line longer than the whole buffer.
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+
+    writer.flush();
+    std::fflush(output);
+    return stats;
+}
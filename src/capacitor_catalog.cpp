@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "capacitor_catalog.h"
+
+namespace {
+
+constexpr char catalog_magic[4] = {'T', 'C', 'A', 'T'};
+
+uint64_t catalog_checksum(const char *data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    size_t words = size / 8;
+    for (size_t k = 0; k < words; ++k)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + 8 * k, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    if (size % 8 != 0)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, data + 8 * words, size % 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t catalog_body_size(uint64_t count, uint64_t strings_size)
+{
+    return 4 * count * sizeof(float) + (2 * count + 1) * sizeof(uint32_t) + strings_size;
+}
+
+[[noreturn]] void invalid_catalog(const std::string &path, const std::string &reason)
+{
+    throw std::runtime_error("Invalid capacitor catalog " + path + ": " + reason + ".");
+}
+
+}
+
+CapacitorCatalog::CapacitorCatalog(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || ::fstat(fd, &status) != 0)
+    {
+        std::string error = std::strerror(errno);
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        throw std::runtime_error("Could not open capacitor catalog " + path + ": " + error);
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    if (size < sizeof(CatalogHeader))
+    {
+        ::close(fd);
+        invalid_catalog(path, "shorter than its header");
+    }
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Could not map capacitor catalog " + path + ": " + std::strerror(errno));
+    }
+    _mapping = mapping;
+    _mapped = size;
+
+    // The destructor does not run for a throwing constructor, so failed validation unmaps here.
+    try
+    {
+        const char *bytes = static_cast<const char *>(mapping);
+        CatalogHeader header;
+        std::memcpy(&header, bytes, sizeof(header));
+        if (std::memcmp(header.magic, catalog_magic, sizeof(catalog_magic)) != 0)
+        {
+            invalid_catalog(path, "not a binary catalog");
+        }
+        if (header.version != catalog_version)
+        {
+            invalid_catalog(path, "version " + std::to_string(header.version) + ", expected " + std::to_string(catalog_version));
+        }
+        if (header.count >= UINT32_MAX || header.strings_size >= UINT32_MAX ||
+            catalog_body_size(header.count, header.strings_size) != size - sizeof(CatalogHeader))
+        {
+            invalid_catalog(path, "truncated or sizes inconsistent");
+        }
+        const char *body = bytes + sizeof(CatalogHeader);
+        if (catalog_checksum(body, size - sizeof(CatalogHeader)) != header.checksum)
+        {
+            invalid_catalog(path, "checksum mismatch");
+        }
+
+        _count = header.count;
+        _capacitance = reinterpret_cast<const float *>(body);
+        _voltage = _capacitance + _count;
+        _current = _voltage + _count;
+        _power = _current + _count;
+        _name_offset = reinterpret_cast<const uint32_t *>(_power + _count);
+        _by_name = _name_offset + _count + 1;
+        _strings = reinterpret_cast<const char *>(_by_name + _count);
+
+        if (_name_offset[0] != 0 || _name_offset[_count] != header.strings_size)
+        {
+            invalid_catalog(path, "name offsets out of the string table");
+        }
+        for (size_t k = 0; k < _count; ++k)
+        {
+            if (_name_offset[k] > _name_offset[k + 1] || _by_name[k] >= _count)
+            {
+                invalid_catalog(path, "name offsets or name order out of range");
+            }
+        }
+        for (size_t k = 1; k < _count; ++k)
+        {
+            if (name(_by_name[k - 1]) > name(_by_name[k]))
+            {
+                invalid_catalog(path, "parts not ordered by name");
+            }
+        }
+    }
+    catch (...)
+    {
+        ::munmap(_mapping, _mapped);
+        throw;
+    }
+}
+
+CapacitorCatalog::~CapacitorCatalog()
+{
+    ::munmap(_mapping, _mapped);
+}
+
+size_t CapacitorCatalog::find(std::string_view part_name) const
+{
+    const uint32_t *last = std::upper_bound(_by_name, _by_name + _count, part_name,
+                                            [this](std::string_view key, uint32_t part) { return key < name(part); });
+    if (last == _by_name || name(*(last - 1)) != part_name)
+    {
+        return npos;
+    }
+    return *(last - 1);
+}
+
+CapacitorSpecification CapacitorCatalog::specification(size_t part) const
+{
+    return {_capacitance[part], _current[part], std::string(name(part)), _power[part], _voltage[part]};
+}
+
+std::vector<CapacitorSpecification> CapacitorCatalog::specifications() const
+{
+    std::vector<CapacitorSpecification> specs;
+    specs.reserve(_count);
+    for (size_t k = 0; k < _count; ++k)
+    {
+        specs.push_back(specification(k));
+    }
+    return specs;
+}
+
+void write_capacitor_catalog(const std::vector<CapacitorSpecification> &specs, const std::string &path)
+{
+    size_t count = specs.size();
+    std::vector<uint32_t> name_offset(count + 1);
+    std::string strings;
+    for (size_t k = 0; k < count; ++k)
+    {
+        name_offset[k] = static_cast<uint32_t>(strings.size());
+        strings += specs[k].name;
+    }
+    name_offset[count] = static_cast<uint32_t>(strings.size());
+    if (count >= UINT32_MAX || strings.size() >= UINT32_MAX)
+    {
+        throw std::runtime_error("Capacitor catalog too large for " + path + ".");
+    }
+
+    std::vector<uint32_t> by_name(count);
+    std::iota(by_name.begin(), by_name.end(), 0);
+    std::stable_sort(by_name.begin(), by_name.end(),
+                     [&specs](uint32_t a, uint32_t b) { return specs[a].name < specs[b].name; });
+
+    std::vector<char> body(catalog_body_size(count, strings.size()));
+    char *out = body.data();
+    auto put_column = [&](float CapacitorSpecification::*field) {
+        for (const CapacitorSpecification &spec : specs)
+        {
+            std::memcpy(out, &(spec.*field), sizeof(float));
+            out += sizeof(float);
+        }
+    };
+    put_column(&CapacitorSpecification::capacitance);
+    put_column(&CapacitorSpecification::voltage);
+    put_column(&CapacitorSpecification::current);
+    put_column(&CapacitorSpecification::power);
+    std::memcpy(out, name_offset.data(), name_offset.size() * sizeof(uint32_t));
+    out += name_offset.size() * sizeof(uint32_t);
+    std::memcpy(out, by_name.data(), by_name.size() * sizeof(uint32_t));
+    out += by_name.size() * sizeof(uint32_t);
+    std::memcpy(out, strings.data(), strings.size());
+
+    CatalogHeader header;
+    std::memcpy(header.magic, catalog_magic, sizeof(catalog_magic));
+    header.version = catalog_version;
+    header.count = count;
+    header.strings_size = strings.size();
+    header.checksum = catalog_checksum(body.data(), body.size());
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Could not write capacitor catalog " + path + ".");
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(body.data(), 1, body.size(), file) == body.size();
+    if (std::fclose(file) != 0 || !written)
+    {
+        throw std::runtime_error("Could not write capacitor catalog " + path + ".");
+    }
+}
+
+bool is_capacitor_catalog_path(const std::string &path)
+{
+    return path.size() >= 5 && path.compare(path.size() - 5, 5, ".tcat") == 0;
+}
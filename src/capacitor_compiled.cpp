@@ -0,0 +1,310 @@
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "capacitor_compiled.h"
+#include "capacitor_formulas.h"
+#include "capacitor_interval.h"
+#include "capacitor_dual.h"
+#include "capacitor_sensitivity.h"
+
+CompiledTank::CompiledTank(const CapacitorInterface& root)
+{
+    compile(root);
+}
+
+void CompiledTank::compile(const CapacitorInterface& root)
+{
+    _kind.clear();
+    _parent.clear();
+    _first_child.clear();
+    _cap_uF.clear();
+    _cap_F.clear();
+    _v_max.clear();
+    _i_max.clear();
+    _power_max.clear();
+    _recycled_names.clear(_names);
+
+    // Iterative post-order walk so deep trees do not depend on the call stack depth.
+    _stack.clear();
+    _pending.clear();
+    _stack.push_back({&root, 0, 0});
+    while (!_stack.empty())
+    {
+        Frame& top = _stack.back();
+        const auto& children = top.cap->capacitors();
+        if (top.next_child < children.size())
+        {
+            const CapacitorInterface* child = children[top.next_child++];
+            _stack.push_back({child, 0, _pending.size()});
+            continue;
+        }
+
+        uint32_t id = _add_node(*top.cap);
+        for (size_t k = top.pending_begin; k < _pending.size(); ++k)
+        {
+            _parent[_pending[k]] = id;
+            _first_child[_pending[k]] = k == top.pending_begin;
+        }
+        _pending.resize(top.pending_begin);
+        _pending.push_back(id);
+        _stack.pop_back();
+    }
+}
+
+uint32_t CompiledTank::_add_node(const CapacitorInterface& cap)
+{
+    const CapacitorSpec& spec = cap.spec();
+    _kind.push_back(cap.kind());
+    _parent.push_back(no_parent);
+    _first_child.push_back(0);
+    _cap_uF.push_back(spec.get_cap_uF());
+    _cap_F.push_back(spec.get_cap_F());
+    _v_max.push_back(spec.get_v_max());
+    _i_max.push_back(spec.get_i_max());
+    _power_max.push_back(spec.get_power_max());
+    _recycled_names.push_back(_names, cap.name());
+    return static_cast<uint32_t>(_kind.size() - 1);
+}
+
+template <typename T>
+BasicCompiledTankEvaluator<T>::BasicCompiledTankEvaluator(const CompiledTank& tank)
+    : tank(tank), _cap_F(tank.cap_F().begin(), tank.cap_F().end()), _xc(tank.size()), _current(tank.size()),
+      _voltage(tank.size()), _allowed_current(tank.size())
+{
+}
+
+template <typename T>
+void BasicCompiledTankEvaluator<T>::reset()
+{
+    _cap_F.assign(tank.cap_F().begin(), tank.cap_F().end());
+    _xc.resize(tank.size());
+    _current.resize(tank.size());
+    _voltage.resize(tank.size());
+    _allowed_current.resize(tank.size());
+    _prepared = false;
+}
+
+template <typename T>
+void BasicCompiledTankEvaluator<T>::prepare(const T& f)
+{
+    const size_t size = tank.size();
+    const CapacitorKind* kind = tank.kind().data();
+    const uint32_t* parent = tank.parent().data();
+    const T* cap_F = _cap_F.data();
+    T* xc = _xc.data();
+
+    // Groups accumulate their children in place, like the std::accumulate in the group xc().
+    std::fill(_xc.begin(), _xc.end(), T(0.0));
+    for (size_t n = 0; n < size; ++n)
+    {
+        ++_xc_visits;
+        switch (kind[n])
+        {
+        case CapacitorKind::Single:
+            xc[n] = capacitor_xc(f, cap_F[n]);
+            break;
+        case CapacitorKind::Parallel:
+            xc[n] = admittance(xc[n]);
+            break;
+        case CapacitorKind::Series:
+            break;
+        }
+
+        uint32_t p = parent[n];
+        if (p == CompiledTank::no_parent)
+        {
+            continue;
+        }
+        xc[p] = xc[p] + (kind[p] == CapacitorKind::Parallel ? admittance(xc[n]) : xc[n]);
+    }
+
+    _prepared = true;
+    _frequency = f;
+}
+
+template <typename T>
+void BasicCompiledTankEvaluator<T>::_ensure_prepared(const T& f)
+{
+    if (!_prepared || f != _frequency)
+    {
+        prepare(f);
+    }
+}
+
+template <typename T>
+T BasicCompiledTankEvaluator<T>::xc(const T& f)
+{
+    _ensure_prepared(f);
+    return xc();
+}
+
+template <typename T>
+T BasicCompiledTankEvaluator<T>::current(const T& f, const T& voltage)
+{
+    _ensure_prepared(f);
+    return current(voltage);
+}
+
+template <typename T>
+T BasicCompiledTankEvaluator<T>::voltage(const T& f, const T& current)
+{
+    _ensure_prepared(f);
+    return voltage(current);
+}
+
+template <typename T>
+T BasicCompiledTankEvaluator<T>::allowed_current(const T& f)
+{
+    _ensure_prepared(f);
+    return allowed_current();
+}
+
+template <typename T>
+T BasicCompiledTankEvaluator<T>::current(const T& voltage)
+{
+    const size_t size = tank.size();
+    const CapacitorKind* kind = tank.kind().data();
+    const uint32_t* parent = tank.parent().data();
+    const T* xc = _xc.data();
+    T* i = _current.data();
+    T* v = _voltage.data();
+
+    // Top-down: series groups split the voltage by reactance, parallel groups pass it on.
+    for (size_t n = size; n-- > 0;)
+    {
+        uint32_t p = parent[n];
+        if (p == CompiledTank::no_parent)
+        {
+            v[n] = voltage;
+        }
+        else
+        {
+            v[n] = kind[p] == CapacitorKind::Series ? reactance_voltage(i[p], xc[n]) : v[p];
+        }
+        i[n] = kind[n] == CapacitorKind::Parallel ? T(0.0) : reactance_current(v[n], xc[n]);
+    }
+
+    // Bottom-up: parallel groups sum the currents of their members.
+    for (size_t n = 0; n < size; ++n)
+    {
+        uint32_t p = parent[n];
+        if (p != CompiledTank::no_parent && kind[p] == CapacitorKind::Parallel)
+        {
+            i[p] = i[p] + i[n];
+        }
+    }
+
+    return i[tank.root()];
+}
+
+template <typename T>
+T BasicCompiledTankEvaluator<T>::voltage(const T& current)
+{
+    const size_t size = tank.size();
+    const CapacitorKind* kind = tank.kind().data();
+    const uint32_t* parent = tank.parent().data();
+    const T* xc = _xc.data();
+    T* i = _current.data();
+    T* v = _voltage.data();
+
+    // Top-down: series groups pass the current on, parallel groups split it by admittance.
+    for (size_t n = size; n-- > 0;)
+    {
+        uint32_t p = parent[n];
+        if (p == CompiledTank::no_parent)
+        {
+            i[n] = current;
+        }
+        else
+        {
+            i[n] = kind[p] == CapacitorKind::Parallel ? reactance_current(v[p], xc[n]) : i[p];
+        }
+        v[n] = kind[n] == CapacitorKind::Series ? T(0.0) : reactance_voltage(i[n], xc[n]);
+    }
+
+    // Bottom-up: series groups sum the voltages of their members.
+    for (size_t n = 0; n < size; ++n)
+    {
+        uint32_t p = parent[n];
+        if (p != CompiledTank::no_parent && kind[p] == CapacitorKind::Series)
+        {
+            v[p] = v[p] + v[n];
+        }
+    }
+
+    return v[tank.root()];
+}
+
+template <typename T>
+T BasicCompiledTankEvaluator<T>::allowed_current()
+{
+    const size_t size = tank.size();
+    const CapacitorKind* kind = tank.kind().data();
+    const uint32_t* parent = tank.parent().data();
+    const uint8_t* first_child = tank.first_child().data();
+    const double* v_max = tank.v_max().data();
+    const T* xc = _xc.data();
+    T* allowed = _allowed_current.data();
+
+    // Series groups take the first smallest value of their members, like std::min_element.
+    for (size_t n = 0; n < size; ++n)
+    {
+        if (kind[n] != CapacitorKind::Series)
+        {
+            allowed[n] = reactance_allowed_current(T(v_max[n]), xc[n]);
+        }
+
+        uint32_t p = parent[n];
+        if (p != CompiledTank::no_parent && kind[p] == CapacitorKind::Series)
+        {
+            allowed[p] = first_child[n] ? allowed[n] : smaller(allowed[n], allowed[p]);
+        }
+    }
+
+    return allowed[tank.root()];
+}
+
+template <typename T>
+void BasicCompiledTankEvaluator<T>::check_limits(ViolationReport& report) const
+{
+    const size_t size = tank.size();
+    const double* i_max = tank.i_max().data();
+    const double* v_max = tank.v_max().data();
+    const double* power_max = tank.power_max().data();
+
+    for (size_t n = 0; n < size; ++n)
+    {
+        uint32_t node = static_cast<uint32_t>(n);
+        double current = upper(_current[n]);
+        double voltage = upper(_voltage[n]);
+        double power = upper(_current[n] * _voltage[n]);
+        if (current > i_max[n])
+        {
+            report.record(node, ViolationKind::Overcurrent, current, i_max[n]);
+        }
+        if (voltage > v_max[n])
+        {
+            report.record(node, ViolationKind::Overvoltage, voltage, v_max[n]);
+        }
+        if (power > power_max[n])
+        {
+            report.record(node, ViolationKind::Overpower, power, power_max[n]);
+        }
+    }
+}
+
+template class BasicCompiledTankEvaluator<double>;
+template class BasicCompiledTankEvaluator<Interval>;
+template class BasicCompiledTankEvaluator<float>;
+template class BasicCompiledTankEvaluator<SweepLanes<float>>;
+template class BasicCompiledTankEvaluator<SweepLanes<double>>;
+template class BasicCompiledTankEvaluator<Dual<sensitivity_width>>;
+
+CurrentDriveResponse::CurrentDriveResponse(const CompiledTank& tank)
+{
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(1.0, 1.0);
+    current_share = evaluator.node_current();
+    unit_voltage = evaluator.node_voltage();
+}
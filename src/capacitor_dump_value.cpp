@@ -2,10 +2,7 @@
 #include <algorithm>
 #include <stdexcept>
 #include <numeric>
-#include <sstream>
-#include <iomanip>
 #include <string>
-#include <iostream>
 #include <cmath>
 
 #include "capacitor_dump_value.h"
@@ -18,7 +15,7 @@ double CapacitoDumpValueDecoratorBase::xc(double f) const {
     return cap->xc(f);
 }
 
-std::string CapacitoDumpValueDecoratorBase::name() const {
+const std::string& CapacitoDumpValueDecoratorBase::name() const {
     return cap->name();
 }
 
@@ -30,8 +27,16 @@ double CapacitoDumpValueDecoratorBase::allowed_current(double f) const {
     return cap->allowed_current(f);
 }
 
-CapacitoDumpValueDecorator::CapacitoDumpValueDecorator(CapacitorInterface* cap) 
-    : CapacitoDumpValueDecoratorBase(cap) 
+CapacitorKind CapacitoDumpValueDecoratorBase::kind() const {
+    return cap->kind();
+}
+
+const std::vector<CapacitorInterface*>& CapacitoDumpValueDecoratorBase::capacitors() const {
+    return cap->capacitors();
+}
+
+CapacitoDumpValueDecorator::CapacitoDumpValueDecorator(CapacitorInterface* cap, TankResultTable& table) 
+    : CapacitoDumpValueDecoratorBase(cap), table(table), name_id(table.name_id(cap->name()))
 {
     
 }
@@ -39,39 +44,12 @@ CapacitoDumpValueDecorator::CapacitoDumpValueDecorator(CapacitorInterface* cap)
 double CapacitoDumpValueDecorator::current(double f, double voltage) const 
 {
     double current = cap->current(f, voltage);
-    // double xc = cap->xc(f);
-    // double voltage = current * xc;
-    double power = current * voltage;
-
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(0) <<
-        "Capacitor: " << cap->name() << 
-        ", Current: " << current <<
-        ", Voltage: " << voltage << 
-        ", Power: " << power;
-    std::cout << oss.str() << std::endl;
-    
+    table.add(name_id, current, voltage);
     return current;
 }
 
 double CapacitoDumpValueDecorator::voltage(double f, double current) const {
-    
     double voltage = cap->voltage(f, current);
-    // double xc = cap->xc(f);
-    // double current = voltage / xc;
-    double power = current * voltage;
-
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(0) <<
-        "Capacitor: " << cap->name() << 
-        ", Current: " << current << 
-        ", Voltage: " << voltage << 
-        ", Power: " << power;
-    std::cout << oss.str() << std::endl;
-
+    table.add(name_id, current, voltage);
     return voltage;
 }
-
-
-
-
@@ -0,0 +1,123 @@
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "capacitor_envelope.h"
+
+namespace {
+
+double allowed(const EnvelopePiece &piece, double f)
+{
+    if (piece.exponent == 1)
+    {
+        return piece.coefficient * f;
+    }
+    return piece.exponent == 0 ? piece.coefficient : piece.coefficient * std::sqrt(f);
+}
+
+} // namespace
+
+AllowedCurrentEnvelope::AllowedCurrentEnvelope(const CompiledTank &tank, double f_min, double f_max)
+{
+    if (!(f_min > 0) || !(f_max >= f_min))
+    {
+        throw std::invalid_argument("Envelope range must satisfy 0 < f_min <= f_max.");
+    }
+
+    CurrentDriveResponse response(tank);
+
+    // Tightest limit of each kind; only these can be on the envelope.
+    EnvelopePiece tightest[] = {
+        {f_min, f_max, CompiledTank::no_parent, ViolationKind::Overcurrent, HUGE_VAL, 0.0},
+        {f_min, f_max, CompiledTank::no_parent, ViolationKind::Overvoltage, HUGE_VAL, 1.0},
+        {f_min, f_max, CompiledTank::no_parent, ViolationKind::Overpower, HUGE_VAL, 0.5}};
+    auto tighten = [](EnvelopePiece &piece, uint32_t node, double coefficient) {
+        if (coefficient < piece.coefficient)
+        {
+            piece.node = node;
+            piece.coefficient = coefficient;
+        }
+    };
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        double current = response.current_share[n];
+        double voltage = response.unit_voltage[n];
+        if (current > 0)
+        {
+            tighten(tightest[0], n, tank.i_max()[n] / current);
+        }
+        if (voltage > 0)
+        {
+            tighten(tightest[1], n, tank.v_max()[n] / voltage);
+        }
+        if (current * voltage > 0)
+        {
+            tighten(tightest[2], n, std::sqrt(tank.power_max()[n] / (current * voltage)));
+        }
+    }
+
+    // The envelope can only change where two of them cross.
+    std::vector<double> breakpoints = {f_min, f_max};
+    for (int a = 0; a < 3; ++a)
+    {
+        for (int b = a + 1; b < 3; ++b)
+        {
+            const EnvelopePiece &p = tightest[a];
+            const EnvelopePiece &q = tightest[b];
+            if (p.node == CompiledTank::no_parent || q.node == CompiledTank::no_parent)
+            {
+                continue;
+            }
+            double f = std::pow(p.coefficient / q.coefficient, 1 / (q.exponent - p.exponent));
+            if (f > f_min && f < f_max)
+            {
+                breakpoints.push_back(f);
+            }
+        }
+    }
+    std::sort(breakpoints.begin(), breakpoints.end());
+
+    for (size_t k = 0; k + 1 < breakpoints.size(); ++k)
+    {
+        double f_begin = breakpoints[k];
+        double f_end = breakpoints[k + 1];
+        if (f_begin == f_end && !_pieces.empty())
+        {
+            continue;
+        }
+        double f = std::sqrt(f_begin * f_end);
+        const EnvelopePiece *lowest = &tightest[0];
+        for (const EnvelopePiece &piece : tightest)
+        {
+            if (allowed(piece, f) < allowed(*lowest, f))
+            {
+                lowest = &piece;
+            }
+        }
+        if (!_pieces.empty() && _pieces.back().node == lowest->node && _pieces.back().limit == lowest->limit)
+        {
+            _pieces.back().f_end = f_end;
+            continue;
+        }
+        _pieces.push_back(*lowest);
+        _pieces.back().f_begin = f_begin;
+        _pieces.back().f_end = f_end;
+    }
+}
+
+const EnvelopePiece &AllowedCurrentEnvelope::piece(double f) const
+{
+    if (_pieces.empty() || !(f >= f_min() && f <= f_max()))
+    {
+        throw std::invalid_argument("Frequency outside the envelope range.");
+    }
+    auto it = std::lower_bound(_pieces.begin(), _pieces.end(), f,
+                               [](const EnvelopePiece &piece, double f) { return piece.f_end < f; });
+    return *it;
+}
+
+double AllowedCurrentEnvelope::operator()(double f) const
+{
+    return allowed(piece(f), f);
+}
@@ -0,0 +1,252 @@
+#include <vector>
+#include <cmath>
+
+#include "capacitor_faults.h"
+#include "capacitor_formulas.h"
+
+namespace {
+
+struct Peaks
+{
+    StressPeak current;
+    StressPeak voltage;
+    StressPeak power;
+};
+
+StressPeak higher(const StressPeak &a, const StressPeak &b)
+{
+    return b.utilization > a.utilization ? b : a;
+}
+
+StressPeak scaled(StressPeak peak, double scale)
+{
+    peak.utilization *= scale;
+    return peak;
+}
+
+Peaks higher(const Peaks &a, const Peaks &b)
+{
+    return {higher(a.current, b.current), higher(a.voltage, b.voltage), higher(a.power, b.power)};
+}
+
+// Stress of every node of a subtree whose currents and voltages all scale by scale.
+Peaks scaled(const Peaks &peaks, double scale)
+{
+    return {scaled(peaks.current, scale), scaled(peaks.voltage, scale), scaled(peaks.power, scale * scale)};
+}
+
+double ratio(double value, double baseline)
+{
+    return baseline > 0 ? value / baseline : 0.0;
+}
+
+// Members of a group combined as the group constructor does: the reactance terms the group sums
+// (admittances in a parallel group, reactances in a series group), the aggregated limits and the
+// stress peaks of the member subtrees.
+struct Aggregate
+{
+    double term;
+    double i_max;
+    double v_max;
+    double power_max;
+    Peaks peaks;
+    uint32_t members;
+};
+
+Aggregate empty(CapacitorKind kind)
+{
+    bool parallel = kind == CapacitorKind::Parallel;
+    return {0.0, parallel ? 0.0 : HUGE_VAL, parallel ? HUGE_VAL : 0.0, 0.0, Peaks{}, 0};
+}
+
+Aggregate member(CapacitorKind kind, double xc, double i_max, double v_max, double power_max, const Peaks &peaks)
+{
+    return {kind == CapacitorKind::Parallel ? admittance(xc) : xc, i_max, v_max, power_max, peaks, 1};
+}
+
+Aggregate combine(CapacitorKind kind, const Aggregate &a, const Aggregate &b)
+{
+    bool parallel = kind == CapacitorKind::Parallel;
+    return {a.term + b.term,
+            parallel ? a.i_max + b.i_max : smaller(a.i_max, b.i_max),
+            parallel ? smaller(a.v_max, b.v_max) : a.v_max + b.v_max,
+            a.power_max + b.power_max,
+            higher(a.peaks, b.peaks),
+            a.members + b.members};
+}
+
+// Group on the path from a failure to the root, after the failure.
+struct PathNode
+{
+    uint32_t node;
+    double xc;
+    double i_max;
+    double v_max;
+    double power_max;
+    Aggregate others; // members off the path
+};
+
+} // namespace
+
+FaultAnalysisResult run_fault_analysis(const CompiledTank &tank, const FaultOptions &options)
+{
+    const size_t size = tank.size();
+    const CapacitorKind *kind = tank.kind().data();
+    const uint32_t *parent = tank.parent().data();
+
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(options.frequency, options.current);
+    const std::vector<double> &xc = evaluator.node_xc();
+    const std::vector<double> &current = evaluator.node_current();
+    const std::vector<double> &voltage = evaluator.node_voltage();
+
+    // Stress peaks of every subtree; children come before their group.
+    std::vector<Peaks> subtree(size);
+    for (uint32_t n = 0; n < size; ++n)
+    {
+        subtree[n].current = {n, current[n] / tank.i_max()[n]};
+        subtree[n].voltage = {n, voltage[n] / tank.v_max()[n]};
+        subtree[n].power = {n, current[n] * voltage[n] / tank.power_max()[n]};
+    }
+    for (uint32_t n = 0; n < size; ++n)
+    {
+        if (parent[n] != CompiledTank::no_parent)
+        {
+            subtree[parent[n]] = higher(subtree[parent[n]], subtree[n]);
+        }
+    }
+
+    // Members of every group as consecutive slots, in node order.
+    std::vector<uint32_t> slot_begin(size + 1, 0);
+    for (uint32_t n = 0; n < size; ++n)
+    {
+        if (parent[n] != CompiledTank::no_parent)
+        {
+            ++slot_begin[parent[n] + 1];
+        }
+    }
+    for (size_t g = 0; g < size; ++g)
+    {
+        slot_begin[g + 1] += slot_begin[g];
+    }
+    std::vector<uint32_t> slot(size);
+    std::vector<uint32_t> next_slot(slot_begin.begin(), slot_begin.end() - 1);
+    for (uint32_t n = 0; n < size; ++n)
+    {
+        if (parent[n] != CompiledTank::no_parent)
+        {
+            slot[n] = next_slot[parent[n]]++;
+        }
+    }
+
+    // prefix[s] combines the members before slot s of its group, suffix[s] those after it.
+    const size_t slots = slot_begin[size];
+    std::vector<Aggregate> members(slots);
+    for (uint32_t n = 0; n < size; ++n)
+    {
+        uint32_t p = parent[n];
+        if (p != CompiledTank::no_parent)
+        {
+            members[slot[n]] = member(kind[p], xc[n], tank.i_max()[n], tank.v_max()[n], tank.power_max()[n], subtree[n]);
+        }
+    }
+    std::vector<Aggregate> prefix(slots);
+    std::vector<Aggregate> suffix(slots);
+    for (uint32_t g = 0; g < size; ++g)
+    {
+        if (slot_begin[g] == slot_begin[g + 1])
+        {
+            continue;
+        }
+        Aggregate before = empty(kind[g]);
+        for (uint32_t s = slot_begin[g]; s < slot_begin[g + 1]; ++s)
+        {
+            prefix[s] = before;
+            before = combine(kind[g], before, members[s]);
+        }
+        Aggregate after = empty(kind[g]);
+        for (uint32_t s = slot_begin[g + 1]; s-- > slot_begin[g];)
+        {
+            suffix[s] = after;
+            after = combine(kind[g], members[s], after);
+        }
+    }
+    auto without = [&](uint32_t node) {
+        uint32_t p = parent[node];
+        return combine(kind[p], prefix[slot[node]], suffix[slot[node]]);
+    };
+
+    FaultAnalysisResult result;
+    result.current = subtree[tank.root()].current;
+    result.voltage = subtree[tank.root()].voltage;
+    result.power = subtree[tank.root()].power;
+
+    std::vector<PathNode> path;
+    for (uint32_t part = 0; part < size; ++part)
+    {
+        if (kind[part] != CapacitorKind::Single)
+        {
+            continue;
+        }
+        FaultScenario scenario;
+        scenario.part = part;
+
+        // The failed branch: the part, the series groups it opens and the groups left without a member.
+        uint32_t failed = part;
+        while (parent[failed] != CompiledTank::no_parent &&
+               (kind[parent[failed]] == CapacitorKind::Series || slot_begin[parent[failed] + 1] - slot_begin[parent[failed]] == 1))
+        {
+            failed = parent[failed];
+        }
+        if (parent[failed] == CompiledTank::no_parent)
+        {
+            scenario.tank_open = true;
+            result.scenarios.push_back(scenario);
+            continue;
+        }
+
+        // Upward: reactance and limits of the groups from the failure to the root.
+        path.clear();
+        uint32_t group = parent[failed];
+        Aggregate survivors = without(failed);
+        path.push_back({group, admittance(survivors.term), survivors.i_max, survivors.v_max, survivors.power_max, survivors});
+        while (parent[group] != CompiledTank::no_parent)
+        {
+            const PathNode &changed = path.back();
+            uint32_t p = parent[group];
+            Aggregate others = without(group);
+            Aggregate all = combine(kind[p], others,
+                                    member(kind[p], changed.xc, changed.i_max, changed.v_max, changed.power_max, Peaks{}));
+            path.push_back({p, kind[p] == CapacitorKind::Parallel ? admittance(all.term) : all.term,
+                            all.i_max, all.v_max, all.power_max, others});
+            group = p;
+        }
+
+        // Downward: the drive current from the root to the failure; the members off the path scale with
+        // the current (series group) or voltage (parallel group) of their group.
+        Peaks peaks;
+        double node_current = options.current;
+        for (size_t k = path.size(); k-- > 0;)
+        {
+            const PathNode &node = path[k];
+            double node_voltage = reactance_voltage(node_current, node.xc);
+            peaks = higher(peaks, Peaks{{node.node, node_current / node.i_max},
+                                        {node.node, node_voltage / node.v_max},
+                                        {node.node, node_current * node_voltage / node.power_max}});
+
+            bool parallel = kind[node.node] == CapacitorKind::Parallel;
+            double scale = parallel ? ratio(node_voltage, voltage[node.node]) : ratio(node_current, current[node.node]);
+            peaks = higher(peaks, scaled(node.others.peaks, scale));
+
+            if (k > 0)
+            {
+                node_current = parallel ? reactance_current(node_voltage, path[k - 1].xc) : node_current;
+            }
+        }
+        scenario.current = peaks.current;
+        scenario.voltage = peaks.voltage;
+        scenario.power = peaks.power;
+        result.scenarios.push_back(scenario);
+    }
+    return result;
+}
@@ -0,0 +1,130 @@
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "capacitor_harmonics.h"
+#include "capacitor_lanes.h"
+
+static void check_frequency(double frequency)
+{
+    if (!(frequency > 0))
+    {
+        throw std::invalid_argument("Harmonic frequencies must be positive.");
+    }
+}
+
+HarmonicEvaluator::HarmonicEvaluator(const CompiledTank &tank)
+    : tank(tank), _response(tank), _current(tank.size()), _voltage(tank.size()), _reactive_power(tank.size())
+{
+}
+
+double HarmonicEvaluator::evaluate(const Harmonic *harmonics, size_t count)
+{
+    using Block = SweepLanes<double>;
+
+    // Harmonics are stored as (frequency, current) pairs; gather a block of each.
+    Block current_squares(0.0);
+    Block reduced_squares(0.0);
+    Block reactive(0.0);
+    double f[Block::size];
+    double i[Block::size];
+    size_t h = 0;
+    for (; h + Block::size <= count; h += Block::size)
+    {
+        for (size_t lane = 0; lane < Block::size; ++lane)
+        {
+            check_frequency(harmonics[h + lane].frequency);
+            f[lane] = harmonics[h + lane].frequency;
+            i[lane] = harmonics[h + lane].current;
+        }
+        Block frequency = Block::load(f);
+        Block current = Block::load(i);
+        Block square = current * current;
+        Block reduced = current / frequency;
+        current_squares = current_squares + square;
+        reduced_squares = reduced_squares + reduced * reduced;
+        reactive = reactive + square / frequency;
+    }
+
+    double sum_current = 0.0;
+    double sum_reduced = 0.0;
+    double sum_reactive = 0.0;
+    for (size_t lane = 0; lane < Block::size; ++lane)
+    {
+        sum_current += current_squares[lane];
+        sum_reduced += reduced_squares[lane];
+        sum_reactive += reactive[lane];
+    }
+    for (; h < count; ++h)
+    {
+        check_frequency(harmonics[h].frequency);
+        double current = harmonics[h].current;
+        double reduced = current / harmonics[h].frequency;
+        sum_current += current * current;
+        sum_reduced += reduced * reduced;
+        sum_reactive += current * current / harmonics[h].frequency;
+    }
+
+    double rms_current = std::sqrt(sum_current);
+    double rms_reduced = std::sqrt(sum_reduced);
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        _current[n] = _response.current_share[n] * rms_current;
+        _voltage[n] = _response.unit_voltage[n] * rms_reduced;
+        _reactive_power[n] = _response.current_share[n] * _response.unit_voltage[n] * sum_reactive;
+    }
+    return rms_current;
+}
+
+void HarmonicEvaluator::check_limits(ViolationReport &report) const
+{
+    const double *i_max = tank.i_max().data();
+    const double *v_max = tank.v_max().data();
+    const double *power_max = tank.power_max().data();
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        uint32_t node = static_cast<uint32_t>(n);
+        if (_current[n] > i_max[n])
+        {
+            report.record(node, ViolationKind::Overcurrent, _current[n], i_max[n]);
+        }
+        if (_voltage[n] > v_max[n])
+        {
+            report.record(node, ViolationKind::Overvoltage, _voltage[n], v_max[n]);
+        }
+        if (_reactive_power[n] > power_max[n])
+        {
+            report.record(node, ViolationKind::Overpower, _reactive_power[n], power_max[n]);
+        }
+    }
+}
+
+double HarmonicEvaluator::allowed_current() const
+{
+    // Without current there is no spectrum shape to scale.
+    double root_current = _current[tank.root()];
+    if (root_current == 0)
+    {
+        return 0.0;
+    }
+
+    // Scaling the spectrum by s scales currents and voltages by s and the reactive power by s^2.
+    double scale = HUGE_VAL;
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        if (_current[n] > 0)
+        {
+            scale = std::min(scale, tank.i_max()[n] / _current[n]);
+        }
+        if (_voltage[n] > 0)
+        {
+            scale = std::min(scale, tank.v_max()[n] / _voltage[n]);
+        }
+        if (_reactive_power[n] > 0)
+        {
+            scale = std::min(scale, std::sqrt(tank.power_max()[n] / _reactive_power[n]));
+        }
+    }
+    return scale * root_current;
+}
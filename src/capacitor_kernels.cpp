@@ -0,0 +1,120 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#include "capacitor_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CAPACITOR_KERNELS_X86
+#endif
+
+#define KERNEL_NAMESPACE scalar_kernels
+#define KERNEL_WIDTH 1
+#define KERNEL_ISA KernelIsa::Scalar
+#include "capacitor_kernels_impl.h"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_WIDTH
+#undef KERNEL_ISA
+
+#ifdef CAPACITOR_KERNELS_X86
+
+// SSE2 is part of the x86-64 baseline, so these need no target.
+#define KERNEL_NAMESPACE sse2_kernels
+#define KERNEL_WIDTH 2
+#define KERNEL_ISA KernelIsa::SSE2
+#include "capacitor_kernels_impl.h"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_WIDTH
+#undef KERNEL_ISA
+
+// No FMA in the targets: contracted multiply-adds would round differently from the scalar formulas.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#define KERNEL_NAMESPACE avx2_kernels
+#define KERNEL_WIDTH 4
+#define KERNEL_ISA KernelIsa::AVX2
+#include "capacitor_kernels_impl.h"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_WIDTH
+#undef KERNEL_ISA
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+#define KERNEL_NAMESPACE avx512_kernels
+#define KERNEL_WIDTH 8
+#define KERNEL_ISA KernelIsa::AVX512
+#include "capacitor_kernels_impl.h"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_WIDTH
+#undef KERNEL_ISA
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // CAPACITOR_KERNELS_X86
+
+const CapacitorKernels *capacitor_kernels(KernelIsa isa)
+{
+    switch (isa)
+    {
+    case KernelIsa::Scalar:
+        return &scalar_kernels::kernels;
+#ifdef CAPACITOR_KERNELS_X86
+    case KernelIsa::SSE2:
+        return __builtin_cpu_supports("sse2") ? &sse2_kernels::kernels : nullptr;
+    case KernelIsa::AVX2:
+        return __builtin_cpu_supports("avx2") ? &avx2_kernels::kernels : nullptr;
+    case KernelIsa::AVX512:
+        return __builtin_cpu_supports("avx512f") ? &avx512_kernels::kernels : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const CapacitorKernels &capacitor_kernels()
+{
+    static const CapacitorKernels &selected = []() -> const CapacitorKernels & {
+        for (KernelIsa isa : {KernelIsa::AVX512, KernelIsa::AVX2, KernelIsa::SSE2})
+        {
+            if (const CapacitorKernels *kernels = capacitor_kernels(isa))
+            {
+                return *kernels;
+            }
+        }
+        return scalar_kernels::kernels;
+    }();
+    return selected;
+}
+
+const char *kernel_isa_name(KernelIsa isa)
+{
+    switch (isa)
+    {
+    case KernelIsa::Scalar:
+        return "scalar";
+    case KernelIsa::SSE2:
+        return "sse2";
+    case KernelIsa::AVX2:
+        return "avx2";
+    case KernelIsa::AVX512:
+        return "avx512";
+    }
+    return "unknown";
+}
@@ -0,0 +1,140 @@
+// Kernel bodies, included by capacitor_kernels.cpp once per instruction set with KERNEL_NAMESPACE and
+// KERNEL_WIDTH (doubles per vector) defined and the matching target enabled. No include guard on purpose.
+
+namespace KERNEL_NAMESPACE {
+
+typedef double vec __attribute__((vector_size(KERNEL_WIDTH * sizeof(double))));
+typedef int64_t mask __attribute__((vector_size(KERNEL_WIDTH * sizeof(double))));
+constexpr size_t width = KERNEL_WIDTH;
+
+inline vec load(const double *p)
+{
+    vec v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void store(double *p, vec v)
+{
+    std::memcpy(p, &v, sizeof(v));
+}
+
+inline vec splat(double x)
+{
+    return vec{} + x;
+}
+
+inline double lane_sum(vec v)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < width; ++i)
+    {
+        sum += v[i];
+    }
+    return sum;
+}
+
+void xc(const double *f, const double *cap_F, double *xc, size_t n)
+{
+    const vec two_pi = splat(2 * M_PI);
+    size_t k = 0;
+    for (; k + width <= n; k += width)
+    {
+        store(xc + k, 1 / (two_pi * load(f + k) * load(cap_F + k)));
+    }
+    for (; k < n; ++k)
+    {
+        xc[k] = 1 / (2 * M_PI * f[k] * cap_F[k]);
+    }
+}
+
+double parallel_xc(const double *xc, size_t n)
+{
+    vec sum = splat(0.0);
+    size_t k = 0;
+    for (; k + width <= n; k += width)
+    {
+        sum += 1.0 / load(xc + k);
+    }
+    double reciprocal = lane_sum(sum);
+    for (; k < n; ++k)
+    {
+        reciprocal += 1.0 / xc[k];
+    }
+    return 1.0 / reciprocal;
+}
+
+double series_xc(const double *xc, size_t n)
+{
+    vec sum = splat(0.0);
+    size_t k = 0;
+    for (; k + width <= n; k += width)
+    {
+        sum += load(xc + k);
+    }
+    double total = lane_sum(sum);
+    for (; k < n; ++k)
+    {
+        total += xc[k];
+    }
+    return total;
+}
+
+void current(const double *voltage, const double *xc, double *current, double *power, size_t n)
+{
+    size_t k = 0;
+    for (; k + width <= n; k += width)
+    {
+        vec v = load(voltage + k);
+        vec i = v / load(xc + k);
+        store(current + k, i);
+        store(power + k, i * v);
+    }
+    for (; k < n; ++k)
+    {
+        current[k] = voltage[k] / xc[k];
+        power[k] = current[k] * voltage[k];
+    }
+}
+
+void voltage(const double *current, const double *xc, double *voltage, double *power, size_t n)
+{
+    size_t k = 0;
+    for (; k + width <= n; k += width)
+    {
+        vec i = load(current + k);
+        vec v = i * load(xc + k);
+        store(voltage + k, v);
+        store(power + k, i * v);
+    }
+    for (; k < n; ++k)
+    {
+        voltage[k] = current[k] * xc[k];
+        power[k] = current[k] * voltage[k];
+    }
+}
+
+size_t exceeds(const double *value, const double *limit, uint8_t *exceeded, size_t n)
+{
+    size_t count = 0;
+    size_t k = 0;
+    for (; k + width <= n; k += width)
+    {
+        mask m = load(value + k) > load(limit + k);
+        for (size_t i = 0; i < width; ++i)
+        {
+            exceeded[k + i] = m[i] != 0;
+            count += m[i] != 0;
+        }
+    }
+    for (; k < n; ++k)
+    {
+        exceeded[k] = value[k] > limit[k];
+        count += exceeded[k];
+    }
+    return count;
+}
+
+const CapacitorKernels kernels = {KERNEL_ISA, xc, parallel_xc, series_xc, current, voltage, exceeds};
+
+} // namespace KERNEL_NAMESPACE
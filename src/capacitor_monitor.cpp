@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "capacitor_monitor.h"
+
+namespace {
+
+constexpr uint32_t ring_magic = 0x54524e47;
+
+// Evaluates one update, hands its events to the callback and records the time spent.
+inline void monitor_update(TankMonitor &monitor, const TelemetrySample &sample, const MonitorEventCallback &on_event,
+                           MonitorStats &stats)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (monitor.update(sample) > 0)
+    {
+        for (const MonitorEvent &event : monitor)
+        {
+            on_event(event);
+            ++stats.events;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stats.latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    ++stats.updates;
+}
+
+}
+
+TankMonitor::TankMonitor(const CompiledTank &tank, const MonitorOptions &options)
+    : tank(tank), options(options), _response(tank), _active(3 * tank.size()),
+      _count(3 * tank.size()), _events(3 * tank.size())
+{
+    if (!(options.hysteresis >= 0 && options.hysteresis < 1) || options.debounce == 0)
+    {
+        throw std::invalid_argument("Monitor hysteresis must be within [0, 1) and debounce at least 1.");
+    }
+}
+
+void TankMonitor::_check(uint32_t node, ViolationKind kind, double value, double limit) noexcept
+{
+    size_t slot = 3 * node + static_cast<size_t>(kind);
+    bool beyond = _active[slot] ? value < limit * (1 - options.hysteresis) : value > limit;
+    if (!beyond)
+    {
+        _count[slot] = 0;
+        return;
+    }
+    if (++_count[slot] < options.debounce)
+    {
+        return;
+    }
+    _count[slot] = 0;
+    _active[slot] ^= 1;
+    _events[_event_count++] = {_updates, _active[slot] != 0, {node, kind, value, limit}};
+}
+
+size_t TankMonitor::update(const TelemetrySample &sample) noexcept
+{
+    _event_count = 0;
+    if (!(sample.frequency > 0) || !std::isfinite(sample.frequency) || !std::isfinite(sample.current))
+    {
+        ++_invalid;
+        return 0;
+    }
+
+    double current = sample.current;
+    double per_frequency = current / sample.frequency;
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        uint32_t node = static_cast<uint32_t>(n);
+        double node_current = _response.current_share[n] * current;
+        double node_voltage = _response.unit_voltage[n] * per_frequency;
+        _check(node, ViolationKind::Overcurrent, node_current, tank.i_max()[n]);
+        _check(node, ViolationKind::Overvoltage, node_voltage, tank.v_max()[n]);
+        _check(node, ViolationKind::Overpower, node_current * node_voltage, tank.power_max()[n]);
+    }
+    ++_updates;
+    return _event_count;
+}
+
+void TelemetryRing::_map(int fd, size_t size)
+{
+    void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        throw std::runtime_error("Cannot map telemetry ring " + _name + ": " + std::strerror(errno));
+    }
+    _mapped = size;
+    _header = static_cast<Header *>(memory);
+    _samples = reinterpret_cast<TelemetrySample *>(static_cast<char *>(memory) + sizeof(Header));
+}
+
+TelemetryRing::TelemetryRing(const std::string &name, size_t capacity) : _name(name), _owner(true)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        throw std::invalid_argument("Telemetry ring capacity must be a power of two.");
+    }
+
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    size_t size = sizeof(Header) + capacity * sizeof(TelemetrySample);
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        std::string error = std::strerror(errno);
+        if (fd >= 0)
+        {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+        }
+        throw std::runtime_error("Cannot create telemetry ring " + name + ": " + error);
+    }
+    _map(fd, size);
+
+    // The new memory is zero filled. The magic is released after the capacity, so a producer opening the
+    // ring early either sees no magic or sees the capacity too.
+    _header->capacity = capacity;
+    _header->magic.store(ring_magic, std::memory_order_release);
+    _mask = capacity - 1;
+}
+
+TelemetryRing::TelemetryRing(const std::string &name) : _name(name)
+{
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    struct stat status;
+    if (fd < 0 || ::fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Header))
+    {
+        std::string error = fd < 0 ? std::strerror(errno) : "not a telemetry ring";
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        throw std::runtime_error("Cannot open telemetry ring " + name + ": " + error);
+    }
+    _map(fd, static_cast<size_t>(status.st_size));
+
+    // Acquired before the capacity, which the creator writes before releasing the magic.
+    bool ready = _header->magic.load(std::memory_order_acquire) == ring_magic;
+    uint64_t capacity = _header->capacity;
+    if (!ready || sizeof(Header) + capacity * sizeof(TelemetrySample) != _mapped)
+    {
+        ::munmap(_header, _mapped);
+        throw std::runtime_error("Cannot open telemetry ring " + name + ": not a telemetry ring");
+    }
+    _mask = capacity - 1;
+}
+
+TelemetryRing::~TelemetryRing()
+{
+    ::munmap(_header, _mapped);
+    if (_owner)
+    {
+        ::shm_unlink(_name.c_str());
+    }
+}
+
+bool TelemetryRing::push(const TelemetrySample &sample) noexcept
+{
+    uint64_t head = _header->head.load(std::memory_order_relaxed);
+    if (head - _header->tail.load(std::memory_order_acquire) > _mask)
+    {
+        return false;
+    }
+    _samples[head & _mask] = sample;
+    _header->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void TelemetryRing::close() noexcept
+{
+    _header->closed.store(1, std::memory_order_release);
+}
+
+size_t TelemetryRing::pop(TelemetrySample *out, size_t count) noexcept
+{
+    uint64_t tail = _header->tail.load(std::memory_order_relaxed);
+    size_t available = static_cast<size_t>(_header->head.load(std::memory_order_acquire) - tail);
+    count = std::min(count, available);
+    for (size_t k = 0; k < count; ++k)
+    {
+        out[k] = _samples[(tail + k) & _mask];
+    }
+    _header->tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+bool TelemetryRing::closed() const noexcept
+{
+    return _header->closed.load(std::memory_order_acquire) != 0;
+}
+
+MonitorStats run_monitor(TankMonitor &monitor, int fd, const MonitorEventCallback &on_event)
+{
+    MonitorStats stats;
+    constexpr size_t buffer_samples = 4096;
+    std::vector<TelemetrySample> buffer(buffer_samples);
+    char *bytes = reinterpret_cast<char *>(buffer.data());
+
+    // A read may end within a record; its start is kept for the next read.
+    size_t filled = 0;
+    while (true)
+    {
+        ssize_t received = ::read(fd, bytes + filled, buffer_samples * sizeof(TelemetrySample) - filled);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            break;
+        }
+        filled += static_cast<size_t>(received);
+        size_t complete = filled / sizeof(TelemetrySample);
+        for (size_t k = 0; k < complete; ++k)
+        {
+            monitor_update(monitor, buffer[k], on_event, stats);
+        }
+        size_t rest = filled - complete * sizeof(TelemetrySample);
+        std::memmove(bytes, bytes + complete * sizeof(TelemetrySample), rest);
+        filled = rest;
+    }
+    return stats;
+}
+
+MonitorStats run_monitor(TankMonitor &monitor, TelemetryRing &ring, const MonitorEventCallback &on_event)
+{
+    MonitorStats stats;
+    constexpr size_t batch_samples = 256;
+    TelemetrySample batch[batch_samples];
+    while (true)
+    {
+        // closed() is read before pop(), so samples pushed before the close are never missed.
+        bool closed = ring.closed();
+        size_t count = ring.pop(batch, batch_samples);
+        for (size_t k = 0; k < count; ++k)
+        {
+            monitor_update(monitor, batch[k], on_event, stats);
+        }
+        if (count == 0)
+        {
+            if (closed)
+            {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,445 @@
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+#include "capacitor_monte_carlo.h"
+#include "capacitor_kernels.h"
+#include "thread_pool.h"
+
+namespace {
+
+// Samples evaluated together; every node is one row of this many values.
+constexpr size_t block = 64;
+
+// Current histogram: log2(current / nominal current) in [-histogram_range, histogram_range].
+constexpr size_t histogram_bins = 1024;
+constexpr double histogram_range = 2.0;
+constexpr double bin_width = 2 * histogram_range / histogram_bins;
+
+// Random streams of a node in a sample.
+constexpr uint32_t capacitance_stream = 0;
+constexpr uint32_t limits_stream = 1;
+
+// Four factors of one node in one sample, from one generator call.
+void factors(const MonteCarloOptions &options, const Tolerance &tolerance, uint64_t sample, uint32_t node,
+             uint32_t stream, double out[4])
+{
+    std::array<uint32_t, 4> words = philox4x32(
+        {static_cast<uint32_t>(sample), static_cast<uint32_t>(sample >> 32), node, stream},
+        {static_cast<uint32_t>(options.seed), static_cast<uint32_t>(options.seed >> 32)});
+
+    double u[4];
+    for (int k = 0; k < 4; ++k)
+    {
+        u[k] = (words[k] + 0.5) * 0x1p-32; // never 0 or 1
+    }
+
+    if (tolerance.distribution == ToleranceDistribution::Uniform)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            out[k] = 1 + tolerance.spread * (2 * u[k] - 1);
+        }
+    }
+    else
+    {
+        // Box-Muller, two normal values per pair of uniform values.
+        for (int k = 0; k < 4; k += 2)
+        {
+            double r = std::sqrt(-2 * std::log(u[k]));
+            out[k] = 1 + tolerance.spread * r * std::cos(2 * M_PI * u[k + 1]);
+            out[k + 1] = 1 + tolerance.spread * r * std::sin(2 * M_PI * u[k + 1]);
+        }
+    }
+
+    // A part cannot have a negative capacitance or limit, whatever the tail of the distribution says.
+    for (int k = 0; k < 4; ++k)
+    {
+        out[k] = std::max(out[k], 1e-6);
+    }
+}
+
+// Integer statistics of the samples a worker evaluated; merging workers is exact.
+struct Counts
+{
+    std::vector<uint64_t> overcurrent;
+    std::vector<uint64_t> overvoltage;
+    std::vector<uint64_t> overpower;
+    std::vector<uint64_t> violation;
+    std::vector<uint64_t> histogram; // node * histogram_bins + bin
+    std::vector<double> current_min;
+    std::vector<double> current_max;
+    uint64_t tank_violation = 0;
+
+    explicit Counts(size_t nodes)
+        : overcurrent(nodes), overvoltage(nodes), overpower(nodes), violation(nodes),
+          histogram(nodes * histogram_bins), current_min(nodes, HUGE_VAL), current_max(nodes, 0.0)
+    {
+    }
+
+    void merge(const Counts &other)
+    {
+        for (size_t n = 0; n < overcurrent.size(); ++n)
+        {
+            overcurrent[n] += other.overcurrent[n];
+            overvoltage[n] += other.overvoltage[n];
+            overpower[n] += other.overpower[n];
+            violation[n] += other.violation[n];
+            current_min[n] = std::min(current_min[n], other.current_min[n]);
+            current_max[n] = std::max(current_max[n], other.current_max[n]);
+        }
+        for (size_t k = 0; k < histogram.size(); ++k)
+        {
+            histogram[k] += other.histogram[k];
+        }
+        tank_violation += other.tank_violation;
+    }
+};
+
+// Evaluates blocks of samples with the operations of CompiledTankEvaluator::prepare and voltage, each
+// operation applied to a whole row of samples.
+class MonteCarloWorker
+{
+    const CompiledTank &tank;
+    const MonteCarloOptions &options;
+    const std::vector<double> &nominal_current;
+    const CapacitorKernels &kernels;
+    size_t nodes;
+
+    std::vector<double> frequency;
+    std::vector<double> cap_F;
+    std::vector<double> xc;
+    std::vector<double> v_max;
+    std::vector<double> i_max;
+    std::vector<double> power_max;
+    std::vector<double> current;
+    std::vector<double> voltage;
+    std::vector<double> power;
+    std::vector<uint8_t> exceeded;
+    std::vector<uint8_t> node_violation;
+    std::vector<uint8_t> tank_violation;
+
+    double *row(std::vector<double> &values, size_t node) { return values.data() + node * block; }
+
+    void _perturb(uint64_t first_sample)
+    {
+        const CapacitorKind *kind = tank.kind().data();
+        const uint32_t *parent = tank.parent().data();
+        const uint8_t *first_child = tank.first_child().data();
+        bool limits = options.limits.spread != 0.0;
+
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            double *c = row(cap_F, n);
+            double *v = row(v_max, n);
+            double *i = row(i_max, n);
+            double *p = row(power_max, n);
+            if (kind[n] == CapacitorKind::Single)
+            {
+                double factor[4];
+                for (size_t s = 0; s < block; ++s)
+                {
+                    factors(options, options.capacitance, first_sample + s, static_cast<uint32_t>(n), capacitance_stream, factor);
+                    c[s] = tank.cap_F()[n] * factor[0];
+                }
+                if (limits)
+                {
+                    for (size_t s = 0; s < block; ++s)
+                    {
+                        factors(options, options.limits, first_sample + s, static_cast<uint32_t>(n), limits_stream, factor);
+                        v[s] = tank.v_max()[n] * factor[0];
+                        i[s] = tank.i_max()[n] * factor[1];
+                        p[s] = tank.power_max()[n] * factor[2];
+                    }
+                }
+            }
+
+            // Group limits aggregate their members like the ParallelCapacitor and SeriesCapacitor constructors.
+            uint32_t up = parent[n];
+            if (!limits || up == CompiledTank::no_parent)
+            {
+                continue;
+            }
+            double *pv = row(v_max, up);
+            double *pi = row(i_max, up);
+            double *pp = row(power_max, up);
+            bool first = first_child[n];
+            for (size_t s = 0; s < block; ++s)
+            {
+                if (kind[up] == CapacitorKind::Parallel)
+                {
+                    pv[s] = first || v[s] < pv[s] ? v[s] : pv[s];
+                    pi[s] = (first ? 0.0 : pi[s]) + i[s];
+                }
+                else
+                {
+                    pv[s] = (first ? 0.0 : pv[s]) + v[s];
+                    pi[s] = first || i[s] < pi[s] ? i[s] : pi[s];
+                }
+                pp[s] = (first ? 0.0 : pp[s]) + p[s];
+            }
+        }
+    }
+
+    void _evaluate()
+    {
+        const CapacitorKind *kind = tank.kind().data();
+        const uint32_t *parent = tank.parent().data();
+
+        // Reactances bottom-up, groups accumulating their members in place.
+        std::fill(xc.begin(), xc.end(), 0.0);
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            double *x = row(xc, n);
+            if (kind[n] == CapacitorKind::Single)
+            {
+                kernels.xc(frequency.data(), row(cap_F, n), x, block);
+            }
+            else if (kind[n] == CapacitorKind::Parallel)
+            {
+                for (size_t s = 0; s < block; ++s)
+                {
+                    x[s] = 1.0 / x[s];
+                }
+            }
+
+            uint32_t p = parent[n];
+            if (p == CompiledTank::no_parent)
+            {
+                continue;
+            }
+            double *px = row(xc, p);
+            if (kind[p] == CapacitorKind::Parallel)
+            {
+                for (size_t s = 0; s < block; ++s)
+                {
+                    px[s] = px[s] + 1.0 / x[s];
+                }
+            }
+            else
+            {
+                for (size_t s = 0; s < block; ++s)
+                {
+                    px[s] = px[s] + x[s];
+                }
+            }
+        }
+
+        // Currents top-down: series groups pass the current on, parallel groups split it by admittance.
+        for (size_t n = nodes; n-- > 0;)
+        {
+            double *i = row(current, n);
+            double *v = row(voltage, n);
+            const double *x = row(xc, n);
+            uint32_t p = parent[n];
+            if (p == CompiledTank::no_parent)
+            {
+                std::fill(i, i + block, options.current);
+            }
+            else if (kind[p] == CapacitorKind::Parallel)
+            {
+                const double *pv = row(voltage, p);
+                for (size_t s = 0; s < block; ++s)
+                {
+                    i[s] = pv[s] / x[s];
+                }
+            }
+            else
+            {
+                std::copy(row(current, p), row(current, p) + block, i);
+            }
+
+            if (kind[n] == CapacitorKind::Series)
+            {
+                std::fill(v, v + block, 0.0);
+            }
+            else
+            {
+                kernels.voltage(i, x, v, row(power, n), block);
+            }
+        }
+
+        // Series voltages bottom-up.
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            uint32_t p = parent[n];
+            if (p != CompiledTank::no_parent && kind[p] == CapacitorKind::Series)
+            {
+                double *pv = row(voltage, p);
+                const double *v = row(voltage, n);
+                for (size_t s = 0; s < block; ++s)
+                {
+                    pv[s] = pv[s] + v[s];
+                }
+            }
+            if (kind[n] == CapacitorKind::Series)
+            {
+                const double *i = row(current, n);
+                const double *v = row(voltage, n);
+                double *w = row(power, n);
+                for (size_t s = 0; s < block; ++s)
+                {
+                    w[s] = i[s] * v[s];
+                }
+            }
+        }
+    }
+
+    void _count(size_t samples, Counts &counts)
+    {
+        std::fill(tank_violation.begin(), tank_violation.end(), 0);
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            std::fill(node_violation.begin(), node_violation.end(), 0);
+            auto check = [&](const double *value, const double *limit, uint64_t &count) {
+                count += kernels.exceeds(value, limit, exceeded.data(), samples);
+                for (size_t s = 0; s < samples; ++s)
+                {
+                    node_violation[s] |= exceeded[s];
+                }
+            };
+            check(row(current, n), row(i_max, n), counts.overcurrent[n]);
+            check(row(voltage, n), row(v_max, n), counts.overvoltage[n]);
+            check(row(power, n), row(power_max, n), counts.overpower[n]);
+
+            const double *i = row(current, n);
+            uint64_t *histogram = counts.histogram.data() + n * histogram_bins;
+            double nominal = nominal_current[n];
+            for (size_t s = 0; s < samples; ++s)
+            {
+                counts.violation[n] += node_violation[s];
+                tank_violation[s] |= node_violation[s];
+                counts.current_min[n] = std::min(counts.current_min[n], i[s]);
+                counts.current_max[n] = std::max(counts.current_max[n], i[s]);
+
+                // Currents out of range go to the first or last bin, a zero nominal current to the first.
+                double bin = std::floor((std::log2(i[s] / nominal) + histogram_range) / bin_width);
+                ++histogram[bin >= 0 ? static_cast<size_t>(std::min(bin, double(histogram_bins - 1))) : 0];
+            }
+        }
+        for (size_t s = 0; s < samples; ++s)
+        {
+            counts.tank_violation += tank_violation[s];
+        }
+    }
+
+public:
+    MonteCarloWorker(const CompiledTank &tank, const MonteCarloOptions &options, const std::vector<double> &nominal_current)
+        : tank(tank), options(options), nominal_current(nominal_current), kernels(capacitor_kernels()), nodes(tank.size()),
+          frequency(block, options.frequency), cap_F(nodes * block), xc(nodes * block), v_max(nodes * block),
+          i_max(nodes * block), power_max(nodes * block), current(nodes * block), voltage(nodes * block),
+          power(nodes * block), exceeded(block), node_violation(block), tank_violation(block)
+    {
+        // Nominal limits, kept for every sample when the limits are not perturbed.
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            std::fill(row(v_max, n), row(v_max, n) + block, tank.v_max()[n]);
+            std::fill(row(i_max, n), row(i_max, n) + block, tank.i_max()[n]);
+            std::fill(row(power_max, n), row(power_max, n) + block, tank.power_max()[n]);
+        }
+    }
+
+    void run(uint64_t first_sample, size_t samples, Counts &counts)
+    {
+        _perturb(first_sample);
+        _evaluate();
+        _count(samples, counts);
+    }
+};
+
+// Bin centre of the q-quantile, kept within the smallest and largest current seen.
+double percentile(const uint64_t *histogram, uint64_t samples, double q, double nominal, double min, double max)
+{
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(samples))));
+    uint64_t seen = 0;
+    size_t bin = 0;
+    for (; bin + 1 < histogram_bins; ++bin)
+    {
+        seen += histogram[bin];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    return std::clamp(nominal * std::exp2((bin + 0.5) * bin_width - histogram_range), min, max);
+}
+
+} // namespace
+
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key)
+{
+    for (int round = 0; round < 10; ++round)
+    {
+        uint64_t product0 = uint64_t(0xD2511F53) * counter[0];
+        uint64_t product1 = uint64_t(0xCD9E8D57) * counter[2];
+        counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(product1),
+                   static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(product0)};
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+    }
+    return counter;
+}
+
+MonteCarloResult run_monte_carlo(const CompiledTank &tank, const MonteCarloOptions &options)
+{
+    MonteCarloResult result;
+    result.samples = options.samples;
+    if (tank.size() == 0 || options.samples == 0)
+    {
+        return result;
+    }
+
+    // The histogram is relative to the currents of the nominal tank.
+    CompiledTankEvaluator nominal(tank);
+    nominal.voltage(options.frequency, options.current);
+    const std::vector<double> &nominal_current = nominal.node_current();
+
+    uint64_t blocks = (options.samples + block - 1) / block;
+    std::atomic<uint64_t> next_block(0);
+
+    ThreadPool pool(options.threads);
+    std::vector<std::unique_ptr<Counts>> counts;
+    for (size_t k = 0; k < pool.size(); ++k)
+    {
+        counts.push_back(std::make_unique<Counts>(tank.size()));
+        Counts *worker_counts = counts.back().get();
+        pool.submit([&, worker_counts]() {
+            MonteCarloWorker worker(tank, options, nominal_current);
+            for (uint64_t b = next_block.fetch_add(1); b < blocks; b = next_block.fetch_add(1))
+            {
+                uint64_t first = b * block;
+                worker.run(first, static_cast<size_t>(std::min<uint64_t>(block, options.samples - first)), *worker_counts);
+            }
+        });
+    }
+    pool.wait();
+
+    Counts &total = *counts.front();
+    for (size_t k = 1; k < counts.size(); ++k)
+    {
+        total.merge(*counts[k]);
+    }
+
+    double samples = static_cast<double>(options.samples);
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        const uint64_t *histogram = total.histogram.data() + n * histogram_bins;
+        NodeStatistics node;
+        node.name = tank.names()[n];
+        node.nominal_current = nominal_current[n];
+        node.current_p50 = percentile(histogram, options.samples, 0.5, nominal_current[n], total.current_min[n], total.current_max[n]);
+        node.current_p95 = percentile(histogram, options.samples, 0.95, nominal_current[n], total.current_min[n], total.current_max[n]);
+        node.current_p99 = percentile(histogram, options.samples, 0.99, nominal_current[n], total.current_min[n], total.current_max[n]);
+        node.current_max = total.current_max[n];
+        node.overcurrent_probability = total.overcurrent[n] / samples;
+        node.overvoltage_probability = total.overvoltage[n] / samples;
+        node.overpower_probability = total.overpower[n] / samples;
+        node.violation_probability = total.violation[n] / samples;
+        result.nodes.push_back(node);
+    }
+    result.violation_probability = total.tank_violation / samples;
+
+    return result;
+}
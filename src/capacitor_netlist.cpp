@@ -0,0 +1,409 @@
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "capacitor_netlist.h"
+
+namespace {
+
+// Repetitions above this are almost certainly a typo and would only exhaust memory.
+constexpr unsigned long max_count = 1000000;
+// Nodes of the expanded tree, as CompiledTank lays it out, repeats multiplying through the levels. About
+// 110 bytes each once compiled and evaluated.
+constexpr uint64_t max_nodes = 4000000;
+
+struct OpenGroup
+{
+    CapacitorKind kind;
+    std::string name;
+    size_t pending_begin;
+    // Expanded nodes of the members added so far.
+    uint64_t nodes;
+};
+
+} // namespace
+
+// Assembles the composite bottom-up: finished nodes wait in `pending` until the group holding them closes.
+class NetlistBuilder
+{
+    std::unordered_map<std::string, const CapacitorSpecification *> catalog_index;
+    std::unordered_map<std::string, Capacitor *> parts;
+    // Expanded nodes of every group built, parts being a single node.
+    std::unordered_map<const CapacitorInterface *, uint64_t> group_nodes;
+    std::vector<CapacitorInterface *> pending;
+    std::vector<CapacitorInterface *> children;
+    TankNetlist netlist;
+
+public:
+    std::vector<OpenGroup> groups;
+
+    explicit NetlistBuilder(const std::vector<CapacitorSpecification> &catalog)
+    {
+        for (auto &spec : catalog)
+        {
+            catalog_index[spec.name] = &spec;
+        }
+    }
+
+    // One Capacitor per part used, built like TankCalculator::compose_capacitors_tank. nullptr when unknown.
+    CapacitorInterface *part(const std::string &name)
+    {
+        auto found = parts.find(name);
+        if (found != parts.end())
+        {
+            return found->second;
+        }
+        auto spec = catalog_index.find(name);
+        if (spec == catalog_index.end())
+        {
+            return nullptr;
+        }
+        const CapacitorSpecification &s = *spec->second;
+        netlist._capacitors.emplace_back(s.capacitance * 1e6, s.voltage, s.current, s.power, s.name);
+        parts[name] = &netlist._capacitors.back();
+        return &netlist._capacitors.back();
+    }
+
+    void open(CapacitorKind kind, std::string name)
+    {
+        groups.push_back({kind, std::move(name), pending.size(), 0});
+    }
+
+    // Adds count repeats of node to the innermost open group. False, adding nothing, when the tank would
+    // expand to more than max_nodes nodes.
+    bool add(CapacitorInterface *node, size_t count)
+    {
+        auto found = group_nodes.find(node);
+        uint64_t nodes = count * (found != group_nodes.end() ? found->second : 1);
+        uint64_t total = nodes + (groups.empty() ? 0 : groups.back().nodes);
+        if (total > max_nodes)
+        {
+            return false;
+        }
+        if (!groups.empty())
+        {
+            groups.back().nodes = total;
+        }
+        pending.insert(pending.end(), count, node);
+        return true;
+    }
+
+    // Builds the innermost open group from the nodes added since it was opened. nullptr when it is empty.
+    CapacitorInterface *close()
+    {
+        OpenGroup group = std::move(groups.back());
+        groups.pop_back();
+        if (pending.size() == group.pending_begin)
+        {
+            return nullptr;
+        }
+
+        children.assign(pending.begin() + group.pending_begin, pending.end());
+        pending.resize(group.pending_begin);
+        CapacitorInterface *node;
+        if (group.kind == CapacitorKind::Parallel)
+        {
+            netlist._parallel.emplace_back(children, group.name);
+            node = &netlist._parallel.back();
+        }
+        else
+        {
+            netlist._series.emplace_back(children, group.name);
+            node = &netlist._series.back();
+        }
+        group_nodes[node] = group.nodes + 1;
+        return node;
+    }
+
+    // The netlist, once exactly one root node is left.
+    TankNetlist finish()
+    {
+        if (pending.size() != 1 || !groups.empty())
+        {
+            throw std::invalid_argument("Netlist error: the root must be a single node");
+        }
+        netlist._root = pending.front();
+        return std::move(netlist);
+    }
+};
+
+namespace {
+
+class TextParser
+{
+    const std::string &text;
+    size_t pos = 0;
+
+    [[noreturn]] void _error(const std::string &message) const
+    {
+        throw std::invalid_argument("Netlist error at offset " + std::to_string(pos) + ": " + message);
+    }
+
+    void _skip()
+    {
+        while (pos < text.size())
+        {
+            if (std::isspace(static_cast<unsigned char>(text[pos])))
+            {
+                ++pos;
+            }
+            else if (text[pos] == '#')
+            {
+                while (pos < text.size() && text[pos] != '\n')
+                {
+                    ++pos;
+                }
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    bool _accept(char c)
+    {
+        _skip();
+        if (pos < text.size() && text[pos] == c)
+        {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    std::string _identifier()
+    {
+        _skip();
+        size_t begin = pos;
+        while (pos < text.size() && !std::isspace(static_cast<unsigned char>(text[pos])) &&
+               std::string("(),*[]#").find(text[pos]) == std::string::npos)
+        {
+            ++pos;
+        }
+        if (pos == begin)
+        {
+            _error(pos < text.size() ? std::string("unexpected '") + text[pos] + "'" : "unexpected end of netlist");
+        }
+        return text.substr(begin, pos - begin);
+    }
+
+    size_t _count()
+    {
+        if (!_accept('*'))
+        {
+            return 1;
+        }
+        _skip();
+        size_t begin = pos;
+        unsigned long count = 0;
+        while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])) && count <= max_count)
+        {
+            count = count * 10 + static_cast<unsigned long>(text[pos++] - '0');
+        }
+        if (pos == begin || count < 1 || count > max_count)
+        {
+            pos = begin;
+            _error("repetition count must be 1 to " + std::to_string(max_count));
+        }
+        return count;
+    }
+
+    void _add(NetlistBuilder &builder, CapacitorInterface *node)
+    {
+        size_t begin = pos;
+        size_t count = _count();
+        if (!builder.add(node, count))
+        {
+            pos = begin;
+            _skip();
+            _error("the tank expands to more than " + std::to_string(max_nodes) + " nodes");
+        }
+    }
+
+public:
+    explicit TextParser(const std::string &text) : text(text) {}
+
+    TankNetlist parse(NetlistBuilder &builder)
+    {
+        for (;;)
+        {
+            // A node starts here: a group opens or a part is added.
+            size_t begin = pos;
+            std::string name = _identifier();
+            _skip();
+            bool group = (name == "series" || name == "parallel") && pos < text.size() && (text[pos] == '(' || text[pos] == '[');
+            if (group)
+            {
+                std::string group_name;
+                if (_accept('['))
+                {
+                    group_name = _identifier();
+                    if (!_accept(']'))
+                    {
+                        _error("expected ']'");
+                    }
+                }
+                if (!_accept('('))
+                {
+                    _error("expected '('");
+                }
+                builder.open(name == "series" ? CapacitorKind::Series : CapacitorKind::Parallel, group_name);
+                _skip();
+                if (pos < text.size() && text[pos] == ')')
+                {
+                    _error("empty group");
+                }
+                continue;
+            }
+
+            CapacitorInterface *part = builder.part(name);
+            if (!part)
+            {
+                pos = begin;
+                _skip();
+                _error("capacitor " + name + " not found in the specification file");
+            }
+            _add(builder, part);
+
+            // Close every group ending here, then expect the next sibling or the end.
+            for (;;)
+            {
+                if (builder.groups.empty())
+                {
+                    _skip();
+                    if (pos != text.size())
+                    {
+                        _error("expected end of netlist");
+                    }
+                    return builder.finish();
+                }
+                if (_accept(','))
+                {
+                    break;
+                }
+                if (!_accept(')'))
+                {
+                    _error("expected ',' or ')'");
+                }
+                CapacitorInterface *closed = builder.close();
+                if (!closed)
+                {
+                    _error("empty group");
+                }
+                _add(builder, closed);
+            }
+        }
+    }
+};
+
+// Position in one array of nodes of the JSON netlist; the root frame has no array and holds the root only.
+struct JsonFrame
+{
+    const json *nodes;
+    size_t next;
+};
+
+[[noreturn]] void json_error(const std::string &message)
+{
+    throw std::invalid_argument("Netlist error: " + message);
+}
+
+size_t json_count(const json &node)
+{
+    if (!node.contains("count"))
+    {
+        return 1;
+    }
+    const json &count = node.at("count");
+    if (!count.is_number_integer() || count.get<long long>() < 1 || count.get<long long>() > static_cast<long long>(max_count))
+    {
+        json_error("repetition count must be 1 to " + std::to_string(max_count));
+    }
+    return count.get<size_t>();
+}
+
+} // namespace
+
+TankNetlist parse_netlist_text(const std::string &text, const std::vector<CapacitorSpecification> &catalog)
+{
+    NetlistBuilder builder(catalog);
+    TextParser parser(text);
+    return parser.parse(builder);
+}
+
+TankNetlist parse_netlist_json(const json &netlist, const std::vector<CapacitorSpecification> &catalog)
+{
+    NetlistBuilder builder(catalog);
+    std::vector<JsonFrame> stack{{nullptr, 0}};
+    std::vector<size_t> counts;
+
+    while (!stack.empty())
+    {
+        JsonFrame &frame = stack.back();
+        if (frame.next == (frame.nodes ? frame.nodes->size() : 1))
+        {
+            stack.pop_back();
+            if (stack.empty())
+            {
+                break;
+            }
+            CapacitorInterface *closed = builder.close();
+            if (!closed)
+            {
+                json_error("empty group");
+            }
+            if (!builder.add(closed, counts.back()))
+            {
+                json_error("the tank expands to more than " + std::to_string(max_nodes) + " nodes");
+            }
+            counts.pop_back();
+            continue;
+        }
+
+        const json &node = frame.nodes ? (*frame.nodes)[frame.next] : netlist;
+        ++frame.next;
+        std::string name;
+        if (node.is_string())
+        {
+            name = node.get<std::string>();
+        }
+        else if (node.is_object() && node.contains("part") && node.at("part").is_string())
+        {
+            name = node.at("part").get<std::string>();
+        }
+        else if (node.is_object() && (node.contains("series") || node.contains("parallel")))
+        {
+            bool series = node.contains("series");
+            const json &nodes = node.at(series ? "series" : "parallel");
+            if (!nodes.is_array())
+            {
+                json_error("group members must be an array");
+            }
+            std::string group_name = node.contains("name") ? node.at("name").get<std::string>() : "";
+            counts.push_back(json_count(node));
+            builder.open(series ? CapacitorKind::Series : CapacitorKind::Parallel, group_name);
+            stack.push_back({&nodes, 0});
+            continue;
+        }
+        else
+        {
+            json_error("a node must be a part name, a part or a group: " + node.dump());
+        }
+
+        CapacitorInterface *part = builder.part(name);
+        if (!part)
+        {
+            json_error("capacitor " + name + " not found in the specification file");
+        }
+        if (!builder.add(part, node.is_object() ? json_count(node) : 1))
+        {
+            json_error("the tank expands to more than " + std::to_string(max_nodes) + " nodes");
+        }
+    }
+
+    return builder.finish();
+}
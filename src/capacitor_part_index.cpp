@@ -0,0 +1,64 @@
+#include <string>
+#include <vector>
+
+#include "capacitor_catalog.h"
+#include "capacitor_part_index.h"
+#include "capacitor_tank.h"
+
+PartIndex::PartIndex(const std::vector<CapacitorSpecification> &specs)
+{
+    // Reserved up front, so the views of _ids and _names stay valid while names are added.
+    _owned_names.reserve(specs.size());
+    _ids.reserve(specs.size());
+    for (const CapacitorSpecification &spec : specs)
+    {
+        auto it = _ids.find(spec.name);
+        if (it == _ids.end())
+        {
+            _owned_names.push_back(spec.name);
+            _ids.emplace(_owned_names.back(), static_cast<PartId>(_names.size()));
+            _names.push_back(_owned_names.back());
+            _cap_uF.push_back(spec.capacitance * 1e6);
+            _v_max.push_back(spec.voltage);
+            _i_max.push_back(spec.current);
+            _power_max.push_back(spec.power);
+        }
+        else
+        {
+            PartId part = it->second;
+            _cap_uF[part] = spec.capacitance * 1e6;
+            _v_max[part] = spec.voltage;
+            _i_max[part] = spec.current;
+            _power_max[part] = spec.power;
+        }
+    }
+}
+
+PartIndex::PartIndex(std::shared_ptr<const CapacitorCatalog> catalog) : _catalog(std::move(catalog))
+{
+    size_t count = _catalog->size();
+    _names.resize(count);
+    _cap_uF.resize(count);
+    _v_max.resize(count);
+    _i_max.resize(count);
+    _power_max.resize(count);
+    for (size_t part = 0; part < count; ++part)
+    {
+        _names[part] = _catalog->name(part);
+        _cap_uF[part] = _catalog->capacitance()[part] * 1e6;
+        _v_max[part] = _catalog->voltage()[part];
+        _i_max[part] = _catalog->current()[part];
+        _power_max[part] = _catalog->power()[part];
+    }
+}
+
+PartId PartIndex::find(std::string_view name) const
+{
+    if (_catalog)
+    {
+        size_t part = _catalog->find(name);
+        return part == CapacitorCatalog::npos ? no_part : static_cast<PartId>(part);
+    }
+    auto it = _ids.find(name);
+    return it == _ids.end() ? no_part : it->second;
+}
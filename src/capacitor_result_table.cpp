@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <nlohmann/json.hpp>
+
+#include "capacitor_result_table.h"
+
+using json = nlohmann::json;
+
+uint32_t TankResultTable::name_id(const std::string &name)
+{
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it != names.end())
+    {
+        return static_cast<uint32_t>(it - names.begin());
+    }
+    recycled_names.push_back(names, name);
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+void render_console(std::ostream &os, const TankResultTable &table, const ViolationReport *violations)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << std::fixed << std::setprecision(0);
+    for (size_t r = 0; r < table.rows.size(); ++r)
+    {
+        const NodeResult &row = table.rows[r];
+        os << "Capacitor: " << table.names[row.name] <<
+            ", Current: " << row.current <<
+            ", Voltage: " << row.voltage <<
+            ", Power: " << row.power << '\n';
+
+        if (violations)
+        {
+            for (const Violation &violation : *violations)
+            {
+                if (violation.node == r)
+                {
+                    os << format_violation(violation, table.names[row.name]) << '\n';
+                }
+            }
+        }
+    }
+    os.flush();
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void render_csv(std::ostream &os, const TankResultTable &table)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << std::setprecision(std::numeric_limits<double>::max_digits10);
+    os << "name,current,voltage,power\n";
+    for (const NodeResult &row : table.rows)
+    {
+        os << table.names[row.name] << ',' << row.current << ',' << row.voltage << ',' << row.power << '\n';
+    }
+    os.flush();
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void render_json(std::ostream &os, const TankResultTable &table, const ViolationReport *violations)
+{
+    static const char *kinds[] = {"overcurrent", "overvoltage", "overpower"};
+
+    json nodes = json::array();
+    for (const NodeResult &row : table.rows)
+    {
+        nodes.push_back({{"name", table.names[row.name]},
+                         {"current", row.current},
+                         {"voltage", row.voltage},
+                         {"power", row.power}});
+    }
+
+    json output = {{"nodes", nodes}, {"violations", json::array()}};
+    if (violations)
+    {
+        for (const Violation &violation : *violations)
+        {
+            output["violations"].push_back({{"node", violation.node},
+                                            {"kind", kinds[static_cast<int>(violation.kind)]},
+                                            {"value", violation.value},
+                                            {"limit", violation.limit}});
+        }
+    }
+    os << output.dump(2) << std::endl;
+}
@@ -0,0 +1,290 @@
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+#include "capacitor_search.h"
+#include "thread_pool.h"
+
+namespace {
+
+struct Part
+{
+    double cap_uF;
+    double v_max;
+    double i_max;
+    double power_max;
+    uint32_t catalog_index;
+};
+
+// Largest spec of any part from an index to the end of the sorted part list.
+struct SuffixMax
+{
+    std::vector<double> cap_uF;
+    std::vector<double> i_max;
+    std::vector<double> power_max;
+};
+
+struct GroupCandidate
+{
+    std::array<uint32_t, max_group_capacitors> parts;
+    size_t count;
+    double rated_current;
+};
+
+// Ranking order: larger rated current first, ties broken by the part list so results do not depend on threads.
+bool ranks_before(const GroupCandidate &a, const GroupCandidate &b)
+{
+    if (a.rated_current != b.rated_current)
+    {
+        return a.rated_current > b.rated_current;
+    }
+    return std::lexicographical_compare(a.parts.begin(), a.parts.begin() + a.count, b.parts.begin(), b.parts.begin() + b.count);
+}
+
+// Same limits as parallel_group_rated_current, on the running sums of a group.
+double group_rated_current(double omega, double cap_uF, double v_max, double i_max, double power_max)
+{
+    double omega_c = omega * (cap_uF * 1e-6);
+    return std::min({omega_c * v_max, i_max, std::sqrt(power_max * omega_c)});
+}
+
+// Depth-first multiset enumeration for one worker. Parts are sorted by descending v_max, so adding a part
+// never raises the group v_max above the v_max of that part and every bound below is non-increasing along
+// the sibling loop.
+class GroupSearch
+{
+    const std::vector<Part> &parts;
+    const SuffixMax &suffix;
+    double omega;
+    double target;
+    size_t max_size;
+    size_t keep;
+    std::atomic<double> &shared_threshold;
+
+    std::vector<GroupCandidate> heap; // worst ranked at the front
+    GroupCandidate group{};
+
+    double _threshold() const
+    {
+        return std::max(target, shared_threshold.load(std::memory_order_relaxed));
+    }
+
+    void _consider(double rated)
+    {
+        if (rated < target)
+        {
+            return;
+        }
+
+        group.rated_current = rated;
+        if (heap.size() < keep)
+        {
+            heap.push_back(group);
+            std::push_heap(heap.begin(), heap.end(), ranks_before);
+        }
+        else if (ranks_before(group, heap.front()))
+        {
+            std::pop_heap(heap.begin(), heap.end(), ranks_before);
+            heap.back() = group;
+            std::push_heap(heap.begin(), heap.end(), ranks_before);
+        }
+        else
+        {
+            return;
+        }
+
+        if (heap.size() == keep)
+        {
+            double worst = heap.front().rated_current;
+            double current = shared_threshold.load(std::memory_order_relaxed);
+            while (worst > current && !shared_threshold.compare_exchange_weak(current, worst, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+
+public:
+    uint64_t evaluated = 0;
+    uint64_t pruned = 0;
+
+    GroupSearch(const std::vector<Part> &parts, const SuffixMax &suffix, double omega, double target,
+                size_t max_size, size_t keep, std::atomic<double> &shared_threshold)
+        : parts(parts), suffix(suffix), omega(omega), target(target), max_size(max_size), keep(keep),
+          shared_threshold(shared_threshold)
+    {
+        heap.reserve(keep);
+    }
+
+    // Upper bound on the rated current of any group that adds part `index` and up to max_size - depth - 1
+    // further parts from index onwards to the sums of the current prefix.
+    double bound(size_t depth, size_t index, double cap_uF, double v_max, double i_max, double power_max) const
+    {
+        // The relative slack covers the rounding of the bound sums against the sums of a real group.
+        double remaining = static_cast<double>(max_size - depth);
+        double v_bound = depth == 0 ? parts[index].v_max : std::min(v_max, parts[index].v_max);
+        return (1 + 1e-9) * group_rated_current(omega,
+                                                  cap_uF + remaining * suffix.cap_uF[index],
+                                                  v_bound,
+                                                  i_max + remaining * suffix.i_max[index],
+                                                  power_max + remaining * suffix.power_max[index]);
+    }
+
+    // Visits every multiset extending the current prefix of `depth` parts with parts from `from` onwards.
+    void extend(size_t depth, size_t from, double cap_uF, double v_max, double i_max, double power_max)
+    {
+        for (size_t index = from; index < parts.size(); ++index)
+        {
+            if (bound(depth, index, cap_uF, v_max, i_max, power_max) < _threshold())
+            {
+                ++pruned;
+                break;
+            }
+            add(depth, index, cap_uF, v_max, i_max, power_max);
+        }
+    }
+
+    // Adds part `index` at `depth`, evaluates the group and descends. Sums follow the ParallelCapacitor constructor.
+    void add(size_t depth, size_t index, double cap_uF, double v_max, double i_max, double power_max)
+    {
+        const Part &part = parts[index];
+        double group_cap_uF = cap_uF + part.cap_uF;
+        double group_v_max = depth == 0 || part.v_max < v_max ? part.v_max : v_max;
+        double group_i_max = i_max + part.i_max;
+        double group_power_max = power_max + part.power_max;
+
+        group.parts[depth] = static_cast<uint32_t>(index);
+        group.count = depth + 1;
+        ++evaluated;
+        _consider(group_rated_current(omega, group_cap_uF, group_v_max, group_i_max, group_power_max));
+
+        if (depth + 1 < max_size)
+        {
+            extend(depth + 1, index, group_cap_uF, group_v_max, group_i_max, group_power_max);
+            group.count = depth + 1;
+        }
+    }
+
+    std::vector<GroupCandidate> &candidates() { return heap; }
+};
+
+} // namespace
+
+double parallel_group_rated_current(const CapacitorSpec &group_spec, double frequency)
+{
+    return group_rated_current(2 * M_PI * frequency, group_spec.get_cap_uF(), group_spec.get_v_max(),
+                                 group_spec.get_i_max(), group_spec.get_power_max());
+}
+
+DesignSearchResult search_tank_designs(const std::vector<CapacitorSpecification> &catalog, const DesignSearchOptions &options)
+{
+    DesignSearchResult result;
+    size_t max_size = std::min(std::max(options.max_group_size, min_group_capacitors), max_group_capacitors);
+    if (catalog.empty() || options.top == 0)
+    {
+        return result;
+    }
+
+    std::vector<Part> parts;
+    parts.reserve(catalog.size());
+    for (size_t k = 0; k < catalog.size(); ++k)
+    {
+        const auto &spec = catalog[k];
+        parts.push_back({spec.capacitance * 1e6, spec.voltage, spec.current, spec.power, static_cast<uint32_t>(k)});
+    }
+    std::stable_sort(parts.begin(), parts.end(), [](const Part &a, const Part &b) { return a.v_max > b.v_max; });
+
+    SuffixMax suffix;
+    suffix.cap_uF.resize(parts.size());
+    suffix.i_max.resize(parts.size());
+    suffix.power_max.resize(parts.size());
+    for (size_t k = parts.size(); k-- > 0;)
+    {
+        bool last = k + 1 == parts.size();
+        suffix.cap_uF[k] = last ? parts[k].cap_uF : std::max(parts[k].cap_uF, suffix.cap_uF[k + 1]);
+        suffix.i_max[k] = last ? parts[k].i_max : std::max(parts[k].i_max, suffix.i_max[k + 1]);
+        suffix.power_max[k] = last ? parts[k].power_max : std::max(parts[k].power_max, suffix.power_max[k + 1]);
+    }
+
+    // A design is an unordered pair of groups and is limited by its weaker group, so the best `top` designs
+    // only use the best m groups with m * (m + 1) / 2 >= top.
+    size_t keep = 1;
+    while (keep * (keep + 1) / 2 < options.top)
+    {
+        ++keep;
+    }
+
+    double omega = 2 * M_PI * options.frequency;
+    double target = options.current;
+    std::atomic<double> shared_threshold(target);
+    std::atomic<size_t> next_first(0);
+    std::atomic<bool> exhausted(false);
+
+    ThreadPool pool(options.threads);
+    std::vector<std::unique_ptr<GroupSearch>> searches;
+    for (size_t k = 0; k < pool.size(); ++k)
+    {
+        searches.push_back(std::make_unique<GroupSearch>(parts, suffix, omega, target, max_size, keep, shared_threshold));
+    }
+
+    // Workers take the first part of the group from a shared counter; the bound is non-increasing in it.
+    for (auto &search : searches)
+    {
+        GroupSearch *worker = search.get();
+        pool.submit([worker, &parts, &next_first, &exhausted, &shared_threshold, target]() {
+            for (;;)
+            {
+                size_t first = next_first.fetch_add(1);
+                if (first >= parts.size() || exhausted.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+                double threshold = std::max(target, shared_threshold.load(std::memory_order_relaxed));
+                if (worker->bound(0, first, 0.0, 0.0, 0.0, 0.0) < threshold)
+                {
+                    ++worker->pruned;
+                    exhausted.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                worker->add(0, first, 0.0, 0.0, 0.0, 0.0);
+            }
+        });
+    }
+    pool.wait();
+
+    std::vector<GroupCandidate> groups;
+    for (auto &search : searches)
+    {
+        result.evaluated_groups += search->evaluated;
+        result.pruned_branches += search->pruned;
+        groups.insert(groups.end(), search->candidates().begin(), search->candidates().end());
+    }
+    std::sort(groups.begin(), groups.end(), ranks_before);
+    if (groups.size() > keep)
+    {
+        groups.resize(keep);
+    }
+
+    auto names = [&](const GroupCandidate &group) {
+        std::vector<std::string> group_names;
+        for (size_t k = 0; k < group.count; ++k)
+        {
+            group_names.push_back(catalog[parts[group.parts[k]].catalog_index].name);
+        }
+        return group_names;
+    };
+
+    // Pair (i, j) with i <= j is limited by group j, so listing by j then i is already ranked.
+    for (size_t j = 0; j < groups.size() && result.designs.size() < options.top; ++j)
+    {
+        for (size_t i = 0; i <= j && result.designs.size() < options.top; ++i)
+        {
+            double rated = groups[j].rated_current;
+            result.designs.push_back({names(groups[i]), names(groups[j]), rated, rated - target});
+        }
+    }
+
+    return result;
+}
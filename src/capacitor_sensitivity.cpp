@@ -0,0 +1,61 @@
+#include <vector>
+#include <algorithm>
+
+#include "capacitor_sensitivity.h"
+#include "capacitor_dual.h"
+
+using SensitivityDual = Dual<sensitivity_width>;
+
+SensitivityResult run_sensitivity(const CompiledTank &tank, const SensitivityOptions &options)
+{
+    SensitivityResult result;
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        if (tank.kind()[n] == CapacitorKind::Single)
+        {
+            result.parts.push_back(n);
+        }
+    }
+    result.rows = 3 * tank.size() + 1;
+    result.columns = result.parts.size() + 1;
+    result.jacobian.assign(result.rows * result.columns, 0.0);
+    result.values.resize(result.rows);
+
+    BasicCompiledTankEvaluator<SensitivityDual> evaluator(tank);
+    for (size_t first = 0; first < result.columns; first += sensitivity_width)
+    {
+        // Parameters first to first + sensitivity_width - 1 get the derivative slots of this evaluation.
+        size_t last = std::min(first + sensitivity_width, result.columns);
+        auto seed = [first, last](double value, size_t column, double scale) {
+            return column >= first && column < last ? SensitivityDual::seed(value, column - first, scale)
+                                                    : SensitivityDual(value);
+        };
+
+        for (size_t column = 0; column < result.parts.size(); ++column)
+        {
+            uint32_t part = result.parts[column];
+            // d cap_F / d cap_uF
+            evaluator.set_cap_F(part, seed(tank.cap_F()[part], column, 1e-6));
+        }
+        SensitivityDual frequency = seed(options.frequency, result.frequency_column(), 1.0);
+
+        evaluator.voltage(frequency, SensitivityDual(options.current));
+        SensitivityDual allowed_current = evaluator.allowed_current();
+
+        auto store = [&](size_t row, const SensitivityDual &value) {
+            result.values[row] = value.value;
+            for (size_t column = first; column < last; ++column)
+            {
+                result.jacobian[row * result.columns + column] = value.d[column - first];
+            }
+        };
+        for (uint32_t n = 0; n < tank.size(); ++n)
+        {
+            store(result.current_row(n), evaluator.node_current()[n]);
+            store(result.voltage_row(n), evaluator.node_voltage()[n]);
+            store(result.power_row(n), evaluator.node_power(n));
+        }
+        store(result.allowed_current_row(), allowed_current);
+    }
+    return result;
+}
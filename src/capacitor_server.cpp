@@ -0,0 +1,567 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "capacitor_server.h"
+
+namespace {
+
+// Sequential reader over a request payload; every read fails once the payload is too short.
+class PayloadReader
+{
+    const uint8_t *data;
+    size_t size;
+    size_t offset = 0;
+
+public:
+    PayloadReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    bool read(T &value)
+    {
+        if (size - offset < sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string &value, size_t length)
+    {
+        if (size - offset < length)
+        {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char *>(data + offset), length);
+        offset += length;
+        return true;
+    }
+
+    bool done() const { return offset == size; }
+};
+
+template <typename T>
+void append(std::vector<uint8_t> &payload, T value)
+{
+    size_t offset = payload.size();
+    payload.resize(offset + sizeof(T));
+    std::memcpy(payload.data() + offset, &value, sizeof(T));
+}
+
+void fail(std::vector<uint8_t> &response, const std::string &message)
+{
+    response.clear();
+    append(response, ServerStatus::Error);
+    response.insert(response.end(), message.begin(), message.end());
+}
+
+bool write_all(int fd, const uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        // A peer that has gone away fails the send instead of raising SIGPIPE.
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool read_all(int fd, uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t received = ::read(fd, data, size);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+} // namespace
+
+size_t LatencyHistogram::_bucket(uint64_t ns)
+{
+    if (ns < linear_buckets)
+    {
+        return static_cast<size_t>(ns);
+    }
+    // ns >= 16, so the exponent is at least 4 and the three bits below the leading one select the sub-bucket.
+    size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(ns));
+    size_t sub = static_cast<size_t>(ns >> (exponent - 3)) & (sub_buckets - 1);
+    return linear_buckets + (exponent - 4) * sub_buckets + sub;
+}
+
+uint64_t LatencyHistogram::_bucket_upper(size_t bucket)
+{
+    if (bucket < linear_buckets)
+    {
+        return bucket;
+    }
+    size_t exponent = (bucket - linear_buckets) / sub_buckets + 4;
+    uint64_t sub = (bucket - linear_buckets) % sub_buckets;
+    uint64_t width = uint64_t(1) << (exponent - 3);
+    return (uint64_t(1) << exponent) + (sub + 1) * width - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    ++_buckets[_bucket(ns)];
+    ++_count;
+    if (ns > _max)
+    {
+        _max = ns;
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    if (_count == 0)
+    {
+        return 0;
+    }
+    // Rank of the quantile, rounded up so p100 is the last sample.
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(_count));
+    if (static_cast<double>(rank) < q * static_cast<double>(_count))
+    {
+        ++rank;
+    }
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < _buckets.size(); ++bucket)
+    {
+        seen += _buckets[bucket];
+        if (seen >= rank)
+        {
+            return std::min(_bucket_upper(bucket), _max);
+        }
+    }
+    return _max;
+}
+
+TankServer::TankServer(const std::vector<CapacitorSpecification> &catalog, size_t max_tanks)
+    : TankServer(std::make_shared<const PartIndex>(catalog), max_tanks)
+{
+}
+
+TankServer::TankServer(std::shared_ptr<const PartIndex> parts, size_t max_tanks)
+    : parts(std::move(parts)), max_tanks(std::max<size_t>(max_tanks, 1))
+{
+}
+
+void TankServer::handle(const uint8_t *request, size_t size, std::vector<uint8_t> &response)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    response.clear();
+    ServerOp op = size > 0 ? static_cast<ServerOp>(request[0]) : ServerOp{};
+    switch (op)
+    {
+    case ServerOp::Compose:
+        _compose(request + 1, size - 1, response);
+        break;
+    case ServerOp::Evaluate:
+        _evaluate(request + 1, size - 1, response);
+        break;
+    case ServerOp::AllowedCurrent:
+        _allowed_current(request + 1, size - 1, response);
+        break;
+    case ServerOp::Stats:
+        _stats(response);
+        break;
+    default:
+        fail(response, "Unknown request.");
+        break;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+void TankServer::_compose(const uint8_t *request, size_t size, std::vector<uint8_t> &response)
+{
+    PayloadReader reader(request, size);
+    uint8_t counts[2];
+    if (!reader.read(counts[0]) || !reader.read(counts[1]))
+    {
+        return fail(response, "Malformed compose request.");
+    }
+    if (counts[0] < 1 || counts[0] > 5 || counts[1] < 1 || counts[1] > 5)
+    {
+        return fail(response, "Groups need 1 to 5 capacitors.");
+    }
+
+    std::vector<PartId> groups[2];
+    std::string signature(reinterpret_cast<const char *>(counts), 2);
+    for (int g = 0; g < 2; ++g)
+    {
+        for (uint8_t k = 0; k < counts[g]; ++k)
+        {
+            uint8_t length;
+            std::string name;
+            if (!reader.read(length) || !reader.read(name, length))
+            {
+                return fail(response, "Malformed compose request.");
+            }
+            PartId part = parts->find(name);
+            if (part == no_part)
+            {
+                return fail(response, "Capacitor " + name + " not found in the specification file.");
+            }
+            signature.append(reinterpret_cast<const char *>(&part), sizeof(part));
+            groups[g].push_back(part);
+        }
+    }
+    if (!reader.done())
+    {
+        return fail(response, "Malformed compose request.");
+    }
+
+    auto cached = tank_ids.find(signature);
+    uint32_t id;
+    if (cached != tank_ids.end())
+    {
+        id = cached->second;
+    }
+    else
+    {
+        id = next_id++;
+        size_t slot = id % max_tanks;
+        if (slot == tanks.size())
+        {
+            tanks.push_back(std::make_unique<TankCalculator>(parts));
+            signatures.emplace_back();
+        }
+        else
+        {
+            tank_ids.erase(signatures[slot]);
+        }
+        tanks[slot]->compose_capacitors_tank(groups[0], groups[1]);
+        signatures[slot] = signature;
+        tank_ids.emplace(std::move(signature), id);
+    }
+
+    append(response, ServerStatus::Ok);
+    append(response, id);
+}
+
+TankCalculator *TankServer::_tank(const uint8_t *request, size_t size, std::vector<uint8_t> &response)
+{
+    uint32_t id;
+    if (size < sizeof(id))
+    {
+        fail(response, "Malformed request.");
+        return nullptr;
+    }
+    std::memcpy(&id, request, sizeof(id));
+    // Ids below the last tanks.size() composed ones have been evicted.
+    if (id >= next_id || next_id - id > tanks.size())
+    {
+        fail(response, "Unknown tank " + std::to_string(id) + ".");
+        return nullptr;
+    }
+    return tanks[id % max_tanks].get();
+}
+
+void TankServer::_evaluate(const uint8_t *request, size_t size, std::vector<uint8_t> &response)
+{
+    TankCalculator *tank = _tank(request, size, response);
+    if (!tank)
+    {
+        return;
+    }
+
+    PayloadReader reader(request + sizeof(uint32_t), size - sizeof(uint32_t));
+    double current, frequency;
+    if (!reader.read(current) || !reader.read(frequency) || !reader.done())
+    {
+        return fail(response, "Malformed evaluate request.");
+    }
+
+    report.clear();
+    double tank_current = tank->check_capacitors_tank(frequency, current, report);
+    double allowed_current = tank->calculate_allowed_current(frequency);
+
+    append(response, ServerStatus::Ok);
+    append(response, tank_current);
+    append(response, allowed_current);
+    append(response, static_cast<uint32_t>(report.size()));
+    for (const Violation &violation : report)
+    {
+        append(response, violation.node);
+        append(response, violation.kind);
+        append(response, violation.value);
+        append(response, violation.limit);
+    }
+}
+
+void TankServer::_allowed_current(const uint8_t *request, size_t size, std::vector<uint8_t> &response)
+{
+    TankCalculator *tank = _tank(request, size, response);
+    if (!tank)
+    {
+        return;
+    }
+
+    PayloadReader reader(request + sizeof(uint32_t), size - sizeof(uint32_t));
+    double frequency;
+    if (!reader.read(frequency) || !reader.done())
+    {
+        return fail(response, "Malformed allowed current request.");
+    }
+
+    append(response, ServerStatus::Ok);
+    append(response, tank->calculate_allowed_current(frequency));
+}
+
+void TankServer::_stats(std::vector<uint8_t> &response) const
+{
+    append(response, ServerStatus::Ok);
+    append(response, latency.count());
+    append(response, static_cast<uint32_t>(tanks.size()));
+    append(response, latency.percentile(0.5));
+    append(response, latency.percentile(0.9));
+    append(response, latency.percentile(0.99));
+    append(response, latency.percentile(0.999));
+    append(response, latency.max());
+}
+
+bool ServerConnection::on_readable(TankServer &server)
+{
+    uint8_t chunk[64 * 1024];
+    ssize_t received = ::read(fd, chunk, sizeof(chunk));
+    if (received < 0)
+    {
+        return errno == EINTR || errno == EAGAIN;
+    }
+    if (received == 0)
+    {
+        return false;
+    }
+    input.insert(input.end(), chunk, chunk + received);
+
+    // Answer every complete frame and send the responses together.
+    size_t offset = 0;
+    uint32_t length;
+    while (input.size() - offset >= sizeof(length))
+    {
+        std::memcpy(&length, input.data() + offset, sizeof(length));
+        if (length > max_frame_payload)
+        {
+            return false;
+        }
+        if (input.size() - offset - sizeof(length) < length)
+        {
+            break;
+        }
+        server.handle(input.data() + offset + sizeof(length), length, response);
+        append(output, static_cast<uint32_t>(response.size()));
+        output.insert(output.end(), response.begin(), response.end());
+        offset += sizeof(length) + length;
+    }
+    input.erase(input.begin(), input.begin() + offset);
+
+    return _flush();
+}
+
+bool ServerConnection::_flush()
+{
+    size_t sent = 0;
+    while (sent < output.size())
+    {
+        // A peer that has gone away fails the send instead of raising SIGPIPE; a full socket is retried
+        // once poll reports it writable.
+        ssize_t written = ::send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    output.erase(output.begin(), output.begin() + sent);
+    return true;
+}
+
+void serve_unix_socket(TankServer &server, const std::string &path)
+{
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path " + path + " is too long.");
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        throw std::runtime_error(std::string("Could not create socket: ") + std::strerror(errno));
+    }
+    ::unlink(path.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || ::listen(listener, 64) < 0)
+    {
+        std::string error = std::strerror(errno);
+        ::close(listener);
+        throw std::runtime_error("Could not listen on " + path + ": " + error);
+    }
+
+    // One thread serves every client: a query costs microseconds, far less than a context switch. Client
+    // sockets do not block, so a client that does not read its responses only holds up itself.
+    std::vector<pollfd> fds{{listener, POLLIN, 0}};
+    std::vector<std::unique_ptr<ServerConnection>> connections;
+    for (;;)
+    {
+        for (size_t k = 1; k < fds.size(); ++k)
+        {
+            const ServerConnection &connection = *connections[k - 1];
+            fds[k].events = (connection.pending_output() <= max_pending_output ? POLLIN : 0) |
+                            (connection.pending_output() > 0 ? POLLOUT : 0);
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::string error = std::strerror(errno);
+            for (const pollfd &fd : fds)
+            {
+                ::close(fd.fd);
+            }
+            throw std::runtime_error("Could not wait for clients on " + path + ": " + error);
+        }
+
+        for (size_t k = fds.size(); k-- > 1;)
+        {
+            short revents = fds[k].revents;
+            if (revents == 0)
+            {
+                continue;
+            }
+            ServerConnection &connection = *connections[k - 1];
+            bool open = (revents & (POLLIN | POLLOUT)) != 0;
+            if (open && (revents & POLLIN))
+            {
+                open = connection.on_readable(server);
+            }
+            if (open && (revents & POLLOUT))
+            {
+                open = connection.on_writable();
+            }
+            if (!open)
+            {
+                ::close(fds[k].fd);
+                fds.erase(fds.begin() + k);
+                connections.erase(connections.begin() + (k - 1));
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            int client = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client >= 0)
+            {
+                fds.push_back({client, POLLIN, 0});
+                connections.push_back(std::make_unique<ServerConnection>(client));
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> encode_compose_request(const std::vector<std::string> &group1, const std::vector<std::string> &group2)
+{
+    std::vector<uint8_t> payload;
+    append(payload, ServerOp::Compose);
+    append(payload, static_cast<uint8_t>(group1.size()));
+    append(payload, static_cast<uint8_t>(group2.size()));
+    for (const auto *group : {&group1, &group2})
+    {
+        for (const auto &name : *group)
+        {
+            append(payload, static_cast<uint8_t>(name.size()));
+            payload.insert(payload.end(), name.begin(), name.end());
+        }
+    }
+    return payload;
+}
+
+std::vector<uint8_t> encode_evaluate_request(uint32_t tank, double current, double frequency)
+{
+    std::vector<uint8_t> payload;
+    append(payload, ServerOp::Evaluate);
+    append(payload, tank);
+    append(payload, current);
+    append(payload, frequency);
+    return payload;
+}
+
+std::vector<uint8_t> encode_allowed_current_request(uint32_t tank, double frequency)
+{
+    std::vector<uint8_t> payload;
+    append(payload, ServerOp::AllowedCurrent);
+    append(payload, tank);
+    append(payload, frequency);
+    return payload;
+}
+
+std::vector<uint8_t> encode_stats_request()
+{
+    std::vector<uint8_t> payload;
+    append(payload, ServerOp::Stats);
+    return payload;
+}
+
+bool write_frame(int fd, const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> frame;
+    append(frame, static_cast<uint32_t>(payload.size()));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    return write_all(fd, frame.data(), frame.size());
+}
+
+bool read_frame(int fd, std::vector<uint8_t> &payload)
+{
+    uint32_t length;
+    if (!read_all(fd, reinterpret_cast<uint8_t *>(&length), sizeof(length)) || length > max_frame_payload)
+    {
+        return false;
+    }
+    payload.resize(length);
+    return read_all(fd, payload.data(), length);
+}
@@ -0,0 +1,475 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "capacitor_spec_parser.h"
+#include "thread_pool.h"
+
+namespace {
+
+// Below this many bytes per thread a catalog is parsed on the calling thread.
+constexpr size_t min_chunk_bytes = 256 * 1024;
+
+struct SpecParseError
+{
+    size_t offset;
+    std::string message;
+};
+
+// Characters of a part of the text as the JSON parser reads them: text[begin, end), after an optional '['
+// and before an optional ']', so a run of records parses as an array of its own. Index k of the sequence is
+// byte origin + k of the text. Every character read is counted in *read, the only position the SAX
+// interface leaves to its handler.
+class ChunkIterator
+{
+    std::string_view text;
+    size_t origin;
+    size_t index;
+    size_t size;
+    bool open;
+    bool close;
+    size_t *read;
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = char;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char *;
+    using reference = char;
+
+    ChunkIterator(std::string_view text, size_t origin, size_t index, size_t size, bool open, bool close, size_t *read)
+        : text(text), origin(origin), index(index), size(size), open(open), close(close), read(read)
+    {
+    }
+
+    char operator*() const
+    {
+        if (open && index == 0)
+        {
+            return '[';
+        }
+        return close && index + 1 == size ? ']' : text[origin + index];
+    }
+
+    ChunkIterator &operator++()
+    {
+        *read = ++index;
+        return *this;
+    }
+
+    ChunkIterator operator++(int)
+    {
+        ChunkIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    bool operator==(const ChunkIterator &other) const { return index == other.index; }
+    bool operator!=(const ChunkIterator &other) const { return index != other.index; }
+};
+
+// SAX handler that checks the catalog schema and fills one specification per record; values of other
+// members are skipped as the parser reports them. Stops at the first error with its byte offset.
+class SpecRecordHandler : public nlohmann::json_sax<json>
+{
+    enum Member : unsigned { Other = 0, Name = 1, Capacitance = 2, Current = 4, Power = 8, Voltage = 16 };
+
+    std::string_view text;
+    size_t origin;
+    const size_t &read;
+    std::vector<CapacitorSpecification> &specs;
+
+    // 1 inside the catalog array, 2 inside a record, deeper inside a skipped value.
+    size_t depth = 0;
+    Member member = Other;
+    unsigned seen = 0;
+    size_t record_start = 0;
+    // Characters read when the previous event was reported.
+    size_t mark = 0;
+
+    static const char *_member_name(Member member)
+    {
+        switch (member)
+        {
+        case Name: return "name";
+        case Capacitance: return "capacitance";
+        case Current: return "current";
+        case Power: return "power";
+        default: return "voltage";
+        }
+    }
+
+    bool _fail(size_t offset, const std::string &message)
+    {
+        error = {offset, message};
+        return false;
+    }
+
+    // Offset of the value reported by the current event: the first character after the previous event
+    // that is not whitespace or a separator.
+    size_t _value_offset() const
+    {
+        size_t offset = origin + mark;
+        while (offset < text.size() && std::strchr(" \t\r\n,:", text[offset]) != nullptr && text[offset] != '\0')
+        {
+            ++offset;
+        }
+        return offset;
+    }
+
+    bool _done(bool result)
+    {
+        mark = read;
+        return result;
+    }
+
+    // A value outside the records, or of a record member. is_number and is_string give its type.
+    bool _value(bool is_number, bool is_string)
+    {
+        if (depth == 0)
+        {
+            return _fail(_value_offset(), "the catalog must be an array of capacitor objects");
+        }
+        if (depth == 1)
+        {
+            return _fail(_value_offset(), "a capacitor must be an object");
+        }
+        if (depth == 2 && member == Name && !is_string)
+        {
+            return _fail(_value_offset(), "\"name\" is not a string");
+        }
+        if (depth == 2 && member != Other && member != Name && !is_number)
+        {
+            return _fail(_value_offset(), std::string("\"") + _member_name(member) + "\" is not a number");
+        }
+        return true;
+    }
+
+    bool _number(double value)
+    {
+        if (!_value(true, false))
+        {
+            return false;
+        }
+        if (depth == 2 && member != Other)
+        {
+            CapacitorSpecification &spec = specs.back();
+            float &field = member == Capacitance ? spec.capacitance
+                           : member == Current   ? spec.current
+                           : member == Power     ? spec.power
+                                                 : spec.voltage;
+            field = static_cast<float>(value);
+            seen |= member;
+        }
+        return _done(true);
+    }
+
+public:
+    SpecParseError error{std::string_view::npos, ""};
+
+    SpecRecordHandler(std::string_view text, size_t origin, const size_t &read, std::vector<CapacitorSpecification> &specs)
+        : text(text), origin(origin), read(read), specs(specs)
+    {
+    }
+
+    bool null() override { return _done(_value(false, false)); }
+    bool boolean(bool) override { return _done(_value(false, false)); }
+    bool number_integer(number_integer_t value) override { return _number(static_cast<double>(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return _number(static_cast<double>(value)); }
+    bool number_float(number_float_t value, const string_t &) override { return _number(value); }
+    bool binary(binary_t &) override { return _done(_value(false, false)); }
+
+    bool string(string_t &value) override
+    {
+        if (!_value(false, true))
+        {
+            return false;
+        }
+        if (depth == 2 && member == Name)
+        {
+            specs.back().name = std::move(value);
+            seen |= Name;
+        }
+        return _done(true);
+    }
+
+    bool key(string_t &value) override
+    {
+        if (depth == 2)
+        {
+            member = value == "name"          ? Name
+                     : value == "capacitance" ? Capacitance
+                     : value == "current"     ? Current
+                     : value == "power"       ? Power
+                     : value == "voltage"     ? Voltage
+                                              : Other;
+        }
+        return _done(true);
+    }
+
+    bool start_object(std::size_t) override
+    {
+        if (depth == 1)
+        {
+            // The parser has just read the '{'.
+            record_start = origin + read - 1;
+            specs.emplace_back();
+            seen = 0;
+        }
+        else if (!_value(false, false))
+        {
+            return false;
+        }
+        ++depth;
+        return _done(true);
+    }
+
+    bool end_object() override
+    {
+        if (--depth == 1)
+        {
+            static const Member required[] = {Name, Capacitance, Current, Power, Voltage};
+            for (Member field : required)
+            {
+                if (!(seen & field))
+                {
+                    return _fail(record_start, std::string("capacitor without \"") + _member_name(field) + "\"");
+                }
+            }
+        }
+        return _done(true);
+    }
+
+    bool start_array(std::size_t) override
+    {
+        if (depth > 0 && !_value(false, false))
+        {
+            return false;
+        }
+        ++depth;
+        return _done(true);
+    }
+
+    bool end_array() override
+    {
+        --depth;
+        return _done(true);
+    }
+
+    bool parse_error(std::size_t position, const std::string &, const nlohmann::detail::exception &exception) override
+    {
+        // The position counts the offending character; the message follows "line L, column C: ".
+        std::string message = exception.what();
+        size_t column = message.find("column ");
+        size_t colon = column == std::string::npos ? std::string::npos : message.find(": ", column);
+        return _fail(origin + position - 1, colon == std::string::npos ? message : message.substr(colon + 2));
+    }
+};
+
+// Parses text[begin, end), wrapped in '[' and ']' as asked, into specs. Offsets are of the whole text.
+void parse_records(std::string_view text, size_t begin, size_t end, bool open, bool close,
+                   std::vector<CapacitorSpecification> &specs)
+{
+    size_t origin = begin - open;
+    size_t size = open + (end - begin) + close;
+    size_t read = 0;
+    SpecRecordHandler handler(text, origin, read, specs);
+    json::sax_parse(ChunkIterator(text, origin, 0, size, open, close, &read),
+                    ChunkIterator(text, origin, size, size, open, close, &read), &handler);
+    if (handler.error.offset != std::string_view::npos)
+    {
+        throw handler.error;
+    }
+}
+
+// Offsets of the top-level ',' separators that split the records after begin into about chunks parts of
+// equal size. Only strings and nesting are followed; an unbalanced text gives no split, and the parser
+// reports the error.
+std::vector<size_t> chunk_separators(std::string_view text, size_t begin, size_t chunks)
+{
+    std::vector<size_t> separators;
+    size_t chunk_bytes = (text.size() - begin) / chunks + 1;
+    size_t next = begin + chunk_bytes;
+    int depth = 0;
+    for (size_t k = begin; k < text.size(); ++k)
+    {
+        char c = text[k];
+        if (c == '"')
+        {
+            // To the closing quote, over escaped characters.
+            for (++k; k < text.size() && text[k] != '"'; ++k)
+            {
+                k += text[k] == '\\';
+            }
+        }
+        else if (c == '{' || c == '[')
+        {
+            ++depth;
+        }
+        else if (c == '}' || c == ']')
+        {
+            if (--depth < 0)
+            {
+                return separators;
+            }
+        }
+        else if (c == ',' && depth == 0 && k >= next)
+        {
+            separators.push_back(k);
+            next = k + chunk_bytes;
+        }
+    }
+    // Unterminated, let the sequential parser find the error.
+    return {};
+}
+
+[[noreturn]] void report(const SpecParseError &error)
+{
+    throw std::invalid_argument("Capacitor specification error at offset " + std::to_string(error.offset) + ": " + error.message);
+}
+
+}
+
+std::vector<CapacitorSpecification> parse_capacitor_specifications_text(std::string_view text, size_t threads)
+{
+    std::vector<CapacitorSpecification> specs;
+    try
+    {
+        // The records start after the '[' of the catalog, past an optional UTF-8 byte order mark.
+        size_t begin = text.find_first_not_of(" \t\r\n", text.substr(0, 3) == "\xef\xbb\xbf" ? 3 : 0);
+        begin = begin != std::string_view::npos && text[begin] == '[' ? begin + 1 : std::string_view::npos;
+
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_t chunks = std::min(threads, text.size() / min_chunk_bytes);
+        std::vector<size_t> separators =
+            chunks > 1 && begin != std::string_view::npos ? chunk_separators(text, begin, chunks) : std::vector<size_t>();
+
+        if (separators.empty())
+        {
+            parse_records(text, 0, text.size(), false, false, specs);
+            return specs;
+        }
+
+        // Chunk k parses from after separator k - 1 up to separator k as an array of its own; the last one
+        // reads the closing ']' of the catalog and checks nothing follows it.
+        size_t count = separators.size() + 1;
+        std::vector<std::vector<CapacitorSpecification>> parts(count);
+        std::vector<SpecParseError> errors(count, SpecParseError{std::string_view::npos, ""});
+        {
+            ThreadPool pool(std::min(threads, count));
+            for (size_t k = 0; k < count; ++k)
+            {
+                pool.submit([&, k]() {
+                    size_t chunk_begin = k == 0 ? begin : separators[k - 1] + 1;
+                    bool last = k + 1 == count;
+                    try
+                    {
+                        parse_records(text, chunk_begin, last ? text.size() : separators[k], true, !last, parts[k]);
+                    }
+                    catch (const SpecParseError &error)
+                    {
+                        errors[k] = error;
+                    }
+                });
+            }
+            pool.wait();
+        }
+
+        // The first error in the text, as the sequential parser would report it.
+        for (const SpecParseError &error : errors)
+        {
+            if (error.offset != std::string_view::npos)
+            {
+                report(error);
+            }
+        }
+
+        size_t total = 0;
+        for (const auto &part : parts)
+        {
+            total += part.size();
+        }
+        specs.reserve(total);
+        for (auto &part : parts)
+        {
+            std::move(part.begin(), part.end(), std::back_inserter(specs));
+            std::vector<CapacitorSpecification>().swap(part);
+        }
+    }
+    catch (const SpecParseError &error)
+    {
+        report(error);
+    }
+    return specs;
+}
+
+std::vector<CapacitorSpecification> parse_capacitor_specifications_json_file(const std::string &path, size_t threads)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (fd < 0 || ::fstat(fd, &status) != 0)
+    {
+        std::string error = std::strerror(errno);
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        throw std::runtime_error("Could not open capacitor specification file " + path + ": " + error);
+    }
+
+    // A regular file is parsed in place from its mapping; a pipe, or an empty file, which cannot be
+    // mapped, is read.
+    size_t size = static_cast<size_t>(status.st_size);
+    if (S_ISREG(status.st_mode) && size > 0)
+    {
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map capacitor specification file " + path + ": " + std::strerror(errno));
+        }
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+        try
+        {
+            std::vector<CapacitorSpecification> specs =
+                parse_capacitor_specifications_text(std::string_view(static_cast<const char *>(mapping), size), threads);
+            ::munmap(mapping, size);
+            return specs;
+        }
+        catch (...)
+        {
+            ::munmap(mapping, size);
+            throw;
+        }
+    }
+
+    std::string text;
+    char buffer[1 << 16];
+    ssize_t count;
+    while ((count = ::read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        text.append(buffer, static_cast<size_t>(count));
+    }
+    std::string error = count < 0 ? std::strerror(errno) : "";
+    ::close(fd);
+    if (count < 0)
+    {
+        throw std::runtime_error("Could not read capacitor specification file " + path + ": " + error);
+    }
+    return parse_capacitor_specifications_text(text, threads);
+}
@@ -5,11 +5,30 @@
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <stdexcept>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "capacitors.h"
 #include "capacitor_tank.h"
 #include "capacitor_violation_check.h"
 #include "capacitor_dump_value.h"
+#include "capacitor_search.h"
+#include "capacitor_batch.h"
+#include "capacitor_server.h"
+#include "capacitor_netlist.h"
+#include "capacitor_monte_carlo.h"
+#include "capacitor_worst_case.h"
+#include "capacitor_sensitivity.h"
+#include "capacitor_faults.h"
+#include "capacitor_harmonics.h"
+#include "capacitor_waveform.h"
+#include "capacitor_monitor.h"
+#include "capacitor_catalog.h"
+#include "capacitor_spec_parser.h"
 
 
 using json = nlohmann::json;
@@ -45,9 +64,138 @@ ProgramData get_commnad_line_params(int argc, char **argv)
                 { return value; });
 
     program.add_argument("-spec")
-        .help("Path to capacitor specification file")
+        .help("Path to capacitor specification file, JSON or a binary catalog ending in .tcat")
         .default_value(std::string("capacitors-spec.json"));
 
+    program.add_argument("-format")
+        .help("Output format of the results: console, csv or json")
+        .default_value(std::string("console"));
+
+    program.add_argument("-batch")
+        .help("Evaluate every \"current,frequency\" line of this CSV file, - for stdin, instead of -i and -f")
+        .default_value(std::string(""));
+
+    program.add_argument("-output")
+        .help("File receiving the -batch results, - for stdout")
+        .default_value(std::string("-"));
+
+    program.add_argument("-netlist")
+        .help("Tank netlist file, JSON when it ends in .json, evaluated instead of -group1 and -group2")
+        .default_value(std::string(""));
+
+    program.add_argument("-montecarlo")
+        .help("Number of Monte Carlo samples of the tank with perturbed parts driven by an -i current, instead of one calculation")
+        .default_value(0)
+        .scan<'i', int>();
+
+    program.add_argument("-tolerance")
+        .help("Relative capacitance spread of the parts for -montecarlo and -worstcase")
+        .default_value(0.05f)
+        .scan<'g', float>();
+
+    program.add_argument("-limit-tolerance")
+        .help("Relative spread of the voltage, current and power limits of the parts for -montecarlo")
+        .default_value(0.0f)
+        .scan<'g', float>();
+
+    program.add_argument("-distribution")
+        .help("Distribution of the -montecarlo spreads: uniform or normal (spread is the standard deviation)")
+        .default_value(std::string("uniform"));
+
+    program.add_argument("-seed")
+        .help("Seed of the -montecarlo random numbers")
+        .default_value(1)
+        .scan<'i', int>();
+
+    program.add_argument("-worstcase")
+        .help("Bound the stress of every node, driven by an -i current, over the -tolerance, -f-tolerance and -i-tolerance ranges, instead of one calculation")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("-f-tolerance")
+        .help("Relative frequency tolerance for -worstcase")
+        .default_value(0.0f)
+        .scan<'g', float>();
+
+    program.add_argument("-i-tolerance")
+        .help("Relative current tolerance for -worstcase")
+        .default_value(0.0f)
+        .scan<'g', float>();
+
+    program.add_argument("-sensitivity")
+        .help("Print the derivatives of every node's current, voltage and power and of the allowed current with respect to each part's capacitance (uF) and the frequency, as CSV")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("-faults")
+        .help("Evaluate every single-part open-circuit failure and report the highest stress of the surviving parts")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("-envelope")
+        .help("Print the allowed current against every current, voltage and power limit, piece by piece, from -f to this frequency")
+        .default_value(0.0f)
+        .scan<'g', float>();
+
+    program.add_argument("-spectrum")
+        .help("File of \"frequency,current\" harmonic lines (RMS amps); evaluates the RMS current, RMS voltage and reactive power of every node instead of -i and -f")
+        .default_value(std::string(""));
+
+    program.add_argument("-waveform")
+        .help("Binary float32 file of tank current samples (A), or - for stdin; reports windowed RMS limit violations and per-node RMS and peak values")
+        .default_value(std::string(""));
+
+    program.add_argument("-sample-rate")
+        .help("Sample rate of -waveform in Hz")
+        .default_value(1e6f)
+        .scan<'g', float>();
+
+    program.add_argument("-window")
+        .help("Samples per windowed RMS of -waveform")
+        .default_value(10000)
+        .scan<'i', int>();
+
+    program.add_argument("-highpass")
+        .help("DC block corner of -waveform in Hz; voltages at f read low by up to (highpass / f)^2, the first 1.6 / highpass seconds settle it")
+        .default_value(1.0f)
+        .scan<'g', float>();
+
+    program.add_argument("-monitor")
+        .help("Binary float32 (current, frequency) telemetry feed: a file or FIFO, - for stdin, or shm:/name for a shared memory ring; prints debounced limit events")
+        .default_value(std::string(""));
+
+    program.add_argument("-hysteresis")
+        .help("Relative hysteresis of -monitor: a raised limit clears below limit * (1 - hysteresis)")
+        .default_value(0.05f)
+        .scan<'g', float>();
+
+    program.add_argument("-debounce")
+        .help("Consecutive -monitor updates beyond a threshold before a limit is raised or cleared")
+        .default_value(3)
+        .scan<'i', int>();
+
+    program.add_argument("-feed")
+        .help("Test producer: push binary float32 (current, frequency) records from stdin into the -monitor shared memory ring of this name")
+        .default_value(std::string(""));
+
+    program.add_argument("-write-catalog")
+        .help("Convert the -spec JSON file into a binary catalog at this path (.tcat), read by -spec like the JSON file")
+        .default_value(std::string(""));
+
+    program.add_argument("-serve")
+        .help("Load the specification file once and answer requests on this Unix socket path")
+        .default_value(std::string(""));
+
+    program.add_argument("-search")
+        .help("Search the specification file for the group 1 and group 2 designs with the largest rated current margin at -i and -f; the rated current checks the voltage, current and power limits")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("-top")
+        .help("Number of designs listed by -search")
+        .default_value(10)
+        .scan<'i', int>();
+
     try
     {
         // Parse the command line arguments
@@ -68,6 +216,34 @@ ProgramData get_commnad_line_params(int argc, char **argv)
     data.group2 = program.get<std::vector<std::string>>("-group2");
 
     data.capacitor_spec_file = program.get<std::string>("-spec");
+    data.search = program.get<bool>("-search");
+    data.top = program.get<int>("-top");
+    data.format = program.get<std::string>("-format");
+    data.batch = program.get<std::string>("-batch");
+    data.output = program.get<std::string>("-output");
+    data.serve = program.get<std::string>("-serve");
+    data.netlist = program.get<std::string>("-netlist");
+    data.monte_carlo = program.get<int>("-montecarlo");
+    data.tolerance = program.get<float>("-tolerance");
+    data.limit_tolerance = program.get<float>("-limit-tolerance");
+    data.distribution = program.get<std::string>("-distribution");
+    data.seed = program.get<int>("-seed");
+    data.worst_case = program.get<bool>("-worstcase");
+    data.f_tolerance = program.get<float>("-f-tolerance");
+    data.i_tolerance = program.get<float>("-i-tolerance");
+    data.sensitivity = program.get<bool>("-sensitivity");
+    data.faults = program.get<bool>("-faults");
+    data.envelope = program.get<float>("-envelope");
+    data.spectrum = program.get<std::string>("-spectrum");
+    data.waveform = program.get<std::string>("-waveform");
+    data.sample_rate = program.get<float>("-sample-rate");
+    data.window = program.get<int>("-window");
+    data.highpass = program.get<float>("-highpass");
+    data.monitor = program.get<std::string>("-monitor");
+    data.feed = program.get<std::string>("-feed");
+    data.hysteresis = program.get<float>("-hysteresis");
+    data.debounce = program.get<int>("-debounce");
+    data.write_catalog = program.get<std::string>("-write-catalog");
 
     return data;
 }
@@ -86,17 +262,16 @@ CapacitorSpecification parse_component(const json &j)
 std::vector<CapacitorSpecification> parse_capacitor_specifications(json& json_data)
 {
     std::vector<CapacitorSpecification> capacitor_spec;
-    try
+    for (size_t index = 0; index < json_data.size(); ++index)
     {
-        for (const auto &item : json_data)
+        try
         {
-            capacitor_spec.emplace_back(parse_component(item));
+            capacitor_spec.emplace_back(parse_component(json_data.at(index)));
+        }
+        catch (json::exception &e)
+        {
+            throw std::invalid_argument("Capacitor specification error in record " + std::to_string(index) + ": " + e.what());
         }
-    }
-    catch (json::exception &e)
-    {
-        std::cerr << "Error parsing capacitor specification file: " << e.what() << std::endl;
-        return capacitor_spec;
     }
 
     return capacitor_spec;
@@ -104,130 +279,789 @@ std::vector<CapacitorSpecification> parse_capacitor_specifications(json& json_da
 
 std::vector<CapacitorSpecification> parse_capacitor_specifications_file(const std::string &filepath)
 {
-    std::vector<CapacitorSpecification> capacitor_spec;
-
-    // read the capacitor specification file
-    std::ifstream file(filepath);
-    if (!file.is_open())
+    // A binary catalog is mapped and copied column by column, without parsing.
+    if (is_capacitor_catalog_path(filepath))
     {
-        std::cerr << "Error: Could not open capacitor specification file." << std::endl;
-        exit(EXIT_FAILURE);
+        try
+        {
+            return CapacitorCatalog(filepath).specifications();
+        }
+        catch (const std::runtime_error &err)
+        {
+            std::cerr << "Error: " << err.what() << std::endl;
+            exit(EXIT_FAILURE);
+        }
     }
 
-    // parse the json data
-    json json_data;
+    // Parsed from the mapped file straight into the specifications, large files on all cores.
     try
     {
-        file >> json_data;
-        capacitor_spec = parse_capacitor_specifications(json_data);
+        return parse_capacitor_specifications_json_file(filepath);
     }
-    catch (json::parse_error &e)
+    catch (const std::exception &err)
     {
-        std::cerr << "JSON parse error: " << e.what() << std::endl;
-        return capacitor_spec;
+        std::cerr << "Error: " << err.what() << std::endl;
+        exit(EXIT_FAILURE);
     }
+}
 
-    return capacitor_spec;
+// Part index of the -spec file for the paths that compose tanks by name. A binary catalog stays mapped
+// under the index, its names used in place; a JSON file is parsed into specifications first.
+static std::shared_ptr<const PartIndex> load_part_index(const std::string &filepath)
+{
+    if (is_capacitor_catalog_path(filepath))
+    {
+        try
+        {
+            return std::make_shared<const PartIndex>(std::make_shared<const CapacitorCatalog>(filepath));
+        }
+        catch (const std::runtime_error &err)
+        {
+            std::cerr << "Error: " << err.what() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    return std::make_shared<const PartIndex>(parse_capacitor_specifications_file(filepath));
 }
 
 TankCalculator::TankCalculator(std::vector<CapacitorSpecification> &specs)
+    : TankCalculator(std::make_shared<const PartIndex>(specs))
 {
-    capacitors_group1.reserve(5);
-    capacitors_group2.reserve(5);
+}
 
-    for (auto &spec : specs)
-    {
-        stored_specs[spec.name] = std::make_unique<CapacitorSpecification>(spec);
-    }
+TankCalculator::TankCalculator(std::shared_ptr<const PartIndex> parts) : parts(std::move(parts))
+{
 }
 
 void TankCalculator::compose_capacitors_tank(
     std::vector<std::string> &group1,
     std::vector<std::string> &group2)
 {
-    for (auto &name : group1)
+    std::vector<PartId> ids[2];
+    std::vector<std::string> *groups[2] = {&group1, &group2};
+    for (int g = 0; g < 2; ++g)
     {
-        if(stored_specs.find(name) == stored_specs.end())
+        for (auto &name : *groups[g])
         {
-            std::cerr << "Error: Capacitor " << name << " not found in the specification file." << std::endl;
-            exit(EXIT_FAILURE);
+            PartId part = parts->find(name);
+            if (part == no_part)
+            {
+                std::cerr << "Error: Capacitor " << name << " not found in the specification file." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            ids[g].push_back(part);
         }
+    }
+    compose_capacitors_tank(ids[0], ids[1]);
+}
+
+void TankCalculator::_add_part(PartId part, std::vector<CapacitorInterface*> &caps)
+{
+    PartNode &node = part_nodes.next();
+    node.part.assign(parts->cap_uF(part), parts->v_max(part), parts->i_max(part), parts->power_max(part), parts->name(part));
+    node.dump.emplace(&node.part, results);
+    caps.push_back(&*node.dump);
+}
+
+void TankCalculator::compose_capacitors_tank(const std::vector<PartId> &group1, const std::vector<PartId> &group2)
+{
+    part_nodes.reset();
+    caps1.clear();
+    caps2.clear();
+    results.clear();
+    violations.clear();
 
-        auto cap = Capacitor(
-                stored_specs[name]->capacitance*1e6,
-                stored_specs[name]->voltage,
-                stored_specs[name]->current,
-                stored_specs[name]->power,
-                stored_specs[name]->name);
-        
-        capacitors_group1.push_back(cap);
+    for (PartId part : group1)
+    {
+        _add_part(part, caps1);
+    }
+    parallel1.assign(caps1, "parallel1");
 
-        caps1.push_back(new CapacitoDumpValueDecorator(&capacitors_group1[0]));
+    for (PartId part : group2)
+    {
+        _add_part(part, caps2);
     }
+    parallel2.assign(caps2, "parallel2");
 
-    parallel1 = ParallelCapacitor(caps1, "parallel1");
+    // Violation ids are result rows: the group rows follow the rows of their members.
+    uint32_t parallel1_row = static_cast<uint32_t>(caps1.size());
+    uint32_t parallel2_row = static_cast<uint32_t>(caps1.size() + 1 + caps2.size());
+    dump_parallel1.emplace(&parallel1, results);
+    dump_parallel2.emplace(&parallel2, results);
+    check_parallel1.emplace(&*dump_parallel1, &violations, parallel1_row);
+    check_parallel2.emplace(&*dump_parallel2, &violations, parallel2_row);
+    chain.assign({&*check_parallel1, &*check_parallel2});
+    serial.assign(chain, "serial");
+    dump_serial.emplace(&serial, results);
 
-    for (auto &name : group2)
+    compiled_tank.compile(serial);
+    if (evaluator)
     {
-        if(stored_specs.find(name) == stored_specs.end())
+        evaluator->reset();
+    }
+    else
+    {
+        evaluator = std::make_unique<CompiledTankEvaluator>(compiled_tank);
+    }
+}
+
+double TankCalculator::calculate_capacitors_tank(float frequency, float current)
+{
+    results.rows.clear();
+    violations.clear();
+
+    double tank_current = dump_serial->current(frequency, current);
+
+    #ifndef LOG_CONSOLE
+        if (violations.size() > 0)
         {
-            std::cerr << "Error: Capacitor " << name << " not found in the specification file." << std::endl;
+            const Violation &violation = violations[0];
+            throw std::runtime_error(format_violation(violation, results.names[results.rows[violation.node].name]));
+        }
+    #endif
+
+    return tank_current;
+}
+
+double TankCalculator::calculate_capacitors_tank(float frequency, float current, TankResultTable &table)
+{
+    double tank_current = evaluator->current(frequency, current);
+
+    const std::vector<double> &i = evaluator->node_current();
+    const std::vector<double> &v = evaluator->node_voltage();
+    for (size_t n = 0; n < compiled_tank.size(); ++n)
+    {
+        table.add(static_cast<uint32_t>(n), i[n], v[n]);
+    }
+    return tank_current;
+}
+
+TankResultTable TankCalculator::make_result_table() const
+{
+    TankResultTable table;
+    table.names = compiled_tank.names();
+    table.rows.reserve(compiled_tank.size());
+    return table;
+}
+
+double TankCalculator::calculate_allowed_current(float frequency)
+{
+    // The compiled tank gives the same result as serial(parallel1, parallel2).allowed_current().
+    return evaluator->allowed_current(frequency);
+}
+
+double TankCalculator::check_capacitors_tank(float frequency, float current, ViolationReport &report)
+{
+    double tank_current = evaluator->current(frequency, current);
+    evaluator->check_limits(report);
+    return tank_current;
+}
+
+AllowedCurrentEnvelope TankCalculator::allowed_current_envelope(float f_min, float f_max) const
+{
+    return AllowedCurrentEnvelope(compiled_tank, f_min, f_max);
+}
+
+// Evaluates SweepLanes<T>::size points at a time; each lane rounds like the scalar evaluation in T.
+template <typename T>
+static void sweep_compiled_tank(
+    const CompiledTank &tank,
+    const std::vector<float> &frequencies,
+    const std::vector<float> &currents,
+    BasicTankSweepResult<T> &result)
+{
+    using Block = SweepLanes<T>;
+
+    if (frequencies.size() != currents.size())
+    {
+        throw std::invalid_argument("Sweep requires one current per frequency.");
+    }
+
+    result.node_names = tank.names();
+
+    size_t nodes = tank.size();
+    size_t points = frequencies.size();
+    result.current.resize(points * nodes);
+    result.voltage.resize(points * nodes);
+    result.power.resize(points * nodes);
+    result.allowed_current.resize(points);
+
+    BasicCompiledTankEvaluator<Block> evaluator(tank);
+    T f[Block::size];
+    T i[Block::size];
+    for (size_t begin = 0; begin < points; begin += Block::size)
+    {
+        // The last block repeats its last point in the unused lanes.
+        size_t count = std::min(Block::size, points - begin);
+        for (size_t lane = 0; lane < Block::size; ++lane)
+        {
+            size_t p = begin + std::min(lane, count - 1);
+            f[lane] = frequencies[p];
+            i[lane] = currents[p];
+        }
+
+        evaluator.current(Block::load(f), Block::load(i));
+        Block allowed_current = evaluator.allowed_current();
+
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            const Block &current = evaluator.node_current()[n];
+            const Block &voltage = evaluator.node_voltage()[n];
+            for (size_t lane = 0; lane < count; ++lane)
+            {
+                size_t index = (begin + lane) * nodes + n;
+                result.current[index] = current[lane];
+                result.voltage[index] = voltage[lane];
+                result.power[index] = current[lane] * voltage[lane];
+            }
+        }
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            result.allowed_current[begin + lane] = allowed_current[lane];
+        }
+    }
+}
+
+void TankCalculator::sweep_capacitors_tank(
+    const std::vector<float> &frequencies,
+    const std::vector<float> &currents,
+    TankSweepResult &result)
+{
+    sweep_compiled_tank(compiled_tank, frequencies, currents, result);
+}
+
+void TankCalculator::sweep_capacitors_tank(
+    const std::vector<float> &frequencies,
+    const std::vector<float> &currents,
+    BasicTankSweepResult<float> &result)
+{
+    sweep_compiled_tank(compiled_tank, frequencies, currents, result);
+}
+
+static int search_main(const ProgramData &data)
+{
+    if (data.top < 1)
+    {
+        std::cerr << "Error: At least one design must be listed." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<CapacitorSpecification> capacitor_spec = parse_capacitor_specifications_file(data.capacitor_spec_file);
+
+    DesignSearchOptions options;
+    options.current = data.i;
+    options.frequency = data.f;
+    options.top = data.top;
+    DesignSearchResult result = search_tank_designs(capacitor_spec, options);
+
+    for (size_t k = 0; k < result.designs.size(); ++k)
+    {
+        const TankDesign &design = result.designs[k];
+        std::cout << "Design " << k + 1 << ": -group1";
+        for (auto &name : design.group1)
+        {
+            std::cout << " " << name;
+        }
+        std::cout << " -group2";
+        for (auto &name : design.group2)
+        {
+            std::cout << " " << name;
+        }
+        std::cout << ", Rated current: " << design.rated_current << ", Margin: " << design.margin << std::endl;
+    }
+    if (result.designs.empty())
+    {
+        std::cout << "No design carries " << data.i << "A at " << data.f << "Hz." << std::endl;
+    }
+
+    return 0;
+}
+
+static int batch_main(TankCalculator &tank_calculator, const ProgramData &data)
+{
+    std::FILE *input = data.batch == "-" ? stdin : std::fopen(data.batch.c_str(), "rb");
+    if (!input)
+    {
+        std::cerr << "Error: Could not open batch file " << data.batch << "." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::FILE *output = data.output == "-" ? stdout : std::fopen(data.output.c_str(), "wb");
+    if (!output)
+    {
+        std::cerr << "Error: Could not open output file " << data.output << "." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    BatchStats stats = run_batch(tank_calculator, input, output);
+
+    if (input != stdin)
+    {
+        std::fclose(input);
+    }
+    if (output != stdout)
+    {
+        std::fclose(output);
+    }
+    if (stats.skipped_lines > 0)
+    {
+        std::cerr << "Warning: " << stats.skipped_lines << " malformed lines skipped." << std::endl;
+    }
+    return 0;
+}
+
+static void render_results(const ProgramData &data, const TankResultTable &table, const ViolationReport &violations, double allowed_current)
+{
+    if (data.format == "csv")
+    {
+        render_csv(std::cout, table);
+    }
+    else if (data.format == "json")
+    {
+        render_json(std::cout, table, &violations);
+    }
+    else
+    {
+        render_console(std::cout, table, &violations);
+        std::cout << "Allowed current: " << allowed_current << std::endl;
+    }
+}
+
+static int monte_carlo_main(const CompiledTank &tank, const ProgramData &data)
+{
+    if (data.distribution != "uniform" && data.distribution != "normal")
+    {
+        std::cerr << "Error: Unknown distribution " << data.distribution << ". Use uniform or normal." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    MonteCarloOptions options;
+    options.current = data.i;
+    options.frequency = data.f;
+    options.samples = static_cast<uint64_t>(data.monte_carlo);
+    options.seed = static_cast<uint64_t>(data.seed);
+    ToleranceDistribution distribution = data.distribution == "normal" ? ToleranceDistribution::Normal : ToleranceDistribution::Uniform;
+    options.capacitance = {distribution, data.tolerance};
+    options.limits = {distribution, data.limit_tolerance};
+
+    MonteCarloResult result = run_monte_carlo(tank, options);
+    for (const NodeStatistics &node : result.nodes)
+    {
+        std::cout << "Capacitor: " << node.name
+                  << ", Current p50: " << node.current_p50 << ", p95: " << node.current_p95
+                  << ", p99: " << node.current_p99 << ", max: " << node.current_max
+                  << ", Violation probability: " << node.violation_probability << std::endl;
+    }
+    std::cout << "Tank violation probability: " << result.violation_probability << std::endl;
+    return 0;
+}
+
+static int worst_case_main(const CompiledTank &tank, const ProgramData &data)
+{
+    WorstCaseOptions options;
+    options.current = data.i;
+    options.frequency = data.f;
+    options.current_tolerance = data.i_tolerance;
+    options.frequency_tolerance = data.f_tolerance;
+    options.capacitance_tolerance = data.tolerance;
+
+    WorstCaseResult result = run_worst_case(tank, options);
+    for (const NodeBounds &node : result.nodes)
+    {
+        std::cout << "Capacitor: " << node.name
+                  << ", Current: [" << node.current.lo << ", " << node.current.hi << "]"
+                  << ", Voltage: [" << node.voltage.lo << ", " << node.voltage.hi << "]"
+                  << ", Power: [" << node.power.lo << ", " << node.power.hi << "]" << std::endl;
+    }
+    for (const Violation &violation : result.violations)
+    {
+        std::cout << format_violation(violation, tank.names()[violation.node]) << std::endl;
+    }
+    std::cout << "Allowed current: [" << result.allowed_current.lo << ", " << result.allowed_current.hi << "]" << std::endl;
+    return 0;
+}
+
+static int sensitivity_main(const CompiledTank &tank, const ProgramData &data)
+{
+    SensitivityOptions options;
+    options.current = data.i;
+    options.frequency = data.f;
+    SensitivityResult result = run_sensitivity(tank, options);
+
+    std::cout << "output,value";
+    for (uint32_t part : result.parts)
+    {
+        std::cout << ",d/dC " << tank.names()[part];
+    }
+    std::cout << ",d/df" << std::endl;
+
+    auto print_row = [&](const std::string &output, size_t row) {
+        std::cout << output << "," << result.values[row];
+        for (size_t column = 0; column < result.columns; ++column)
+        {
+            std::cout << "," << result.at(row, column);
+        }
+        std::cout << std::endl;
+    };
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        print_row("current " + tank.names()[n], result.current_row(n));
+        print_row("voltage " + tank.names()[n], result.voltage_row(n));
+        print_row("power " + tank.names()[n], result.power_row(n));
+    }
+    print_row("allowed current", result.allowed_current_row());
+    return 0;
+}
+
+static int faults_main(const CompiledTank &tank, const ProgramData &data)
+{
+    FaultOptions options;
+    options.current = data.i;
+    options.frequency = data.f;
+    FaultAnalysisResult result = run_fault_analysis(tank, options);
+
+    auto print_peak = [&](const char *label, const StressPeak &peak) {
+        std::cout << ", " << label << ": " << 100 * peak.utilization << "% on " << tank.names()[peak.node];
+    };
+    size_t violating = 0;
+    for (const FaultScenario &scenario : result.scenarios)
+    {
+        std::cout << "Open: " << tank.names()[scenario.part] << " (node " << scenario.part << ")";
+        if (scenario.tank_open)
+        {
+            std::cout << ", the tank is open";
+        }
+        else
+        {
+            print_peak("Current", scenario.current);
+            print_peak("Voltage", scenario.voltage);
+            print_peak("Power", scenario.power);
+        }
+        std::cout << (scenario.violates() ? ", Violation" : "") << std::endl;
+        violating += scenario.violates();
+    }
+    std::cout << "Failures exceeding a limit: " << violating << " of " << result.scenarios.size() << std::endl;
+    return 0;
+}
+
+static int envelope_main(const CompiledTank &tank, const ProgramData &data)
+{
+    AllowedCurrentEnvelope envelope;
+    try
+    {
+        envelope = AllowedCurrentEnvelope(tank, data.f, data.envelope);
+    }
+    catch (const std::invalid_argument &err)
+    {
+        std::cerr << "Error: " << err.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    for (const EnvelopePiece &piece : envelope.pieces())
+    {
+        const char *limit = piece.limit == ViolationKind::Overcurrent ? "current"
+                          : piece.limit == ViolationKind::Overvoltage ? "voltage"
+                                                                      : "power";
+        std::cout << "From " << piece.f_begin << " Hz to " << piece.f_end << " Hz, Allowed current: "
+                  << piece.coefficient << " * f^" << piece.exponent << ", limited by the " << limit
+                  << " of " << tank.names()[piece.node] << std::endl;
+    }
+    return 0;
+}
+
+static int spectrum_main(const CompiledTank &tank, const ProgramData &data)
+{
+    std::ifstream file(data.spectrum);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: Could not open spectrum file " << data.spectrum << "." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<Harmonic> harmonics;
+    std::string line;
+    for (size_t line_number = 1; std::getline(file, line); ++line_number)
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        Harmonic harmonic;
+        char comma = 0;
+        std::istringstream fields(line);
+        if (!(fields >> harmonic.frequency >> comma >> harmonic.current) || comma != ',' || !(harmonic.frequency > 0))
+        {
+            std::cerr << "Error: Spectrum line " << line_number << " is not \"frequency,current\" with a positive frequency." << std::endl;
             exit(EXIT_FAILURE);
         }
+        harmonics.push_back(harmonic);
+    }
 
-        auto cap = Capacitor(
-                stored_specs[name]->capacitance*1e6,
-                stored_specs[name]->voltage,
-                stored_specs[name]->current,
-                stored_specs[name]->power,
-                stored_specs[name]->name);
-        
-        capacitors_group2.push_back(cap);
+    HarmonicEvaluator evaluator(tank);
+    evaluator.evaluate(harmonics);
+    ViolationReport violations(3 * tank.size());
+    evaluator.check_limits(violations);
 
-        caps2.push_back(new CapacitoDumpValueDecorator(&capacitors_group2[0]));
+    TankResultTable table;
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        table.rows.push_back({table.name_id(tank.names()[n]), evaluator.node_current()[n], evaluator.node_voltage()[n],
+                              evaluator.node_reactive_power()[n]});
     }
-    
-    parallel2 = ParallelCapacitor(caps2, "parallel2");
+    render_results(data, table, violations, evaluator.allowed_current());
+    return 0;
 }
 
-double TankCalculator::calculate_capacitors_tank(float frequency, float current)
+static int waveform_main(const CompiledTank &tank, const ProgramData &data)
 {
-    CapacitoDumpValueDecorator dump1(&parallel1);
-    CapacitoDumpValueDecorator dump2(&parallel2);
+    if (!(data.sample_rate > 0) || data.window <= 0 || !(data.highpass > 0))
+    {
+        std::cerr << "Error: -sample-rate, -window and -highpass must be positive." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    WaveformOptions options;
+    options.sample_rate = data.sample_rate;
+    options.window = static_cast<size_t>(data.window);
+    options.highpass = data.highpass;
+    WaveformAnalyzer analyzer(tank, options);
 
-    CapacitorMaxViolationCheckDecorator current_violation_checker1(&dump1);
-    CapacitorMaxViolationCheckDecorator current_violation_checker2(&dump2);
+    std::FILE *input = data.waveform == "-" ? stdin : std::fopen(data.waveform.c_str(), "rb");
+    if (input == nullptr)
+    {
+        std::cerr << "Error: Could not open waveform file " << data.waveform << "." << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
-    std::vector<CapacitorInterface*> serials;
-    serials.push_back(&current_violation_checker1);
-    serials.push_back(&current_violation_checker2);
+    uint64_t violating = 0;
+    stream_waveform(analyzer, input, [&](uint64_t window, const ViolationReport &violations) {
+        double time = (analyzer.settle_samples() + window * options.window) / options.sample_rate;
+        for (const Violation &violation : violations)
+        {
+            std::cout << "Window " << window << " at " << time << " s: " << format_violation(violation, tank.names()[violation.node]) << std::endl;
+        }
+        ++violating;
+    });
+    if (input != stdin)
+    {
+        std::fclose(input);
+    }
 
-    SeriesCapacitor serial(serials, "serial");
-    CapacitoDumpValueDecorator dump3(&serial);
-    return dump3.current(frequency, current);
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        WaveformNodeStatistics statistics = analyzer.node_statistics(n);
+        std::cout << "Capacitor: " << tank.names()[n] << ", RMS current: " << statistics.rms_current
+                  << ", Peak current: " << statistics.peak_current << ", RMS voltage: " << statistics.rms_voltage
+                  << ", Peak voltage: " << statistics.peak_voltage << std::endl;
+    }
+    std::cout << "Samples: " << analyzer.samples() << " after " << analyzer.settle_samples() << " settling" << ", Windows exceeding a limit: " << violating << " of " << analyzer.windows() << std::endl;
+    return 0;
 }
 
-double TankCalculator::calculate_allowed_current(float frequency)
+static int monitor_main(const CompiledTank &tank, const ProgramData &data)
 {
-    std::vector<CapacitorInterface*> serials;
-    serials.push_back(&parallel1);
-    serials.push_back(&parallel2);
+    if (!(data.hysteresis >= 0 && data.hysteresis < 1) || data.debounce <= 0)
+    {
+        std::cerr << "Error: -hysteresis must be within [0, 1) and -debounce positive." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    MonitorOptions options;
+    options.hysteresis = data.hysteresis;
+    options.debounce = static_cast<uint32_t>(data.debounce);
+    TankMonitor monitor(tank, options);
 
-    SeriesCapacitor serial(serials, "serial");
-    return serial.allowed_current(frequency);
+    // Every event is flushed at once, so a consumer of the output sees it without delay.
+    auto print_event = [&](const MonitorEvent &event) {
+        const Violation &violation = event.violation;
+        std::cout << "Update " << event.update << ": ";
+        if (event.raised)
+        {
+            std::cout << format_violation(violation, tank.names()[violation.node]) << std::endl;
+        }
+        else
+        {
+            const char *limit = violation.kind == ViolationKind::Overcurrent ? "current"
+                              : violation.kind == ViolationKind::Overvoltage ? "voltage"
+                                                                             : "power";
+            std::cout << "Cleared: The " << limit << " of " << tank.names()[violation.node] << " is " << violation.value
+                      << ", back within the maximum of " << violation.limit << "." << std::endl;
+        }
+    };
+
+    MonitorStats stats;
+    const std::string shm_prefix = "shm:";
+    try
+    {
+        if (data.monitor.compare(0, shm_prefix.size(), shm_prefix) == 0)
+        {
+            TelemetryRing ring(data.monitor.substr(shm_prefix.size()), 1 << 16);
+            stats = run_monitor(monitor, ring, print_event);
+        }
+        else
+        {
+            int fd = data.monitor == "-" ? STDIN_FILENO : ::open(data.monitor.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                std::cerr << "Error: Could not open telemetry feed " << data.monitor << "." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            stats = run_monitor(monitor, fd, print_event);
+            if (fd != STDIN_FILENO)
+            {
+                ::close(fd);
+            }
+        }
+    }
+    catch (const std::runtime_error &err)
+    {
+        std::cerr << "Error: " << err.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Updates: " << stats.updates << ", Invalid: " << monitor.invalid_updates() << ", Events: " << stats.events
+              << ", Latency p50/p99/p99.9/max: " << stats.latency.percentile(0.5) << "/" << stats.latency.percentile(0.99)
+              << "/" << stats.latency.percentile(0.999) << "/" << stats.latency.max() << " ns" << std::endl;
+    return 0;
+}
+
+static int feed_main(const ProgramData &data)
+{
+    try
+    {
+        TelemetryRing ring(data.feed);
+        TelemetrySample sample;
+        while (std::fread(&sample, sizeof(sample), 1, stdin) == 1)
+        {
+            while (!ring.push(sample))
+            {
+                std::this_thread::yield();
+            }
+        }
+        ring.close();
+    }
+    catch (const std::runtime_error &err)
+    {
+        std::cerr << "Error: " << err.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return 0;
+}
+
+static int write_catalog_main(const ProgramData &data)
+{
+    std::vector<CapacitorSpecification> capacitor_spec = parse_capacitor_specifications_file(data.capacitor_spec_file);
+    try
+    {
+        write_capacitor_catalog(capacitor_spec, data.write_catalog);
+        // Read back, so a bad write is found now and not when the catalog is used.
+        CapacitorCatalog catalog(data.write_catalog);
+        std::cout << "Wrote " << catalog.size() << " capacitors to " << data.write_catalog << std::endl;
+    }
+    catch (const std::runtime_error &err)
+    {
+        std::cerr << "Error: " << err.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return 0;
 }
 
-TankCalculator::~TankCalculator()
+static int netlist_main(const ProgramData &data)
 {
-    for (auto &cap : caps1)
+    std::vector<CapacitorSpecification> capacitor_spec = parse_capacitor_specifications_file(data.capacitor_spec_file);
+
+    std::ifstream file(data.netlist);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: Could not open netlist file " << data.netlist << "." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    TankNetlist netlist;
+    try
+    {
+        bool is_json = data.netlist.size() >= 5 && data.netlist.compare(data.netlist.size() - 5, 5, ".json") == 0;
+        netlist = is_json ? parse_netlist_json(json::parse(text), capacitor_spec) : parse_netlist_text(text, capacitor_spec);
+    }
+    catch (const std::invalid_argument &err)
+    {
+        std::cerr << err.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    catch (const json::exception &err)
+    {
+        std::cerr << "Netlist error: " << err.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    CompiledTank tank(netlist.root());
+    if (data.monte_carlo > 0)
+    {
+        return monte_carlo_main(tank, data);
+    }
+    if (data.worst_case)
     {
-        delete cap;
+        return worst_case_main(tank, data);
     }
+    if (data.sensitivity)
+    {
+        return sensitivity_main(tank, data);
+    }
+    if (data.faults)
+    {
+        return faults_main(tank, data);
+    }
+    if (data.envelope > 0)
+    {
+        return envelope_main(tank, data);
+    }
+    if (!data.spectrum.empty())
+    {
+        return spectrum_main(tank, data);
+    }
+    if (!data.waveform.empty())
+    {
+        return waveform_main(tank, data);
+    }
+    if (!data.monitor.empty())
+    {
+        return monitor_main(tank, data);
+    }
+
+    // Same evaluation as calculate_capacitors_tank, on the compiled netlist.
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.current(data.f, data.i);
 
-    for (auto &cap : caps2)
+    TankResultTable table;
+    table.names = tank.names();
+    table.rows.reserve(tank.size());
+    for (size_t n = 0; n < tank.size(); ++n)
     {
-        delete cap;
+        table.add(static_cast<uint32_t>(n), evaluator.node_current()[n], evaluator.node_voltage()[n]);
     }
+    ViolationReport violations(3 * tank.size());
+    evaluator.check_limits(violations);
+
+    render_results(data, table, violations, evaluator.allowed_current());
+    return 0;
+}
+
+static int serve_main(const ProgramData &data)
+{
+    std::shared_ptr<const PartIndex> parts = load_part_index(data.capacitor_spec_file);
+    TankServer server(parts);
+
+    try
+    {
+        std::cerr << "Serving " << parts->size() << " capacitors on " << data.serve << std::endl;
+        serve_unix_socket(server, data.serve);
+    }
+    catch (const std::runtime_error &err)
+    {
+        std::cerr << "Error: " << err.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    return 0;
 }
 
 int _main_(int argc, char **argv)
@@ -235,6 +1069,37 @@ int _main_(int argc, char **argv)
     // get the command line parameters
     ProgramData data = get_commnad_line_params(argc, argv);
 
+    if (data.format != "console" && data.format != "csv" && data.format != "json")
+    {
+        std::cerr << "Error: Unknown output format " << data.format << ". Use console, csv or json." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (!data.write_catalog.empty())
+    {
+        return write_catalog_main(data);
+    }
+
+    if (data.search)
+    {
+        return search_main(data);
+    }
+
+    if (!data.serve.empty())
+    {
+        return serve_main(data);
+    }
+
+    if (!data.feed.empty())
+    {
+        return feed_main(data);
+    }
+
+    if (!data.netlist.empty())
+    {
+        return netlist_main(data);
+    }
+
     // validate constraints on the input data
     if (data.group1.size() < 1 || data.group1.size() > 5)
     {
@@ -248,15 +1113,59 @@ int _main_(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
-    std::vector<CapacitorSpecification> capacitor_spec = parse_capacitor_specifications_file(data.capacitor_spec_file);
-
     // Calculate the tank capacitors
-    TankCalculator tank_calculator(capacitor_spec);
+    TankCalculator tank_calculator(load_part_index(data.capacitor_spec_file));
     tank_calculator.compose_capacitors_tank(data.group1, data.group2);
+
+    if (!data.batch.empty())
+    {
+        return batch_main(tank_calculator, data);
+    }
+
+    if (data.monte_carlo > 0)
+    {
+        return monte_carlo_main(tank_calculator.compiled(), data);
+    }
+
+    if (data.worst_case)
+    {
+        return worst_case_main(tank_calculator.compiled(), data);
+    }
+
+    if (data.sensitivity)
+    {
+        return sensitivity_main(tank_calculator.compiled(), data);
+    }
+
+    if (data.faults)
+    {
+        return faults_main(tank_calculator.compiled(), data);
+    }
+
+    if (data.envelope > 0)
+    {
+        return envelope_main(tank_calculator.compiled(), data);
+    }
+
+    if (!data.spectrum.empty())
+    {
+        return spectrum_main(tank_calculator.compiled(), data);
+    }
+
+    if (!data.waveform.empty())
+    {
+        return waveform_main(tank_calculator.compiled(), data);
+    }
+
+    if (!data.monitor.empty())
+    {
+        return monitor_main(tank_calculator.compiled(), data);
+    }
+
     tank_calculator.calculate_capacitors_tank(data.f, data.i);
     auto allowed_current = tank_calculator.calculate_allowed_current(data.f);
-    std::cout << "Allowed current: " << allowed_current << std::endl;
 
+    render_results(data, tank_calculator.last_results(), tank_calculator.last_violations(), allowed_current);
     return 0;
 }
 
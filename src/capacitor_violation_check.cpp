@@ -2,8 +2,6 @@
 #include <algorithm>
 #include <stdexcept>
 #include <numeric>
-#include <sstream>
-#include <iomanip>
 #include <string>
 #include <iostream>
 #include <cmath>
@@ -18,7 +16,7 @@ double CapacitorMaxViolationCheckDecoratorBase::xc(double f) const {
     return cap->xc(f);
 }
 
-std::string CapacitorMaxViolationCheckDecoratorBase::name() const {
+const std::string& CapacitorMaxViolationCheckDecoratorBase::name() const {
     return cap->name();
 }
 
@@ -30,40 +28,50 @@ double CapacitorMaxViolationCheckDecoratorBase::allowed_current(double f) const
     return cap->allowed_current(f);
 }
 
+CapacitorKind CapacitorMaxViolationCheckDecoratorBase::kind() const {
+    return cap->kind();
+}
+
+const std::vector<CapacitorInterface*>& CapacitorMaxViolationCheckDecoratorBase::capacitors() const {
+    return cap->capacitors();
+}
+
 CapacitorMaxViolationCheckDecorator::CapacitorMaxViolationCheckDecorator(CapacitorInterface* cap) 
     : CapacitorMaxViolationCheckDecoratorBase(cap) 
 {
     
 }
 
+CapacitorMaxViolationCheckDecorator::CapacitorMaxViolationCheckDecorator(CapacitorInterface* cap, ViolationReport* report, uint32_t node)
+    : CapacitorMaxViolationCheckDecoratorBase(cap), report(report), node(node)
+{
+
+}
+
+void CapacitorMaxViolationCheckDecorator::_violation(ViolationKind kind, double value, double limit) const {
+    if (report) {
+        report->record(node, kind, value, limit);
+        return;
+    }
+
+    std::string message = format_violation({node, kind, value, limit}, cap->name());
+    #ifdef LOG_CONSOLE
+        std::cout << message << std::endl;
+    #else
+        throw std::runtime_error(message);
+    #endif
+}
+
 double CapacitorMaxViolationCheckDecorator::current(double f, double voltage) const {
     double spec_max_current = cap->spec().get_i_max();
     double current = cap->current(f, voltage);
     if (current > spec_max_current) {
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(0) << 
-            "Warning: Overcurrent condition on " << cap->name() << 
-            ". The current is " << current << "A" << 
-            ", which exceeds the maximum current of " << spec_max_current << "A!";
-        #ifdef LOG_CONSOLE
-            std::cout << oss.str() << std::endl;
-        #else
-            throw std::runtime_error(oss.str());
-        #endif
+        _violation(ViolationKind::Overcurrent, current, spec_max_current);
     }
 
     double spec_max_power = cap->spec().get_power_max();
     if (current * voltage > spec_max_power) {
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(0) << 
-            "Warning: Overpower condition on " << cap->name() << 
-            ". The power is " << current * voltage << 
-            "W, which exceeds the maximum power of " << spec_max_power << "W!";
-        #ifdef LOG_CONSOLE
-            std::cout << oss.str() << std::endl;
-        #else
-            throw std::runtime_error(oss.str());
-        #endif
+        _violation(ViolationKind::Overpower, current * voltage, spec_max_power);
     }
 
     return current;
@@ -75,35 +83,12 @@ double CapacitorMaxViolationCheckDecorator::voltage(double f, double current) co
     double voltage = cap->voltage(f, current);
     
     if (voltage > spec_max_voltage) {
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(0) << 
-            "Warning: Overvoltage condition on " << cap->name() << 
-            ". The voltage is " << voltage << 
-            "V, which exceeds the maximum voltage of " << spec_max_voltage << "V!";
-        #ifdef LOG_CONSOLE
-            std::cout << oss.str() << std::endl;
-        #else
-            throw std::runtime_error(oss.str());
-        #endif
+        _violation(ViolationKind::Overvoltage, voltage, spec_max_voltage);
     }
 
     double spec_max_power = cap->spec().get_power_max();
     if (current * voltage > spec_max_power) {
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(0) << 
-            "Warning: Overpower condition on " << cap->name() << 
-            ". The power is " << current * voltage << 
-            "W, which exceeds the maximum power of " << spec_max_power << "W!";
-        
-        #ifdef LOG_CONSOLE
-            std::cout << oss.str() << std::endl;
-        #else
-            throw std::runtime_error(oss.str());
-        #endif
+        _violation(ViolationKind::Overpower, current * voltage, spec_max_power);
     }
     return voltage;
 }
-
-
-
-
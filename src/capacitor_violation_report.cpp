@@ -0,0 +1,34 @@
+#include <sstream>
+#include <iomanip>
+#include <string>
+
+#include "capacitor_violation_report.h"
+
+ViolationReport::ViolationReport(size_t capacity) : _violations(capacity)
+{
+}
+
+std::string format_violation(const Violation& violation, const std::string& name)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(0);
+    switch (violation.kind)
+    {
+    case ViolationKind::Overcurrent:
+        oss << "Warning: Overcurrent condition on " << name <<
+            ". The current is " << violation.value << "A" <<
+            ", which exceeds the maximum current of " << violation.limit << "A!";
+        break;
+    case ViolationKind::Overvoltage:
+        oss << "Warning: Overvoltage condition on " << name <<
+            ". The voltage is " << violation.value <<
+            "V, which exceeds the maximum voltage of " << violation.limit << "V!";
+        break;
+    case ViolationKind::Overpower:
+        oss << "Warning: Overpower condition on " << name <<
+            ". The power is " << violation.value <<
+            "W, which exceeds the maximum power of " << violation.limit << "W!";
+        break;
+    }
+    return oss.str();
+}
@@ -0,0 +1,196 @@
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "capacitor_waveform.h"
+
+WaveformAnalyzer::WaveformAnalyzer(const CompiledTank &tank, const WaveformOptions &options)
+    : tank(tank), options(options), _response(tank), _violations(3 * tank.size())
+{
+    if (!(options.sample_rate > 0) || options.window == 0 || !(options.highpass > 0))
+    {
+        throw std::invalid_argument("Waveform analysis needs a positive sample rate, window and high-pass corner.");
+    }
+    _dt = 1 / options.sample_rate;
+    _pole = std::exp(-2 * M_PI * options.highpass / options.sample_rate);
+    _settle_samples = static_cast<uint64_t>(std::ceil(10 * options.sample_rate / (2 * M_PI * options.highpass)));
+    _settling = _settle_samples;
+
+    // Well above the corner, the sampled highpass passes 1 / sqrt(pole) of its input and the sampled leaky
+    // integrator 1 / sqrt(pole) of a true one; scaling both back leaves only the DC block's own attenuation.
+    // At 1 A and 1 Hz the RMS charge is 1 / (2 pi) C, so a node voltage per coulomb is 2 pi times its
+    // unit voltage.
+    _current_gain = std::sqrt(_pole);
+    _unit_voltage_per_charge = 2 * M_PI * _pole;
+}
+
+void WaveformAnalyzer::process(const float *samples, size_t count, const WindowCallback &on_violation)
+{
+    // Filter state in locals, so the loop keeps it in registers.
+    double previous_input = _previous_input;
+    double current = _current;
+    double charge = _charge;
+    const double pole = _pole;
+    const double dt = _dt;
+
+    size_t k = 0;
+    size_t settle_end = static_cast<size_t>(std::min<uint64_t>(count, _settling));
+    for (; k < settle_end; ++k)
+    {
+        double input = samples[k];
+        current = input - previous_input + pole * current;
+        previous_input = input;
+        charge = pole * charge + current * dt;
+    }
+    _settling -= settle_end;
+
+    while (k < count)
+    {
+        // Up to the end of the window, without a window check per sample.
+        size_t run = std::min(count - k, options.window - _window_samples);
+        size_t end = k + run;
+        double current_squares = 0.0;
+        double charge_squares = 0.0;
+        double peak_current = _peak_current;
+        double peak_charge = _peak_charge;
+        for (; k < end; ++k)
+        {
+            double input = samples[k];
+            current = input - previous_input + pole * current;
+            previous_input = input;
+            charge = pole * charge + current * dt;
+            current_squares += current * current;
+            charge_squares += charge * charge;
+            peak_current = std::max(peak_current, std::fabs(current));
+            peak_charge = std::max(peak_charge, std::fabs(charge));
+        }
+        _window_current_squares += current_squares;
+        _window_charge_squares += charge_squares;
+        _peak_current = peak_current;
+        _peak_charge = peak_charge;
+        _samples += run;
+        _window_samples += run;
+        if (_window_samples == options.window)
+        {
+            _close_window(on_violation);
+        }
+    }
+
+    _previous_input = previous_input;
+    _current = current;
+    _charge = charge;
+}
+
+void WaveformAnalyzer::_close_window(const WindowCallback &on_violation)
+{
+    double rms_current = _current_gain * std::sqrt(_window_current_squares / _window_samples);
+    double rms_charge = _unit_voltage_per_charge * std::sqrt(_window_charge_squares / _window_samples);
+
+    _violations.clear();
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        uint32_t node = static_cast<uint32_t>(n);
+        double current = _response.current_share[n] * rms_current;
+        double voltage = _response.unit_voltage[n] * rms_charge;
+        if (current > tank.i_max()[n])
+        {
+            _violations.record(node, ViolationKind::Overcurrent, current, tank.i_max()[n]);
+        }
+        if (voltage > tank.v_max()[n])
+        {
+            _violations.record(node, ViolationKind::Overvoltage, voltage, tank.v_max()[n]);
+        }
+        if (current * voltage > tank.power_max()[n])
+        {
+            _violations.record(node, ViolationKind::Overpower, current * voltage, tank.power_max()[n]);
+        }
+    }
+    if (!_violations.empty())
+    {
+        on_violation(_windows, _violations);
+    }
+
+    _current_squares += _window_current_squares;
+    _charge_squares += _window_charge_squares;
+    _window_current_squares = 0.0;
+    _window_charge_squares = 0.0;
+    _window_samples = 0;
+    ++_windows;
+}
+
+void WaveformAnalyzer::finish(const WindowCallback &on_violation)
+{
+    if (_window_samples > 0)
+    {
+        _close_window(on_violation);
+    }
+}
+
+WaveformNodeStatistics WaveformAnalyzer::node_statistics(uint32_t node) const
+{
+    double samples = _samples > 0 ? static_cast<double>(_samples) : 1.0;
+    double current = _response.current_share[node] * _current_gain;
+    double voltage = _response.unit_voltage[node] * _unit_voltage_per_charge;
+    double rms_current = std::sqrt((_current_squares + _window_current_squares) / samples);
+    double rms_charge = std::sqrt((_charge_squares + _window_charge_squares) / samples);
+    return {current * rms_current, current * _peak_current, voltage * rms_charge, voltage * _peak_charge};
+}
+
+uint64_t stream_waveform(WaveformAnalyzer &analyzer, std::FILE *input, const WaveformAnalyzer::WindowCallback &on_violation)
+{
+    constexpr size_t buffer_samples = 1 << 16;
+
+    // Two buffers handed between the reader thread and this one; a zero-length buffer ends the stream.
+    std::vector<float> buffers[2] = {std::vector<float>(buffer_samples), std::vector<float>(buffer_samples)};
+    size_t sizes[2] = {0, 0};
+    bool full[2] = {false, false};
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    std::thread reader([&]() {
+        for (size_t b = 0;; b ^= 1)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return !full[b]; });
+            }
+            size_t read = std::fread(buffers[b].data(), sizeof(float), buffer_samples, input);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                sizes[b] = read;
+                full[b] = true;
+            }
+            changed.notify_all();
+            if (read == 0)
+            {
+                return;
+            }
+        }
+    });
+
+    for (size_t b = 0;; b ^= 1)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return full[b]; });
+        }
+        if (sizes[b] == 0)
+        {
+            break;
+        }
+        analyzer.process(buffers[b].data(), sizes[b], on_violation);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            full[b] = false;
+        }
+        changed.notify_all();
+    }
+    reader.join();
+
+    analyzer.finish(on_violation);
+    return analyzer.samples();
+}
@@ -0,0 +1,33 @@
+#include <vector>
+
+#include "capacitor_worst_case.h"
+
+WorstCaseResult run_worst_case(const CompiledTank &tank, const WorstCaseOptions &options)
+{
+    BasicCompiledTankEvaluator<Interval> evaluator(tank);
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        if (tank.kind()[n] == CapacitorKind::Single)
+        {
+            evaluator.set_cap_F(n, Interval::around(tank.cap_F()[n], options.capacitance_tolerance));
+        }
+    }
+
+    Interval frequency = Interval::around(options.frequency, options.frequency_tolerance);
+    Interval current = Interval::around(options.current, options.current_tolerance);
+
+    WorstCaseResult result;
+    evaluator.voltage(frequency, current);
+    result.allowed_current = evaluator.allowed_current();
+
+    result.nodes.reserve(tank.size());
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        result.nodes.push_back({tank.names()[n], evaluator.node_current()[n], evaluator.node_voltage()[n],
+                                evaluator.node_power(n), evaluator.node_allowed_current()[n]});
+    }
+
+    result.violations = ViolationReport(3 * tank.size());
+    evaluator.check_limits(result.violations);
+    return result;
+}
@@ -9,33 +9,48 @@
 #include <cmath>
 
 #include "capacitors.h"
+#include "capacitor_formulas.h"
 
 double CapacitorBase::xc(double f) const {
-    return 1 / (2 * M_PI * f * spec().get_cap_F());
+    return capacitor_xc(f, spec().get_cap_F());
 }
 
 double CapacitorBase::current(double f, double voltage) const {
-    return voltage / xc(f);
+    return reactance_current(voltage, xc(f));
 }
 
 double CapacitorBase::allowed_current(double f) const {
     double vmax = spec().get_v_max();
-    return vmax / xc(f);
+    return reactance_allowed_current(vmax, xc(f));
 }
 
 double CapacitorBase::voltage(double f, double current) const {
-    return current * xc(f);
+    return reactance_voltage(current, xc(f));
 }
 
 const CapacitorSpec& CapacitorBase::spec() const {
     return _spec;
 }
 
-std::string CapacitorBase::name() const {
+const std::string& CapacitorBase::name() const {
     return _cap_name;
 }
 
+CapacitorKind CapacitorBase::kind() const {
+    return CapacitorKind::Single;
+}
+
+const std::vector<CapacitorInterface*>& CapacitorBase::capacitors() const {
+    static const std::vector<CapacitorInterface*> no_capacitors;
+    return no_capacitors;
+}
+
 Capacitor::Capacitor(double cap_uF, double vmax, double imax, double power_max, std::string cap_name)
+{
+    assign(cap_uF, vmax, imax, power_max, cap_name);
+}
+
+void Capacitor::assign(double cap_uF, double vmax, double imax, double power_max, std::string_view cap_name)
 {
     _spec = CapacitorSpec(cap_uF, vmax, imax, power_max);
     if (cap_name.empty()) {
@@ -48,10 +63,8 @@ Capacitor::Capacitor(double cap_uF, double vmax, double imax, double power_max,
 }
 
 
-GroupCapacitorBase::GroupCapacitorBase(const std::vector<CapacitorInterface*>& capacitors) 
-        : _capacitors(capacitors) 
-{
-
+const std::vector<CapacitorInterface*>& GroupCapacitorBase::capacitors() const {
+    return _capacitors;
 }
 
     // static function returning the string name
@@ -71,9 +84,14 @@ const std::string GroupCapacitorBase::_get_name(const std::string& cap_name, con
     }
 }
 
-ParallelCapacitor::ParallelCapacitor(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name) 
-        : GroupCapacitorBase(capacitors)
+ParallelCapacitor::ParallelCapacitor(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name)
 {
+    assign(capacitors, cap_name);
+}
+
+void ParallelCapacitor::assign(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name)
+{
+    _capacitors.assign(capacitors.begin(), capacitors.end());
     double cap_uF = std::accumulate(capacitors.begin(), capacitors.end(), 0.0, 
                         [](double sum, CapacitorInterface* cap) { return sum + cap->spec().get_cap_uF(); });
     double vmax = (*std::min_element(capacitors.begin(), capacitors.end(),
@@ -87,10 +105,14 @@ ParallelCapacitor::ParallelCapacitor(const std::vector<CapacitorInterface*>& cap
     _cap_name = _get_name(cap_name, _spec, "parallel group");
 }
 
+CapacitorKind ParallelCapacitor::kind() const {
+    return CapacitorKind::Parallel;
+}
+
 double ParallelCapacitor::xc(double f) const {
     double reciprocal = std::accumulate(_capacitors.begin(), _capacitors.end(), 0.0, 
-                                        [f](double sum, CapacitorInterface* cap) { return sum + 1.0 / cap->xc(f); });
-    return 1.0 / reciprocal;
+                                        [f](double sum, CapacitorInterface* cap) { return sum + admittance(cap->xc(f)); });
+    return admittance(reciprocal);
 }
 
 double ParallelCapacitor::current(double f, double voltage) const {
@@ -99,7 +121,7 @@ double ParallelCapacitor::current(double f, double voltage) const {
 }
 
 double ParallelCapacitor::allowed_current(double f) const {
-    return spec().get_v_max() / xc(f);
+    return reactance_allowed_current(spec().get_v_max(), xc(f));
 }
 
 double ParallelCapacitor::voltage(double f, double current) const {
@@ -109,12 +131,17 @@ double ParallelCapacitor::voltage(double f, double current) const {
     {
         cap->voltage(f, 0.0);
     }
-    return current * xc(f);
+    return reactance_voltage(current, xc(f));
 }
 
 SeriesCapacitor::SeriesCapacitor(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name)
-    : GroupCapacitorBase(capacitors) 
 {
+    assign(capacitors, cap_name);
+}
+
+void SeriesCapacitor::assign(const std::vector<CapacitorInterface*>& capacitors, const std::string& cap_name)
+{
+    _capacitors.assign(capacitors.begin(), capacitors.end());
     double cap_uF = 1.0 / std::accumulate(capacitors.begin(), capacitors.end(), 0.0, 
                         [](double sum, CapacitorInterface* cap) { return sum + 1.0 / cap->spec().get_cap_uF(); });
     double vmax = std::accumulate(capacitors.begin(), capacitors.end(), 0.0, 
@@ -128,26 +155,35 @@ SeriesCapacitor::SeriesCapacitor(const std::vector<CapacitorInterface*>& capacit
     _cap_name = _get_name(cap_name, _spec, "serial group");
 }
 
+CapacitorKind SeriesCapacitor::kind() const {
+    return CapacitorKind::Series;
+}
+
 double SeriesCapacitor::xc(double f) const {
     return std::accumulate(_capacitors.begin(), _capacitors.end(), 0.0, 
                             [f](double sum, CapacitorInterface* cap) { return sum + cap->xc(f); });
 }
 
 double SeriesCapacitor::current(double f, double voltage) const {
-    auto current = voltage / xc(f);
+    auto current = reactance_current(voltage, xc(f));
     
     // traverse all capacitors and call the current function. The result is not important here but the side effect is important.
     for(auto cap : _capacitors)
     {
-        auto voltage_per_cap = cap->xc(f) * current;
+        auto voltage_per_cap = reactance_voltage(current, cap->xc(f));
         cap->current(f, voltage_per_cap);
     }
     return current;
 }
 
 double SeriesCapacitor::allowed_current(double f) const {
-    return (*std::min_element(_capacitors.begin(), _capacitors.end(), 
-                            [f](CapacitorInterface* a, CapacitorInterface* b) { return a->allowed_current(f) < b->allowed_current(f); }))->allowed_current(f);
+    // Same result as std::min_element over allowed_current, but each member is evaluated once.
+    double allowed = _capacitors.front()->allowed_current(f);
+    for (auto it = _capacitors.begin() + 1; it != _capacitors.end(); ++it)
+    {
+        allowed = smaller((*it)->allowed_current(f), allowed);
+    }
+    return allowed;
 }
 
 double SeriesCapacitor::voltage(double f, double current) const {
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <thread>
+#include <mutex>
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(threads);
+    for (size_t k = 0; k < threads; ++k)
+    {
+        workers.emplace_back(&ThreadPool::_worker, this);
+    }
+}
+
+void ThreadPool::_worker()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+            {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+            ++running;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+            if (running == 0 && tasks.empty())
+            {
+                tasks_done.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    tasks_done.wait(lock, [this] { return running == 0 && tasks.empty(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+
+#include "gtest/gtest.h"
+
+// The reference tank of the evaluator tests: 23uF || 1uF in series with 1uF, compiled. Fixtures derive
+// from it; c3_power_max lowers the power limit of the last part for tests that need it to bind.
+class ReferenceTankTest : public ::testing::Test {
+protected:
+    explicit ReferenceTankTest(double c3_power_max = 500e3) : c3{1, 1000, 500, c3_power_max, "1uF_1000V"} {}
+
+    Capacitor c1{23, 500, 1000, 500e3, "23uF_500V"};
+    Capacitor c2{1, 1000, 500, 500e3, "1uF_1000V"};
+    Capacitor c3;
+    ParallelCapacitor parallel1{{&c1, &c2}, "parallel1"};
+    ParallelCapacitor parallel2{{&c3}, "parallel2"};
+    SeriesCapacitor serial{{&parallel1, &parallel2}, "serial"};
+    CompiledTank tank{serial};
+};
@@ -0,0 +1,113 @@
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+
+#include "capacitor_catalog.h"
+#include "capacitor_part_index.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+class CatalogTest : public ::testing::Test {
+protected:
+    std::string path = ::testing::TempDir() + "catalog_test.tcat";
+    std::vector<CapacitorSpecification> specs = {
+        {1e-6f, 500, "1uF_1000V", 500e3f, 1000},
+        {3.3e-6f, 600, "3.3uF_800V", 500e3f, 800},
+        {23e-6f, 1000, "23uF_500V", 500e3f, 500},
+        {2e-6f, 700, "1uF_1000V", 400e3f, 900},
+        {6e-6f, 800, "", 1e6f, 750},
+    };
+
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::vector<char> read_file()
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    void write_file(const std::vector<char> &bytes)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size());
+    }
+};
+
+TEST_F(CatalogTest, RoundTrip) {
+    write_capacitor_catalog(specs, path);
+    CapacitorCatalog catalog(path);
+    ASSERT_EQ(catalog.size(), specs.size());
+    std::vector<CapacitorSpecification> read = catalog.specifications();
+    for (size_t k = 0; k < specs.size(); ++k)
+    {
+        ASSERT_EQ(read[k].name, specs[k].name);
+        ASSERT_EQ(read[k].capacitance, specs[k].capacitance);
+        ASSERT_EQ(read[k].voltage, specs[k].voltage);
+        ASSERT_EQ(read[k].current, specs[k].current);
+        ASSERT_EQ(read[k].power, specs[k].power);
+        ASSERT_EQ(catalog.capacitance()[k], specs[k].capacitance);
+    }
+}
+
+TEST_F(CatalogTest, FindByName) {
+    write_capacitor_catalog(specs, path);
+    CapacitorCatalog catalog(path);
+    ASSERT_EQ(catalog.find("23uF_500V"), 2u);
+    ASSERT_EQ(catalog.find("3.3uF_800V"), 1u);
+    ASSERT_EQ(catalog.find(""), 4u);
+    // The last of equal names, as when the JSON file is loaded into a map.
+    ASSERT_EQ(catalog.find("1uF_1000V"), 3u);
+    ASSERT_EQ(catalog.find("1uF_100V"), CapacitorCatalog::npos);
+    ASSERT_EQ(catalog.find("zzz"), CapacitorCatalog::npos);
+}
+
+TEST_F(CatalogTest, RejectsDamagedFiles) {
+    write_capacitor_catalog(specs, path);
+    std::vector<char> bytes = read_file();
+
+    std::vector<char> flipped = bytes;
+    flipped[bytes.size() - 3] ^= 1;
+    write_file(flipped);
+    ASSERT_THROW(CapacitorCatalog catalog(path), std::runtime_error);
+
+    write_file(std::vector<char>(bytes.begin(), bytes.end() - 1));
+    ASSERT_THROW(CapacitorCatalog catalog(path), std::runtime_error);
+
+    std::vector<char> other_version = bytes;
+    other_version[4] = 2;
+    write_file(other_version);
+    ASSERT_THROW(CapacitorCatalog catalog(path), std::runtime_error);
+
+    write_file(std::vector<char>(bytes.begin(), bytes.begin() + 8));
+    ASSERT_THROW(CapacitorCatalog catalog(path), std::runtime_error);
+
+    ASSERT_THROW(CapacitorCatalog catalog(path + ".missing"), std::runtime_error);
+}
+
+TEST_F(CatalogTest, PartIndexViewsMappedCatalog) {
+    write_capacitor_catalog(specs, path);
+    auto catalog = std::make_shared<const CapacitorCatalog>(path);
+    PartIndex parts(catalog);
+    ASSERT_EQ(parts.size(), specs.size());
+    // The ids are catalog positions; a repeated name finds its last listing, like the JSON loading.
+    ASSERT_EQ(parts.find("1uF_1000V"), 3u);
+    ASSERT_EQ(parts.find("23uF_500V"), 2u);
+    ASSERT_EQ(parts.find("4uF_500V"), no_part);
+    ASSERT_EQ(parts.name(2).data(), catalog->name(2).data());
+    ASSERT_EQ(parts.cap_uF(3), 2e-6f * 1e6);
+    ASSERT_EQ(parts.v_max(3), 900);
+    ASSERT_EQ(parts.i_max(3), 700);
+    ASSERT_EQ(parts.power_max(3), 400e3f);
+}
+
+TEST_F(CatalogTest, EmptyCatalog) {
+    write_capacitor_catalog({}, path);
+    CapacitorCatalog catalog(path);
+    ASSERT_EQ(catalog.size(), 0u);
+    ASSERT_EQ(catalog.find("1uF_1000V"), CapacitorCatalog::npos);
+}
+
+}
@@ -0,0 +1,179 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include <cmath>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_dump_value.h"
+#include "capacitor_violation_check.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+// Records what every node computes on the reference tree, in the order the results become available.
+struct Record {
+    std::string name;
+    double current;
+    double voltage;
+};
+
+class RecordingDecorator : public CapacitoDumpValueDecoratorBase {
+    std::vector<Record>& records;
+
+public:
+    RecordingDecorator(CapacitorInterface* cap, std::vector<Record>& records)
+        : CapacitoDumpValueDecoratorBase(cap), records(records) {}
+
+    double current(double f, double voltage) const override {
+        double current = cap->current(f, voltage);
+        records.push_back({cap->name(), current, voltage});
+        return current;
+    }
+
+    double voltage(double f, double current) const override {
+        return cap->voltage(f, current);
+    }
+};
+
+class CompiledTankTest : public ::testing::Test {
+protected:
+    std::vector<Record> records;
+    std::vector<std::unique_ptr<CapacitorInterface>> nodes;
+
+    CapacitorInterface* recorded(CapacitorInterface* cap) {
+        nodes.emplace_back(cap);
+        nodes.emplace_back(new RecordingDecorator(cap, records));
+        return nodes.back().get();
+    }
+
+    // serial(parallel(c1, c2, series(c3, c4)), parallel(c5), c6), every node recorded.
+    CapacitorInterface* build() {
+        auto c1 = recorded(new Capacitor(23, 500, 1000, 500e3, "c1"));
+        auto c2 = recorded(new Capacitor(1, 1000, 500, 500e3, "c2"));
+        auto c3 = recorded(new Capacitor(3.3, 800, 600, 500e3, "c3"));
+        auto c4 = recorded(new Capacitor(6, 750, 750, 500e3, "c4"));
+        auto c5 = recorded(new Capacitor(10, 600, 800, 500e3, "c5"));
+        auto c6 = recorded(new Capacitor(2.2, 900, 300, 200e3, "c6"));
+        auto s34 = recorded(new SeriesCapacitor({c3, c4}, "s34"));
+        auto p1 = recorded(new ParallelCapacitor({c1, c2, s34}, "p1"));
+        auto p2 = recorded(new ParallelCapacitor({c5}, "p2"));
+        return recorded(new SeriesCapacitor({p1, p2, c6}, "serial"));
+    }
+};
+
+TEST_F(CompiledTankTest, PostfixLayout) {
+    CapacitorInterface* root = build();
+    CompiledTank tank(*root);
+
+    std::vector<std::string> names = {"c1", "c2", "c3", "c4", "s34", "p1", "c5", "p2", "c6", "serial"};
+    ASSERT_EQ(tank.names(), names);
+    ASSERT_EQ(tank.root(), 9u);
+    ASSERT_EQ(tank.parent()[tank.root()], CompiledTank::no_parent);
+    ASSERT_EQ(tank.parent()[2], 4u);
+    ASSERT_EQ(tank.parent()[4], 5u);
+    ASSERT_EQ(tank.parent()[8], 9u);
+    ASSERT_EQ(tank.kind()[5], CapacitorKind::Parallel);
+    ASSERT_EQ(tank.kind()[4], CapacitorKind::Series);
+    ASSERT_EQ(tank.kind()[0], CapacitorKind::Single);
+    ASSERT_EQ(tank.v_max()[5], root->capacitors()[0]->spec().get_v_max());
+    ASSERT_EQ(tank.cap_uF()[9], root->spec().get_cap_uF());
+}
+
+TEST_F(CompiledTankTest, BitIdenticalToReference) {
+    CapacitorInterface* root = build();
+    CompiledTank tank(*root);
+    CompiledTankEvaluator evaluator(tank);
+
+    for (double f : {0.5, 50.0, 60.0, 1234.5, 1e5}) {
+        for (double excitation : {0.1, 230.0, 1e4}) {
+            ASSERT_EQ(evaluator.xc(f), root->xc(f));
+            ASSERT_EQ(evaluator.voltage(f, excitation), root->voltage(f, excitation));
+            ASSERT_EQ(evaluator.allowed_current(f), root->allowed_current(f));
+
+            records.clear();
+            ASSERT_EQ(evaluator.current(f, excitation), root->current(f, excitation));
+            ASSERT_EQ(records.size(), tank.size());
+            for (size_t n = 0; n < tank.size(); ++n) {
+                ASSERT_EQ(records[n].name, tank.names()[n]);
+                ASSERT_EQ(evaluator.node_current()[n], records[n].current);
+                ASSERT_EQ(evaluator.node_voltage()[n], records[n].voltage);
+            }
+        }
+    }
+}
+
+TEST_F(CompiledTankTest, ReactanceComputedOncePerFrequency) {
+    CompiledTank tank(*build());
+    CompiledTankEvaluator evaluator(tank);
+
+    evaluator.prepare(50);
+    ASSERT_EQ(evaluator.xc_visits(), tank.size());
+
+    evaluator.current(230);
+    evaluator.voltage(1);
+    evaluator.allowed_current();
+    evaluator.current(50, 230);
+    evaluator.allowed_current(50);
+    ASSERT_EQ(evaluator.xc_visits(), tank.size());
+
+    evaluator.allowed_current(60);
+    ASSERT_EQ(evaluator.xc_visits(), 2 * tank.size());
+}
+
+TEST_F(CompiledTankTest, CheckLimitsMatchesDecorators) {
+    // Same tree with every node wrapped in a reporting violation check, node ids in postfix order.
+    ViolationReport reference(64);
+    std::vector<std::unique_ptr<CapacitorInterface>> owned;
+    uint32_t next_id = 0;
+    auto checked = [&](CapacitorInterface* cap) {
+        owned.emplace_back(cap);
+        owned.emplace_back(new CapacitorMaxViolationCheckDecorator(cap, &reference, next_id++));
+        return owned.back().get();
+    };
+    auto c1 = checked(new Capacitor(23, 500, 1000, 500e3, "c1"));
+    auto c2 = checked(new Capacitor(1, 1000, 500, 500e3, "c2"));
+    auto p1 = checked(new ParallelCapacitor({c1, c2}, "p1"));
+    auto c3 = checked(new Capacitor(3.3, 800, 600, 500e3, "c3"));
+    auto root = checked(new SeriesCapacitor({p1, c3}, "serial"));
+
+    CompiledTank tank(*root);
+    CompiledTankEvaluator evaluator(tank);
+    ViolationReport report(64);
+
+    for (double f : {50.0, 1e4, 1e6}) {
+        reference.clear();
+        report.clear();
+        root->current(f, 1e5);
+        evaluator.current(f, 1e5);
+        evaluator.check_limits(report);
+
+        // The decorators only check current and power in current(); the compiled check also covers voltage.
+        std::vector<Violation> compiled;
+        for (const Violation& v : report) {
+            if (v.kind != ViolationKind::Overvoltage) {
+                compiled.push_back(v);
+            }
+        }
+        ASSERT_EQ(compiled.size(), reference.size());
+        for (size_t k = 0; k < compiled.size(); ++k) {
+            ASSERT_EQ(compiled[k].node, reference[k].node);
+            ASSERT_EQ(compiled[k].kind, reference[k].kind);
+            ASSERT_EQ(compiled[k].value, reference[k].value);
+            ASSERT_EQ(compiled[k].limit, reference[k].limit);
+        }
+    }
+}
+
+TEST_F(CompiledTankTest, SingleCapacitor) {
+    Capacitor cap(1, 1000, 500, 500e3);
+    CompiledTank tank(cap);
+    CompiledTankEvaluator evaluator(tank);
+
+    ASSERT_EQ(tank.size(), 1u);
+    ASSERT_EQ(evaluator.xc(1), cap.xc(1));
+    ASSERT_EQ(evaluator.current(1, 1000), cap.current(1, 1000));
+    ASSERT_EQ(evaluator.allowed_current(1), cap.allowed_current(1));
+}
+
+} // namespace
@@ -0,0 +1,84 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_envelope.h"
+
+#include "gtest/gtest.h"
+#include "tank_test_fixture.h"
+namespace {
+
+class EnvelopeTest : public ReferenceTankTest {
+protected:
+    EnvelopeTest() : ReferenceTankTest(5e3) {}
+
+    // Largest current within every limit at f, from a full evaluation.
+    double direct(double f)
+    {
+        CompiledTankEvaluator evaluator(tank);
+        evaluator.voltage(f, 1.0);
+        double allowed = HUGE_VAL;
+        for (uint32_t n = 0; n < tank.size(); ++n)
+        {
+            double current = evaluator.node_current()[n];
+            double voltage = evaluator.node_voltage()[n];
+            allowed = std::min({allowed, tank.i_max()[n] / current, tank.v_max()[n] / voltage,
+                                std::sqrt(tank.power_max()[n] / (current * voltage))});
+        }
+        return allowed;
+    }
+};
+
+TEST_F(EnvelopeTest, MatchesDirectEvaluation) {
+    AllowedCurrentEnvelope envelope(tank, 10, 1e8);
+    ASSERT_EQ(envelope.f_min(), 10);
+    ASSERT_EQ(envelope.f_max(), 1e8);
+
+    // Voltage at low frequencies, then power, then the current limit of parallel2's part.
+    const std::vector<EnvelopePiece> &pieces = envelope.pieces();
+    ASSERT_EQ(pieces.size(), 3u);
+    ASSERT_EQ(pieces[0].limit, ViolationKind::Overvoltage);
+    ASSERT_EQ(pieces[1].limit, ViolationKind::Overpower);
+    ASSERT_EQ(pieces[2].limit, ViolationKind::Overcurrent);
+    for (size_t k = 1; k < pieces.size(); ++k)
+    {
+        ASSERT_EQ(pieces[k].f_begin, pieces[k - 1].f_end);
+        ASSERT_NE(pieces[k].limit, pieces[k - 1].limit);
+    }
+
+    for (double f = 10; f <= 1e8; f *= 1.07)
+    {
+        ASSERT_NEAR(envelope(f), direct(f), 1e-12 * direct(f)) << "f=" << f;
+    }
+    // Continuous at the breakpoints.
+    for (size_t k = 1; k < pieces.size(); ++k)
+    {
+        double f = pieces[k].f_begin;
+        ASSERT_NEAR(envelope(f), direct(f), 1e-12 * direct(f));
+    }
+}
+
+TEST_F(EnvelopeTest, VoltagePieceMatchesAllowedCurrent) {
+    // The voltage limits alone are what allowed_current() checks.
+    AllowedCurrentEnvelope envelope(tank, 50, 60);
+    ASSERT_EQ(envelope.pieces().size(), 1u);
+    ASSERT_EQ(envelope.pieces()[0].limit, ViolationKind::Overvoltage);
+    for (double f : {50.0, 55.5, 60.0})
+    {
+        ASSERT_NEAR(envelope(f), serial.allowed_current(f), 1e-12 * serial.allowed_current(f));
+    }
+}
+
+TEST_F(EnvelopeTest, Errors) {
+    ASSERT_THROW(AllowedCurrentEnvelope(tank, 0, 100), std::invalid_argument);
+    ASSERT_THROW(AllowedCurrentEnvelope(tank, 100, 10), std::invalid_argument);
+    AllowedCurrentEnvelope envelope(tank, 100, 100);
+    ASSERT_EQ(envelope.pieces().size(), 1u);
+    ASSERT_THROW(envelope(99), std::invalid_argument);
+    ASSERT_NEAR(envelope(100), direct(100), 1e-12 * direct(100));
+}
+
+} // namespace
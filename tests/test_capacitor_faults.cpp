@@ -0,0 +1,173 @@
+#include <vector>
+#include <string>
+#include <deque>
+#include <map>
+#include <cmath>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_faults.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+// Tree description the test rebuilds without the failed part, as the reference for every scenario.
+struct Node
+{
+    CapacitorKind kind;
+    std::string name;
+    std::vector<Node> members;
+    double cap_uF = 0;
+};
+
+Node part(const std::string &name, double cap_uF)
+{
+    return {CapacitorKind::Single, name, {}, cap_uF};
+}
+
+struct Builder
+{
+    std::deque<Capacitor> parts;
+    std::deque<ParallelCapacitor> parallel;
+    std::deque<SeriesCapacitor> series;
+
+    // nullptr when the failed part opens the node.
+    CapacitorInterface *build(const Node &node, const std::string &failed)
+    {
+        if (node.kind == CapacitorKind::Single)
+        {
+            if (node.name == failed)
+            {
+                return nullptr;
+            }
+            parts.emplace_back(node.cap_uF, 200 + 20 * node.cap_uF, 5 + node.cap_uF, 2000, node.name);
+            return &parts.back();
+        }
+        std::vector<CapacitorInterface *> members;
+        for (const Node &member : node.members)
+        {
+            CapacitorInterface *built = build(member, failed);
+            if (!built && node.kind == CapacitorKind::Series)
+            {
+                return nullptr;
+            }
+            if (built)
+            {
+                members.push_back(built);
+            }
+        }
+        if (members.empty())
+        {
+            return nullptr;
+        }
+        if (node.kind == CapacitorKind::Parallel)
+        {
+            parallel.emplace_back(members, node.name);
+            return &parallel.back();
+        }
+        series.emplace_back(members, node.name);
+        return &series.back();
+    }
+};
+
+// Utilization of every node by name, from a full evaluation.
+std::map<std::string, std::array<double, 3>> utilization(const CompiledTank &tank, const FaultOptions &options)
+{
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(options.frequency, options.current);
+    std::map<std::string, std::array<double, 3>> result;
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        double current = evaluator.node_current()[n];
+        double voltage = evaluator.node_voltage()[n];
+        result[tank.names()[n]] = {current / tank.i_max()[n], voltage / tank.v_max()[n],
+                                   current * voltage / tank.power_max()[n]};
+    }
+    return result;
+}
+
+void expect_peak(const std::map<std::string, std::array<double, 3>> &reference, const CompiledTank &tank,
+                 const StressPeak &peak, size_t kind)
+{
+    double highest = 0;
+    for (const auto &node : reference)
+    {
+        highest = std::max(highest, node.second[kind]);
+    }
+    EXPECT_NEAR(peak.utilization, highest, 1e-9 * highest);
+    EXPECT_NEAR(reference.at(tank.names()[peak.node])[kind], peak.utilization, 1e-9 * highest);
+}
+
+TEST(FaultAnalysisTest, MatchesRebuiltTanks) {
+    Node tree{CapacitorKind::Series, "root", {
+        {CapacitorKind::Parallel, "g1", {part("p0", 10), part("p1", 4.7),
+            {CapacitorKind::Series, "g2", {part("p2", 22), part("p3", 33)}}, part("p4", 1)}},
+        {CapacitorKind::Parallel, "g3", {part("p5", 15)}},
+        {CapacitorKind::Parallel, "g4", {part("p6", 6.8),
+            {CapacitorKind::Parallel, "g5", {part("p7", 2.2), part("p8", 3.3)}}}}}};
+
+    FaultOptions options;
+    options.current = 12;
+    options.frequency = 400;
+
+    Builder intact;
+    CompiledTank tank(*intact.build(tree, ""));
+    FaultAnalysisResult result = run_fault_analysis(tank, options);
+
+    auto reference = utilization(tank, options);
+    expect_peak(reference, tank, result.current, 0);
+    expect_peak(reference, tank, result.voltage, 1);
+    expect_peak(reference, tank, result.power, 2);
+
+    ASSERT_EQ(result.scenarios.size(), 9u);
+    for (const FaultScenario &scenario : result.scenarios)
+    {
+        const std::string &failed = tank.names()[scenario.part];
+        SCOPED_TRACE(failed);
+        Builder builder;
+        CapacitorInterface *root = builder.build(tree, failed);
+        ASSERT_EQ(scenario.tank_open, root == nullptr);
+        if (!root)
+        {
+            ASSERT_TRUE(scenario.violates());
+            continue;
+        }
+        CompiledTank rebuilt(*root);
+        auto survivors = utilization(rebuilt, options);
+        expect_peak(survivors, tank, scenario.current, 0);
+        expect_peak(survivors, tank, scenario.voltage, 1);
+        expect_peak(survivors, tank, scenario.power, 2);
+    }
+}
+
+TEST(FaultAnalysisTest, SurvivorsTakeTheCurrent) {
+    // Three equal parts, each rated for the half of the current: any failure overloads the other two.
+    Capacitor a(10, 1000, 50, 1e9, "a");
+    Capacitor b(10, 1000, 50, 1e9, "b");
+    Capacitor c(10, 1000, 50, 1e9, "c");
+    ParallelCapacitor bank({&a, &b, &c}, "bank");
+    CompiledTank tank(bank);
+
+    FaultOptions options;
+    options.current = 90;
+    options.frequency = 10000;
+    FaultAnalysisResult result = run_fault_analysis(tank, options);
+
+    ASSERT_NEAR(result.current.utilization, 0.6, 1e-12);
+    for (const FaultScenario &scenario : result.scenarios)
+    {
+        ASSERT_FALSE(scenario.tank_open);
+        ASSERT_NE(scenario.current.node, scenario.part);
+        ASSERT_NEAR(scenario.current.utilization, 0.9, 1e-12);
+        ASSERT_FALSE(scenario.violates());
+    }
+
+    options.current = 120;
+    result = run_fault_analysis(tank, options);
+    for (const FaultScenario &scenario : result.scenarios)
+    {
+        ASSERT_TRUE(scenario.violates());
+    }
+}
+
+} // namespace
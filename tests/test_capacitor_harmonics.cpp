@@ -0,0 +1,107 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_harmonics.h"
+
+#include "gtest/gtest.h"
+#include "tank_test_fixture.h"
+namespace {
+
+class HarmonicsTest : public ReferenceTankTest {
+protected:
+    // Inverter-like spectrum: odd harmonics of 1 kHz falling as 1/h, 101 harmonics so the last block is partial.
+    std::vector<Harmonic> spectrum(double fundamental_current)
+    {
+        std::vector<Harmonic> harmonics;
+        for (int h = 1; h <= 201; h += 2)
+        {
+            harmonics.push_back({1000.0 * h, fundamental_current / h});
+        }
+        return harmonics;
+    }
+};
+
+TEST_F(HarmonicsTest, MatchesPerHarmonicEvaluation) {
+    std::vector<Harmonic> harmonics = spectrum(30);
+    HarmonicEvaluator harmonic_evaluator(tank);
+    double rms = harmonic_evaluator.evaluate(harmonics);
+
+    std::vector<double> current(tank.size()), voltage(tank.size()), reactive(tank.size());
+    double sum = 0;
+    CompiledTankEvaluator evaluator(tank);
+    for (const Harmonic &harmonic : harmonics)
+    {
+        evaluator.voltage(harmonic.frequency, harmonic.current);
+        for (uint32_t n = 0; n < tank.size(); ++n)
+        {
+            current[n] += evaluator.node_current()[n] * evaluator.node_current()[n];
+            voltage[n] += evaluator.node_voltage()[n] * evaluator.node_voltage()[n];
+            reactive[n] += evaluator.node_power(n);
+        }
+        sum += harmonic.current * harmonic.current;
+    }
+
+    ASSERT_NEAR(rms, std::sqrt(sum), 1e-12 * rms);
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        ASSERT_NEAR(harmonic_evaluator.node_current()[n], std::sqrt(current[n]), 1e-12 * std::sqrt(current[n]));
+        ASSERT_NEAR(harmonic_evaluator.node_voltage()[n], std::sqrt(voltage[n]), 1e-12 * std::sqrt(voltage[n]));
+        ASSERT_NEAR(harmonic_evaluator.node_reactive_power()[n], reactive[n], 1e-12 * reactive[n]);
+    }
+}
+
+TEST_F(HarmonicsTest, SingleHarmonicMatchesEvaluator) {
+    HarmonicEvaluator harmonic_evaluator(tank);
+    harmonic_evaluator.evaluate({{1000, 30}});
+    ViolationReport harmonic_report;
+    harmonic_evaluator.check_limits(harmonic_report);
+
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(1000, 30);
+    ViolationReport report;
+    evaluator.check_limits(report);
+
+    ASSERT_EQ(harmonic_report.size(), report.size());
+    for (size_t k = 0; k < report.size(); ++k)
+    {
+        ASSERT_EQ(harmonic_report[k].node, report[k].node);
+        ASSERT_EQ(harmonic_report[k].kind, report[k].kind);
+        ASSERT_NEAR(harmonic_report[k].value, report[k].value, 1e-12 * report[k].value);
+    }
+}
+
+TEST_F(HarmonicsTest, AllowedCurrentIsTheViolationThreshold) {
+    HarmonicEvaluator harmonic_evaluator(tank);
+    double rms = harmonic_evaluator.evaluate(spectrum(1));
+    double allowed = harmonic_evaluator.allowed_current();
+    ASSERT_GT(allowed, 0);
+
+    ViolationReport report;
+    harmonic_evaluator.evaluate(spectrum(0.999 * allowed / rms));
+    harmonic_evaluator.check_limits(report);
+    ASSERT_TRUE(report.empty());
+    ASSERT_NEAR(harmonic_evaluator.allowed_current(), allowed, 1e-9 * allowed);
+
+    harmonic_evaluator.evaluate(spectrum(1.001 * allowed / rms));
+    harmonic_evaluator.check_limits(report);
+    ASSERT_FALSE(report.empty());
+}
+
+TEST_F(HarmonicsTest, RejectsSpectraWithoutShape) {
+    HarmonicEvaluator harmonic_evaluator(tank);
+    ASSERT_EQ(harmonic_evaluator.allowed_current(), 0);
+    harmonic_evaluator.evaluate(std::vector<Harmonic>{{50, 0}, {150, 0}});
+    ASSERT_EQ(harmonic_evaluator.allowed_current(), 0);
+
+    double rms = harmonic_evaluator.evaluate(spectrum(1));
+    std::vector<double> current = harmonic_evaluator.node_current();
+    ASSERT_THROW(harmonic_evaluator.evaluate(std::vector<Harmonic>{{50, 1}, {0, 1}}), std::invalid_argument);
+    ASSERT_EQ(harmonic_evaluator.node_current(), current);
+    ASSERT_GT(rms, 0);
+}
+
+} // namespace
@@ -0,0 +1,148 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <cmath>
+
+#include "capacitors.h"
+#include "capacitor_kernels.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+class CapacitorKernelsTest : public ::testing::TestWithParam<KernelIsa> {
+protected:
+    const CapacitorKernels *kernels = nullptr;
+    std::mt19937 rng{7};
+
+    void SetUp() override
+    {
+        kernels = capacitor_kernels(GetParam());
+        if (!kernels)
+        {
+            GTEST_SKIP() << kernel_isa_name(GetParam()) << " is not supported on this CPU";
+        }
+    }
+
+    std::vector<double> random(size_t n, double low, double high)
+    {
+        std::uniform_real_distribution<double> distribution(low, high);
+        std::vector<double> values(n);
+        for (auto &value : values)
+        {
+            value = distribution(rng);
+        }
+        return values;
+    }
+};
+
+// Sizes around every vector width, so both the vector loop and the scalar tail are covered.
+const std::vector<size_t> sizes = {0, 1, 2, 3, 5, 8, 9, 15, 17, 64, 1001};
+
+TEST_P(CapacitorKernelsTest, ElementWiseMatchCapacitorBase) {
+    for (size_t n : sizes)
+    {
+        std::vector<double> f = random(n, 1, 1e5);
+        std::vector<double> cap_uF = random(n, 0.1, 100);
+        std::vector<double> cap_F(n), xc(n), current(n), voltage(n), power(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            cap_F[k] = CapacitorSpec(cap_uF[k], 0, 0, 0).get_cap_F();
+        }
+        std::vector<double> drive = random(n, 0, 1e4);
+
+        kernels->xc(f.data(), cap_F.data(), xc.data(), n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            Capacitor cap(cap_uF[k], 1000, 500, 500e3);
+            ASSERT_EQ(xc[k], cap.xc(f[k])) << "n=" << n << " k=" << k;
+        }
+
+        kernels->current(drive.data(), xc.data(), current.data(), power.data(), n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            Capacitor cap(cap_uF[k], 1000, 500, 500e3);
+            ASSERT_EQ(current[k], cap.current(f[k], drive[k]));
+            ASSERT_EQ(power[k], current[k] * drive[k]);
+        }
+
+        kernels->voltage(drive.data(), xc.data(), voltage.data(), power.data(), n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            Capacitor cap(cap_uF[k], 1000, 500, 500e3);
+            ASSERT_EQ(voltage[k], cap.voltage(f[k], drive[k]));
+            ASSERT_EQ(power[k], drive[k] * voltage[k]);
+        }
+    }
+}
+
+TEST_P(CapacitorKernelsTest, GroupSumsMatchComposite) {
+    for (size_t n : sizes)
+    {
+        if (n == 0)
+        {
+            continue;
+        }
+        std::vector<double> cap_uF = random(n, 0.1, 100);
+        std::vector<std::unique_ptr<Capacitor>> caps;
+        std::vector<CapacitorInterface *> members;
+        std::vector<double> xc(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            caps.push_back(std::make_unique<Capacitor>(cap_uF[k], 1000, 500, 500e3));
+            members.push_back(caps.back().get());
+            xc[k] = caps.back()->xc(50);
+        }
+        ParallelCapacitor parallel(members);
+        SeriesCapacitor series(members);
+
+        double parallel_xc = kernels->parallel_xc(xc.data(), n);
+        double series_xc = kernels->series_xc(xc.data(), n);
+        if (kernels->isa == KernelIsa::Scalar)
+        {
+            // One lane adds in the order of std::accumulate.
+            ASSERT_EQ(parallel_xc, parallel.xc(50));
+            ASSERT_EQ(series_xc, series.xc(50));
+        }
+        else
+        {
+            ASSERT_NEAR(parallel_xc, parallel.xc(50), 1e-14 * n * parallel.xc(50));
+            ASSERT_NEAR(series_xc, series.xc(50), 1e-14 * n * series.xc(50));
+        }
+    }
+}
+
+TEST_P(CapacitorKernelsTest, ExceedsMatchesComparison) {
+    for (size_t n : sizes)
+    {
+        std::vector<double> value = random(n, 0, 2);
+        std::vector<double> limit = random(n, 0, 2);
+        if (n > 2)
+        {
+            limit[1] = value[1];
+        }
+        std::vector<uint8_t> exceeded(n, 7);
+
+        size_t expected = 0;
+        size_t count = kernels->exceeds(value.data(), limit.data(), exceeded.data(), n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            ASSERT_EQ(exceeded[k], value[k] > limit[k] ? 1 : 0);
+            expected += value[k] > limit[k];
+        }
+        ASSERT_EQ(count, expected);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Isa, CapacitorKernelsTest,
+    ::testing::Values(KernelIsa::Scalar, KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512),
+    [](const ::testing::TestParamInfo<KernelIsa> &info) { return std::string(kernel_isa_name(info.param)); });
+
+TEST(CapacitorKernelsDispatchTest, SelectsSupportedKernels) {
+    const CapacitorKernels &selected = capacitor_kernels();
+    ASSERT_EQ(capacitor_kernels(selected.isa), &selected);
+    ASSERT_NE(capacitor_kernels(KernelIsa::Scalar), nullptr);
+}
+
+} // namespace
@@ -0,0 +1,167 @@
+#include <vector>
+#include <string>
+#include <thread>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_monitor.h"
+
+#include "gtest/gtest.h"
+#include "tank_test_fixture.h"
+namespace {
+
+class MonitorTest : public ReferenceTankTest {
+protected:
+    // c3 is the last part, before parallel2 and serial.
+    uint32_t c3_node = 3;
+
+    // The current that puts exactly its voltage limit on c3 at 10 kHz.
+    double c3_limit_current()
+    {
+        CompiledTankEvaluator evaluator(tank);
+        evaluator.voltage(10000, 1.0);
+        return 1000 / evaluator.node_voltage()[c3_node];
+    }
+};
+
+TEST_F(MonitorTest, EventsMatchEvaluator) {
+    MonitorOptions options;
+    options.debounce = 1;
+    TankMonitor monitor(tank, options);
+    size_t events = monitor.update({30, 1000});
+
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(1000, 30);
+    ViolationReport report(3 * tank.size());
+    evaluator.check_limits(report);
+    ASSERT_EQ(events, report.size());
+    ASSERT_EQ(static_cast<size_t>(monitor.end() - monitor.begin()), events);
+    for (size_t k = 0; k < report.size(); ++k)
+    {
+        const MonitorEvent &event = monitor.begin()[k];
+        ASSERT_TRUE(event.raised);
+        ASSERT_EQ(event.update, 0u);
+        ASSERT_EQ(event.violation.node, report[k].node);
+        ASSERT_EQ(event.violation.kind, report[k].kind);
+        ASSERT_NEAR(event.violation.value, report[k].value, 1e-12 * report[k].value);
+        ASSERT_EQ(event.violation.limit, report[k].limit);
+    }
+}
+
+TEST_F(MonitorTest, DebounceAndHysteresis) {
+    MonitorOptions options;
+    options.debounce = 3;
+    options.hysteresis = 0.1;
+    TankMonitor monitor(tank, options);
+    float limit = static_cast<float>(c3_limit_current());
+
+    // Two updates over the limit and one under do not raise it.
+    ASSERT_EQ(monitor.update({limit * 1.01f, 10000}), 0u);
+    ASSERT_EQ(monitor.update({limit * 1.01f, 10000}), 0u);
+    ASSERT_EQ(monitor.update({limit * 0.99f, 10000}), 0u);
+    ASSERT_EQ(monitor.update({limit * 1.01f, 10000}), 0u);
+    ASSERT_EQ(monitor.update({limit * 1.01f, 10000}), 0u);
+    ASSERT_FALSE(monitor.raised(c3_node, ViolationKind::Overvoltage));
+
+    // The third in a row does.
+    monitor.update({limit * 1.01f, 10000});
+    ASSERT_TRUE(monitor.raised(c3_node, ViolationKind::Overvoltage));
+    bool raised = false;
+    for (const MonitorEvent &event : monitor)
+    {
+        raised |= event.raised && event.violation.node == c3_node && event.violation.kind == ViolationKind::Overvoltage;
+        ASSERT_EQ(event.update, 5u);
+    }
+    ASSERT_TRUE(raised);
+
+    // Within the hysteresis band it stays raised, below it clears after three updates.
+    for (int k = 0; k < 5; ++k)
+    {
+        ASSERT_EQ(monitor.update({limit * 0.95f, 10000}), 0u);
+    }
+    ASSERT_TRUE(monitor.raised(c3_node, ViolationKind::Overvoltage));
+    monitor.update({limit * 0.85f, 10000});
+    monitor.update({limit * 0.85f, 10000});
+    ASSERT_TRUE(monitor.raised(c3_node, ViolationKind::Overvoltage));
+    ASSERT_GT(monitor.update({limit * 0.85f, 10000}), 0u);
+    ASSERT_FALSE(monitor.raised(c3_node, ViolationKind::Overvoltage));
+    ASSERT_FALSE(monitor.begin()->raised);
+}
+
+TEST_F(MonitorTest, SkipsInvalidUpdates) {
+    TankMonitor monitor(tank, MonitorOptions());
+    ASSERT_EQ(monitor.update({30, 0}), 0u);
+    ASSERT_EQ(monitor.update({30, -1}), 0u);
+    ASSERT_EQ(monitor.updates(), 0u);
+    ASSERT_EQ(monitor.invalid_updates(), 2u);
+    ASSERT_THROW(TankMonitor(tank, MonitorOptions{1.0, 3}), std::invalid_argument);
+}
+
+TEST_F(MonitorTest, PipeFeed) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    // Over the limits, then back within them; written with odd sizes so records are split across reads.
+    std::vector<TelemetrySample> samples(1000, TelemetrySample{30, 1000});
+    samples.insert(samples.end(), 1000, TelemetrySample{1, 10000});
+    std::thread producer([&]() {
+        const char *bytes = reinterpret_cast<const char *>(samples.data());
+        size_t size = samples.size() * sizeof(TelemetrySample);
+        for (size_t offset = 0; offset < size; offset += 13)
+        {
+            ASSERT_GT(::write(fds[1], bytes + offset, std::min<size_t>(13, size - offset)), 0);
+        }
+        ::close(fds[1]);
+    });
+
+    TankMonitor monitor(tank, MonitorOptions());
+    size_t raised = 0, cleared = 0;
+    MonitorStats stats = run_monitor(monitor, fds[0], [&](const MonitorEvent &event) {
+        (event.raised ? raised : cleared) += 1;
+        ASSERT_EQ(event.update, event.raised ? 2u : 1002u);
+    });
+    producer.join();
+    ::close(fds[0]);
+
+    ASSERT_EQ(stats.updates, samples.size());
+    ASSERT_EQ(stats.latency.count(), samples.size());
+    ASSERT_GT(raised, 0u);
+    ASSERT_EQ(raised, cleared);
+    ASSERT_EQ(stats.events, raised + cleared);
+}
+
+TEST_F(MonitorTest, SharedMemoryRing) {
+    std::string name = "/calculate-tank-caps-test-" + std::to_string(::getpid());
+    TelemetryRing ring(name, 64);
+    ASSERT_THROW(TelemetryRing(name, 48), std::invalid_argument);
+
+    // A producer far faster than the ring is drained, so it has to wait for free slots.
+    constexpr size_t count = 100000;
+    std::thread producer([&]() {
+        TelemetryRing feed(name);
+        for (size_t k = 0; k < count; ++k)
+        {
+            TelemetrySample sample = (k / 1000) % 2 == 0 ? TelemetrySample{30, 1000} : TelemetrySample{1, 10000};
+            while (!feed.push(sample))
+            {
+                std::this_thread::yield();
+            }
+        }
+        feed.close();
+    });
+
+    TankMonitor monitor(tank, MonitorOptions());
+    size_t raised = 0, cleared = 0;
+    MonitorStats stats = run_monitor(monitor, ring, [&](const MonitorEvent &event) { (event.raised ? raised : cleared) += 1; });
+    producer.join();
+
+    ASSERT_EQ(stats.updates, count);
+    ASSERT_GT(raised, 0u);
+    // 50 periods over and within the limits.
+    ASSERT_EQ(raised % 50, 0u);
+    ASSERT_EQ(raised, cleared);
+}
+
+}
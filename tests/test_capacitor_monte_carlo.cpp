@@ -0,0 +1,116 @@
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_monte_carlo.h"
+
+#include "gtest/gtest.h"
+#include "tank_test_fixture.h"
+namespace {
+
+class MonteCarloTest : public ReferenceTankTest {};
+
+TEST(PhiloxTest, KnownAnswer) {
+    std::array<uint32_t, 4> zero = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+    ASSERT_EQ(philox4x32({0, 0, 0, 0}, {0, 0}), zero);
+}
+
+TEST_F(MonteCarloTest, NominalTankMatchesEvaluator) {
+    MonteCarloOptions options;
+    options.current = 30;
+    options.frequency = 1000;
+    options.samples = 100;
+    options.capacitance.spread = 0;
+    MonteCarloResult result = run_monte_carlo(tank, options);
+
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(options.frequency, options.current);
+    ViolationReport report;
+    evaluator.check_limits(report);
+
+    ASSERT_EQ(result.samples, 100u);
+    ASSERT_EQ(result.nodes.size(), tank.size());
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        const NodeStatistics &node = result.nodes[n];
+        ASSERT_EQ(node.name, tank.names()[n]);
+        ASSERT_EQ(node.current_max, evaluator.node_current()[n]);
+        ASSERT_NEAR(node.current_p50, node.nominal_current, 0.003 * node.nominal_current);
+        ASSERT_NEAR(node.current_p99, node.nominal_current, 0.003 * node.nominal_current);
+
+        bool violated = false;
+        for (const Violation &violation : report)
+        {
+            if (violation.node == n)
+            {
+                violated = true;
+                double probability = violation.kind == ViolationKind::Overcurrent ? node.overcurrent_probability
+                                   : violation.kind == ViolationKind::Overvoltage ? node.overvoltage_probability
+                                                                                  : node.overpower_probability;
+                ASSERT_EQ(probability, 1.0);
+            }
+        }
+        ASSERT_EQ(node.violation_probability, violated ? 1.0 : 0.0);
+    }
+    ASSERT_EQ(result.violation_probability, report.empty() ? 0.0 : 1.0);
+}
+
+TEST_F(MonteCarloTest, IndependentOfThreadCount) {
+    MonteCarloOptions options;
+    options.current = 30;
+    options.frequency = 1000;
+    options.samples = 10007;
+    options.capacitance = {ToleranceDistribution::Uniform, 0.1};
+    options.limits = {ToleranceDistribution::Normal, 0.05};
+
+    options.threads = 1;
+    MonteCarloResult single = run_monte_carlo(tank, options);
+    options.threads = 4;
+    MonteCarloResult parallel = run_monte_carlo(tank, options);
+
+    ASSERT_EQ(single.violation_probability, parallel.violation_probability);
+    for (size_t n = 0; n < tank.size(); ++n)
+    {
+        ASSERT_EQ(single.nodes[n].current_p50, parallel.nodes[n].current_p50);
+        ASSERT_EQ(single.nodes[n].current_p95, parallel.nodes[n].current_p95);
+        ASSERT_EQ(single.nodes[n].current_p99, parallel.nodes[n].current_p99);
+        ASSERT_EQ(single.nodes[n].current_max, parallel.nodes[n].current_max);
+        ASSERT_EQ(single.nodes[n].overcurrent_probability, parallel.nodes[n].overcurrent_probability);
+        ASSERT_EQ(single.nodes[n].overvoltage_probability, parallel.nodes[n].overvoltage_probability);
+        ASSERT_EQ(single.nodes[n].overpower_probability, parallel.nodes[n].overpower_probability);
+        ASSERT_EQ(single.nodes[n].violation_probability, parallel.nodes[n].violation_probability);
+    }
+
+    options.seed = 2;
+    MonteCarloResult other_seed = run_monte_carlo(tank, options);
+    ASSERT_NE(single.nodes[0].current_max, other_seed.nodes[0].current_max);
+}
+
+TEST(MonteCarloSplitTest, ParallelCurrentSplit) {
+    // Two equal parts share the current; each is rated for exactly its nominal half.
+    Capacitor a(10, 1000, 50, 1e9, "a");
+    Capacitor b(10, 1000, 50, 1e9, "b");
+    ParallelCapacitor bank({&a, &b}, "bank");
+    CompiledTank tank(bank);
+
+    MonteCarloOptions options;
+    options.current = 100;
+    options.frequency = 50;
+    options.samples = 20000;
+    options.capacitance = {ToleranceDistribution::Uniform, 0.1};
+    MonteCarloResult result = run_monte_carlo(tank, options);
+
+    // The share of a part is C_a / (C_a + C_b), between 0.9 / 2 and 1.1 / 2 of the current.
+    const NodeStatistics &part = result.nodes[0];
+    ASSERT_EQ(part.nominal_current, 50);
+    ASSERT_LE(part.current_max, 55);
+    ASSERT_GT(part.current_p99, 53);
+    ASSERT_NEAR(part.current_p50, 50, 0.5);
+    ASSERT_NEAR(part.overcurrent_probability, 0.5, 0.02);
+    ASSERT_EQ(result.nodes[2].overcurrent_probability, 0.0);
+    ASSERT_NEAR(result.violation_probability, 1.0, 0.001);
+}
+
+} // namespace
@@ -0,0 +1,155 @@
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+
+#include "capacitors.h"
+#include "capacitor_tank.h"
+#include "capacitor_compiled.h"
+#include "capacitor_netlist.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+class TankNetlistTest : public ::testing::Test {
+protected:
+    std::vector<CapacitorSpecification> capacitor_spec = {
+        {23e-6f, 900, "23uF_500V", 500000, 500},
+        {1e-6f, 500, "1uF_1000V", 500000, 1000}
+    };
+    std::vector<std::string> group1 = {"23uF_500V", "1uF_1000V"};
+    std::vector<std::string> group2 = {"1uF_1000V"};
+
+    // Node results of the netlist, compiled, at a point of the reference example.
+    TankResultTable evaluate(const TankNetlist &netlist)
+    {
+        CompiledTank tank(netlist.root());
+        CompiledTankEvaluator evaluator(tank);
+        evaluator.current(10000, 100000);
+
+        TankResultTable table;
+        table.names = tank.names();
+        for (size_t n = 0; n < tank.size(); ++n)
+        {
+            table.add(static_cast<uint32_t>(n), evaluator.node_current()[n], evaluator.node_voltage()[n]);
+        }
+        return table;
+    }
+
+    void expect_error(const std::string &text, const std::string &message)
+    {
+        try
+        {
+            parse_netlist_text(text, capacitor_spec);
+            FAIL() << "No error for " << text;
+        }
+        catch (const std::invalid_argument &err)
+        {
+            EXPECT_EQ(std::string(err.what()), message);
+        }
+    }
+};
+
+void expect_same_results(const TankResultTable &expected, const TankResultTable &actual)
+{
+    ASSERT_EQ(expected.names, actual.names);
+    ASSERT_EQ(expected.rows.size(), actual.rows.size());
+    for (size_t k = 0; k < expected.rows.size(); ++k)
+    {
+        EXPECT_EQ(expected.rows[k].current, actual.rows[k].current);
+        EXPECT_EQ(expected.rows[k].voltage, actual.rows[k].voltage);
+    }
+}
+
+TEST_F(TankNetlistTest, TextMatchesTwoGroupTank) {
+    TankCalculator tank_calculator(capacitor_spec);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    TankResultTable expected = tank_calculator.make_result_table();
+    tank_calculator.calculate_capacitors_tank(10000, 100000, expected);
+
+    TankNetlist netlist = parse_netlist_text(
+        "# the README example\n"
+        "series[serial](\n"
+        "    parallel[parallel1](23uF_500V, 1uF_1000V),\n"
+        "    parallel [parallel2] ( 1uF_1000V )\n"
+        ")\n",
+        capacitor_spec);
+    expect_same_results(expected, evaluate(netlist));
+    ASSERT_EQ(netlist.objects(), 5u);
+}
+
+TEST_F(TankNetlistTest, JsonMatchesText) {
+    TankNetlist text = parse_netlist_text(
+        "series(parallel[bank](23uF_500V*3, series(1uF_1000V*2)*2), 1uF_1000V)", capacitor_spec);
+    TankNetlist json_netlist = parse_netlist_json(json::parse(R"({
+        "series": [
+            {"parallel": ["23uF_500V", "23uF_500V", "23uF_500V", {"series": [{"part": "1uF_1000V", "count": 2}], "count": 2}], "name": "bank"},
+            "1uF_1000V"
+        ]})"), capacitor_spec);
+    expect_same_results(evaluate(text), evaluate(json_netlist));
+}
+
+TEST_F(TankNetlistTest, RepeatedParts) {
+    TankNetlist netlist = parse_netlist_text("series(parallel(1uF_1000V*200)*30)", capacitor_spec);
+
+    // One object per part and group, listed many times.
+    ASSERT_EQ(netlist.objects(), 3u);
+    ASSERT_EQ(netlist.root().capacitors().size(), 30u);
+    double part_uF = capacitor_spec[1].capacitance * 1e6;
+    ASSERT_NEAR(netlist.root().spec().get_cap_uF(), 200 * part_uF / 30, 1e-12);
+    ASSERT_EQ(netlist.root().spec().get_v_max(), 30 * 1000.0);
+    ASSERT_EQ(CompiledTank(netlist.root()).size(), 1u + 30 * 201);
+}
+
+TEST_F(TankNetlistTest, DeepTree) {
+    // 10^5 nested single-member groups around one part.
+    const size_t depth = 100000;
+    std::string text;
+    for (size_t k = 0; k < depth; ++k)
+    {
+        text += k % 2 ? "parallel(" : "series(";
+    }
+    text += "23uF_500V";
+    text += std::string(depth, ')');
+
+    TankNetlist netlist = parse_netlist_text(text, capacitor_spec);
+    CompiledTank tank(netlist.root());
+    ASSERT_EQ(tank.size(), depth + 1);
+
+    CompiledTankEvaluator evaluator(tank);
+    Capacitor part(capacitor_spec[0].capacitance * 1e6, 500, 900, 500e3);
+    EXPECT_NEAR(evaluator.current(10000, 100), part.current(10000, 100), 1e-9);
+    EXPECT_NEAR(evaluator.allowed_current(), part.allowed_current(10000), 1e-9);
+
+    json deep = "23uF_500V";
+    for (size_t k = 0; k < 1000; ++k)
+    {
+        deep = json{{"series", json::array({std::move(deep)})}};
+    }
+    ASSERT_EQ(CompiledTank(parse_netlist_json(deep, capacitor_spec).root()).size(), 1001u);
+}
+
+TEST_F(TankNetlistTest, Errors) {
+    expect_error("series(23uF_500V, 2uF)", "Netlist error at offset 18: capacitor 2uF not found in the specification file");
+    expect_error("series(23uF_500V", "Netlist error at offset 16: expected ',' or ')'");
+    expect_error("series()", "Netlist error at offset 7: empty group");
+    expect_error("23uF_500V)", "Netlist error at offset 9: expected end of netlist");
+    expect_error("parallel(23uF_500V*0)", "Netlist error at offset 19: repetition count must be 1 to 1000000");
+    expect_error("23uF_500V*2", "Netlist error: the root must be a single node");
+    expect_error("series[a(23uF_500V)", "Netlist error at offset 8: expected ']'");
+    // Repeats multiply through the levels: the limit is on the expanded tree, not on each count.
+    expect_error("parallel(parallel(1uF_1000V*1000000)*1000000)",
+                 "Netlist error at offset 36: the tank expands to more than 4000000 nodes");
+    expect_error("series(parallel(1uF_1000V*1000000)*3, parallel(23uF_500V*1000000))",
+                 "Netlist error at offset 65: the tank expands to more than 4000000 nodes");
+    ASSERT_EQ(CompiledTank(parse_netlist_text("series(parallel(1uF_1000V*1000000)*3)", capacitor_spec).root()).size(),
+              3000004u);
+    EXPECT_THROW(parse_netlist_json(json::parse(R"({"parallel": [{"parallel": [{"part": "1uF_1000V", "count": 1000000}], "count": 1000000}]})"), capacitor_spec),
+                 std::invalid_argument);
+
+    EXPECT_THROW(parse_netlist_json(json::parse(R"({"parallel": []})"), capacitor_spec), std::invalid_argument);
+    EXPECT_THROW(parse_netlist_json(json::parse(R"({"series": ["missing"]})"), capacitor_spec), std::invalid_argument);
+    EXPECT_THROW(parse_netlist_json(json::parse("42"), capacitor_spec), std::invalid_argument);
+}
+
+} // namespace
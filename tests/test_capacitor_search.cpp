@@ -0,0 +1,160 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+
+#include "capacitors.h"
+#include "capacitor_tank.h"
+#include "capacitor_search.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+std::vector<CapacitorSpecification> random_catalog(size_t size, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> cap(0.5f, 30.0f);
+    std::uniform_real_distribution<float> volt(200.0f, 1200.0f);
+    std::uniform_real_distribution<float> amp(100.0f, 1000.0f);
+    std::uniform_real_distribution<float> power(1e5f, 1e6f);
+
+    std::vector<CapacitorSpecification> catalog;
+    for (size_t k = 0; k < size; ++k)
+    {
+        catalog.push_back({cap(rng) * 1e-6f, amp(rng), "part" + std::to_string(k), power(rng), volt(rng)});
+    }
+    return catalog;
+}
+
+std::vector<Capacitor> to_capacitors(const std::vector<CapacitorSpecification> &catalog, const std::vector<std::string> &names)
+{
+    std::vector<Capacitor> caps;
+    for (auto &name : names)
+    {
+        auto spec = std::find_if(catalog.begin(), catalog.end(), [&](const CapacitorSpecification &s) { return s.name == name; });
+        caps.emplace_back(spec->capacitance * 1e6, spec->voltage, spec->current, spec->power, spec->name);
+    }
+    return caps;
+}
+
+double group_rated(const std::vector<CapacitorSpecification> &catalog, const std::vector<std::string> &names, double f)
+{
+    std::vector<Capacitor> caps = to_capacitors(catalog, names);
+    std::vector<CapacitorInterface *> group;
+    for (auto &cap : caps)
+    {
+        group.push_back(&cap);
+    }
+    return parallel_group_rated_current(ParallelCapacitor(group).spec(), f);
+}
+
+// Every multiset of up to max_size parts, without pruning.
+void all_groups(const std::vector<CapacitorSpecification> &catalog, size_t max_size, size_t from,
+                std::vector<std::string> &group, std::vector<std::vector<std::string>> &out)
+{
+    for (size_t k = from; k < catalog.size(); ++k)
+    {
+        group.push_back(catalog[k].name);
+        out.push_back(group);
+        if (group.size() < max_size)
+        {
+            all_groups(catalog, max_size, k, group, out);
+        }
+        group.pop_back();
+    }
+}
+
+TEST(DesignSearchTest, GroupRatedCurrentLimits) {
+    Capacitor cap1(10, 800, 500, 500e3);
+    Capacitor cap2(10, 1000, 600, 500e3);
+    ParallelCapacitor parallel({&cap1, &cap2});
+
+    // Voltage limited at low frequency, like ParallelCapacitor::allowed_current.
+    ASSERT_NEAR(parallel_group_rated_current(parallel.spec(), 1), parallel.allowed_current(1), 1e-9);
+    // Current limited at high frequency.
+    ASSERT_DOUBLE_EQ(parallel_group_rated_current(parallel.spec(), 1e6), 1100);
+}
+
+TEST(DesignSearchTest, MatchesExhaustiveEnumeration) {
+    std::vector<CapacitorSpecification> catalog = random_catalog(9, 7);
+    double f = 50;
+
+    DesignSearchOptions options;
+    options.current = 150;
+    options.frequency = f;
+    options.max_group_size = 4;
+    options.top = 12;
+    options.threads = 3;
+    DesignSearchResult result = search_tank_designs(catalog, options);
+
+    std::vector<std::vector<std::string>> groups;
+    std::vector<std::string> group;
+    all_groups(catalog, 4, 0, group, groups);
+
+    std::vector<double> rated;
+    for (auto &g : groups)
+    {
+        double a = group_rated(catalog, g, f);
+        if (a >= options.current)
+        {
+            rated.push_back(a);
+        }
+    }
+    std::sort(rated.rbegin(), rated.rend());
+
+    // The k-th design is limited by the j-th best group, with designs (i, j), i <= j, listed by j.
+    std::vector<double> expected;
+    for (size_t j = 0; j < rated.size() && expected.size() < options.top; ++j)
+    {
+        for (size_t i = 0; i <= j && expected.size() < options.top; ++i)
+        {
+            expected.push_back(rated[j]);
+        }
+    }
+
+    ASSERT_EQ(result.designs.size(), expected.size());
+    for (size_t k = 0; k < expected.size(); ++k)
+    {
+        const TankDesign &design = result.designs[k];
+        ASSERT_GE(design.group1.size(), 1u);
+        ASSERT_LE(design.group1.size(), 4u);
+        ASSERT_DOUBLE_EQ(design.rated_current, expected[k]);
+        ASSERT_DOUBLE_EQ(design.margin, expected[k] - options.current);
+        ASSERT_DOUBLE_EQ(std::min(group_rated(catalog, design.group1, f), group_rated(catalog, design.group2, f)),
+                         design.rated_current);
+    }
+    ASSERT_LT(result.evaluated_groups, groups.size());
+}
+
+TEST(DesignSearchTest, IndependentOfThreadCount) {
+    std::vector<CapacitorSpecification> catalog = random_catalog(25, 11);
+
+    DesignSearchOptions options;
+    options.current = 300;
+    options.frequency = 5000;
+    options.top = 20;
+    options.threads = 1;
+    DesignSearchResult single = search_tank_designs(catalog, options);
+    options.threads = 4;
+    DesignSearchResult multi = search_tank_designs(catalog, options);
+
+    ASSERT_EQ(single.designs.size(), 20u);
+    ASSERT_EQ(single.designs.size(), multi.designs.size());
+    for (size_t k = 0; k < single.designs.size(); ++k)
+    {
+        ASSERT_EQ(single.designs[k].group1, multi.designs[k].group1);
+        ASSERT_EQ(single.designs[k].group2, multi.designs[k].group2);
+        ASSERT_EQ(single.designs[k].rated_current, multi.designs[k].rated_current);
+    }
+}
+
+TEST(DesignSearchTest, NoDesignCarriesCurrent) {
+    std::vector<CapacitorSpecification> catalog = random_catalog(5, 3);
+
+    DesignSearchOptions options;
+    options.current = 1e9;
+    options.frequency = 50;
+    ASSERT_TRUE(search_tank_designs(catalog, options).designs.empty());
+}
+
+} // namespace
@@ -0,0 +1,115 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <deque>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_sensitivity.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+// Two banks in series, 20 parts in all, so the parameters take two dual evaluations.
+class SensitivityTest : public ::testing::Test {
+protected:
+    std::deque<Capacitor> parts;
+    std::vector<CapacitorInterface *> bank1_parts;
+    std::vector<CapacitorInterface *> bank2_parts;
+    std::unique_ptr<ParallelCapacitor> bank1;
+    std::unique_ptr<ParallelCapacitor> bank2;
+    std::unique_ptr<SeriesCapacitor> serial;
+    std::unique_ptr<CompiledTank> tank;
+
+    void SetUp() override
+    {
+        for (int k = 0; k < 20; ++k)
+        {
+            parts.emplace_back(1 + 1.7 * k, 400 + 50 * k, 10 + k, 1e4, "part" + std::to_string(k));
+            (k < 12 ? bank1_parts : bank2_parts).push_back(&parts.back());
+        }
+        bank1 = std::make_unique<ParallelCapacitor>(bank1_parts, "bank1");
+        bank2 = std::make_unique<ParallelCapacitor>(bank2_parts, "bank2");
+        serial = std::make_unique<SeriesCapacitor>(std::vector<CapacitorInterface *>{bank1.get(), bank2.get()}, "serial");
+        tank = std::make_unique<CompiledTank>(*serial);
+    }
+
+    // Every row of the Jacobian, from a double evaluation.
+    std::vector<double> evaluate(CompiledTankEvaluator &evaluator, double frequency, double current)
+    {
+        evaluator.voltage(frequency, current);
+        std::vector<double> rows;
+        for (uint32_t n = 0; n < tank->size(); ++n)
+        {
+            rows.push_back(evaluator.node_current()[n]);
+            rows.push_back(evaluator.node_voltage()[n]);
+            rows.push_back(evaluator.node_power(n));
+        }
+        rows.push_back(evaluator.allowed_current());
+        return rows;
+    }
+};
+
+TEST_F(SensitivityTest, MatchesCentralDifferences) {
+    SensitivityOptions options;
+    options.current = 30;
+    options.frequency = 1000;
+    SensitivityResult result = run_sensitivity(*tank, options);
+
+    ASSERT_EQ(result.parts.size(), 20u);
+    ASSERT_EQ(result.columns, 21u);
+    ASSERT_EQ(result.rows, 3 * tank->size() + 1);
+    ASSERT_EQ(result.jacobian.size(), result.rows * result.columns);
+
+    CompiledTankEvaluator evaluator(*tank);
+    ASSERT_EQ(result.values, evaluate(evaluator, options.frequency, options.current));
+
+    for (size_t column = 0; column < result.columns; ++column)
+    {
+        std::vector<double> plus, minus;
+        double step;
+        if (column == result.frequency_column())
+        {
+            step = options.frequency * 1e-6;
+            plus = evaluate(evaluator, options.frequency + step, options.current);
+            minus = evaluate(evaluator, options.frequency - step, options.current);
+        }
+        else
+        {
+            uint32_t part = result.parts[column];
+            double cap_uF = tank->cap_F()[part] * 1e6;
+            step = cap_uF * 1e-6;
+            evaluator.set_cap_F(part, (cap_uF + step) * 1e-6);
+            plus = evaluate(evaluator, options.frequency, options.current);
+            evaluator.set_cap_F(part, (cap_uF - step) * 1e-6);
+            minus = evaluate(evaluator, options.frequency, options.current);
+            evaluator.set_cap_F(part, tank->cap_F()[part]);
+        }
+
+        for (size_t row = 0; row < result.rows; ++row)
+        {
+            double difference = (plus[row] - minus[row]) / (2 * step);
+            double scale = std::fabs(result.values[row]) / (column == result.frequency_column() ? options.frequency : 1.0);
+            EXPECT_NEAR(result.at(row, column), difference, 1e-5 * scale + 1e-9) << "row " << row << " column " << column;
+        }
+    }
+}
+
+TEST_F(SensitivityTest, SeriesCurrentDoesNotDependOnParts) {
+    SensitivityOptions options;
+    options.current = 30;
+    options.frequency = 1000;
+    SensitivityResult result = run_sensitivity(*tank, options);
+
+    // The drive current flows through both banks whatever their parts.
+    uint32_t root = tank->root();
+    for (size_t column = 0; column < result.columns; ++column)
+    {
+        ASSERT_EQ(result.at(result.current_row(root), column), 0.0);
+    }
+    // A larger capacitance lowers the voltage of its bank.
+    ASSERT_LT(result.at(result.voltage_row(root), 0), 0.0);
+    ASSERT_LT(result.at(result.voltage_row(root), result.frequency_column()), 0.0);
+}
+
+} // namespace
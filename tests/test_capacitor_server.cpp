@@ -0,0 +1,244 @@
+#include <vector>
+#include <string>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "capacitor_tank.h"
+#include "capacitor_server.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+template <typename T>
+T field(const std::vector<uint8_t> &payload, size_t offset)
+{
+    T value;
+    std::memcpy(&value, payload.data() + offset, sizeof(T));
+    return value;
+}
+
+class TankServerTest : public ::testing::Test {
+protected:
+    std::vector<CapacitorSpecification> capacitor_spec = {
+        {23e-6f, 900, "23uF_500V", 500000, 500},
+        {1e-6f, 500, "1uF_1000V", 500000, 1000}
+    };
+    std::vector<std::string> group1 = {"23uF_500V", "1uF_1000V"};
+    std::vector<std::string> group2 = {"1uF_1000V"};
+
+    TankServer server{capacitor_spec};
+    std::vector<uint8_t> response;
+
+    void request(const std::vector<uint8_t> &payload)
+    {
+        server.handle(payload.data(), payload.size(), response);
+    }
+
+    std::string error() const
+    {
+        return std::string(response.begin() + 1, response.end());
+    }
+};
+
+TEST_F(TankServerTest, ComposeIsCachedBySignature) {
+    request(encode_compose_request(group1, group2));
+    ASSERT_EQ(response.size(), 5u);
+    ASSERT_EQ(response[0], uint8_t(ServerStatus::Ok));
+    uint32_t tank = field<uint32_t>(response, 1);
+
+    request(encode_compose_request(group1, group2));
+    ASSERT_EQ(field<uint32_t>(response, 1), tank);
+
+    request(encode_compose_request(group2, group1));
+    ASSERT_NE(field<uint32_t>(response, 1), tank);
+    ASSERT_EQ(server.cached_tanks(), 2u);
+}
+
+TEST_F(TankServerTest, EvaluateMatchesTankCalculator) {
+    request(encode_compose_request(group1, group2));
+    uint32_t tank = field<uint32_t>(response, 1);
+
+    TankCalculator tank_calculator(capacitor_spec);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    ViolationReport report;
+    double tank_current = tank_calculator.check_capacitors_tank(10000, 100000, report);
+    double allowed_current = tank_calculator.calculate_allowed_current(10000);
+
+    request(encode_evaluate_request(tank, 100000, 10000));
+    ASSERT_EQ(response[0], uint8_t(ServerStatus::Ok));
+    ASSERT_EQ(field<double>(response, 1), tank_current);
+    ASSERT_EQ(field<double>(response, 9), allowed_current);
+    ASSERT_EQ(field<uint32_t>(response, 17), report.size());
+
+    const size_t violation_size = sizeof(uint32_t) + 1 + 2 * sizeof(double);
+    ASSERT_EQ(response.size(), 21 + report.size() * violation_size);
+    for (size_t k = 0; k < report.size(); ++k)
+    {
+        size_t offset = 21 + k * violation_size;
+        ASSERT_EQ(field<uint32_t>(response, offset), report[k].node);
+        ASSERT_EQ(response[offset + 4], uint8_t(report[k].kind));
+        ASSERT_EQ(field<double>(response, offset + 5), report[k].value);
+        ASSERT_EQ(field<double>(response, offset + 13), report[k].limit);
+    }
+
+    request(encode_allowed_current_request(tank, 10000));
+    ASSERT_EQ(response.size(), 9u);
+    ASSERT_EQ(field<double>(response, 1), allowed_current);
+}
+
+TEST_F(TankServerTest, RejectsInvalidRequests) {
+    request(encode_compose_request({"missing"}, group2));
+    ASSERT_EQ(response[0], uint8_t(ServerStatus::Error));
+    ASSERT_EQ(error(), "Capacitor missing not found in the specification file.");
+
+    request(encode_compose_request({}, group2));
+    ASSERT_EQ(error(), "Groups need 1 to 5 capacitors.");
+
+    request(encode_evaluate_request(3, 1, 50));
+    ASSERT_EQ(error(), "Unknown tank 3.");
+
+    std::vector<uint8_t> truncated = encode_evaluate_request(0, 1, 50);
+    truncated.pop_back();
+    request(encode_compose_request(group1, group2));
+    request(truncated);
+    ASSERT_EQ(error(), "Malformed evaluate request.");
+
+    request({0x7f});
+    ASSERT_EQ(error(), "Unknown request.");
+    ASSERT_EQ(server.cached_tanks(), 1u);
+}
+
+TEST_F(TankServerTest, FramesOverSocket) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ServerConnection connection(fds[1]);
+
+    // Two requests in one write are answered together.
+    ASSERT_TRUE(write_frame(fds[0], encode_compose_request(group1, group2)));
+    ASSERT_TRUE(write_frame(fds[0], encode_allowed_current_request(0, 50)));
+    ASSERT_TRUE(connection.on_readable(server));
+
+    std::vector<uint8_t> payload;
+    ASSERT_TRUE(read_frame(fds[0], payload));
+    ASSERT_EQ(payload[0], uint8_t(ServerStatus::Ok));
+    ASSERT_TRUE(read_frame(fds[0], payload));
+    ASSERT_EQ(payload.size(), 9u);
+
+    ASSERT_TRUE(write_frame(fds[0], encode_stats_request()));
+    ASSERT_TRUE(connection.on_readable(server));
+    ASSERT_TRUE(read_frame(fds[0], payload));
+    ASSERT_EQ(payload.size(), 1 + 8 + 4 + 5 * 8u);
+    ASSERT_EQ(field<uint64_t>(payload, 1), 2u);
+    ASSERT_EQ(field<uint32_t>(payload, 9), 1u);
+    ASSERT_LE(field<uint64_t>(payload, 13), field<uint64_t>(payload, 37));
+
+    close(fds[0]);
+    ASSERT_FALSE(connection.on_readable(server));
+    close(fds[1]);
+}
+
+TEST_F(TankServerTest, CacheEvictsOldestTanks) {
+    TankServer bounded(capacitor_spec, 2);
+    auto compose = [&](const std::vector<std::string> &g1, const std::vector<std::string> &g2) {
+        std::vector<uint8_t> payload = encode_compose_request(g1, g2);
+        bounded.handle(payload.data(), payload.size(), response);
+        return field<uint32_t>(response, 1);
+    };
+    auto allowed_current = [&](uint32_t tank) {
+        std::vector<uint8_t> payload = encode_allowed_current_request(tank, 50);
+        bounded.handle(payload.data(), payload.size(), response);
+        return response[0];
+    };
+
+    uint32_t first = compose(group1, group2);
+    uint32_t second = compose(group2, group1);
+    uint32_t third = compose(group1, group1);
+    ASSERT_EQ(bounded.cached_tanks(), 2u);
+    ASSERT_EQ(allowed_current(first), uint8_t(ServerStatus::Error));
+    ASSERT_EQ(std::string(response.begin() + 1, response.end()), "Unknown tank 0.");
+    ASSERT_EQ(allowed_current(second), uint8_t(ServerStatus::Ok));
+    ASSERT_EQ(allowed_current(third), uint8_t(ServerStatus::Ok));
+
+    // Composing the evicted groups again gives a new id, evicting the next oldest tank.
+    ASSERT_EQ(compose(group1, group2), 3u);
+    ASSERT_EQ(compose(group1, group1), third);
+    ASSERT_EQ(allowed_current(second), uint8_t(ServerStatus::Error));
+    ASSERT_EQ(bounded.cached_tanks(), 2u);
+
+    TankCalculator tank_calculator(capacitor_spec);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    std::vector<uint8_t> payload = encode_allowed_current_request(3, 50);
+    bounded.handle(payload.data(), payload.size(), response);
+    ASSERT_EQ(field<double>(response, 1), tank_calculator.calculate_allowed_current(50));
+}
+
+TEST_F(TankServerTest, ClosedClientDoesNotRaiseSigpipe) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ServerConnection connection(fds[1]);
+
+    // The client sends a request and goes away before the response is written.
+    ASSERT_TRUE(write_frame(fds[0], encode_stats_request()));
+    close(fds[0]);
+    ASSERT_FALSE(connection.on_readable(server));
+    close(fds[1]);
+}
+
+TEST_F(TankServerTest, UnreadResponsesArePending) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int size = 4096;
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    ServerConnection connection(fds[1]);
+
+    // The client sends requests without reading: the connection keeps what the socket does not take.
+    size_t requests = 0;
+    while (connection.pending_output() == 0)
+    {
+        ASSERT_TRUE(write_frame(fds[0], encode_stats_request()));
+        ASSERT_TRUE(connection.on_readable(server));
+        ++requests;
+    }
+
+    std::vector<uint8_t> payload;
+    for (size_t k = 0; k < requests; ++k)
+    {
+        if (connection.pending_output() > 0)
+        {
+            ASSERT_TRUE(connection.on_writable());
+        }
+        ASSERT_TRUE(read_frame(fds[0], payload));
+        ASSERT_EQ(payload[0], uint8_t(ServerStatus::Ok));
+        ASSERT_EQ(field<uint64_t>(payload, 1), k);
+    }
+    ASSERT_EQ(connection.pending_output(), 0u);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    ASSERT_EQ(histogram.percentile(0.99), 0u);
+
+    for (uint64_t ns = 1; ns <= 1000; ++ns)
+    {
+        histogram.record(ns);
+    }
+    ASSERT_EQ(histogram.count(), 1000u);
+    ASSERT_EQ(histogram.max(), 1000u);
+    ASSERT_EQ(histogram.percentile(0.01), 10u);
+    ASSERT_EQ(histogram.percentile(1.0), 1000u);
+
+    // Buckets are at most 12.5% wide above the linear range.
+    uint64_t p50 = histogram.percentile(0.5);
+    ASSERT_GE(p50, 500u);
+    ASSERT_LE(p50, 500u * 9 / 8);
+    uint64_t p99 = histogram.percentile(0.99);
+    ASSERT_GE(p99, 990u);
+    ASSERT_LE(p99, 1000u);
+}
+
+} // namespace
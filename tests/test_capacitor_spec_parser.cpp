@@ -0,0 +1,126 @@
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "capacitor_tank.h"
+#include "capacitor_spec_parser.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+// Catalog of the given size with names needing escapes and members the loader skips.
+std::string catalog_text(size_t size)
+{
+    std::string text = "[\n";
+    for (size_t k = 0; k < size; ++k)
+    {
+        text += k == 0 ? "" : ",\n";
+        text += "  {\"name\": \"part" + std::to_string(k) + "_\\\"q\\\"\\u00b5F, {x}\", \"vendor\": {\"tags\": [1, true, null, \"]\"]}, " +
+                "\"capacitance\": " + std::to_string(k + 1) + "e-6, \"voltage\": " + std::to_string(100 + k % 900) +
+                ", \"current\": 5.25e2, \"power\": -0.5}";
+    }
+    return text + "\n]\n";
+}
+
+// The loader throws with the offset of the first error; returns that offset.
+size_t error_offset(const std::string &text, size_t threads = 1)
+{
+    try
+    {
+        parse_capacitor_specifications_text(text, threads);
+    }
+    catch (const std::invalid_argument &err)
+    {
+        std::string message = err.what();
+        size_t at = message.find("offset ");
+        return std::stoul(message.substr(at + 7));
+    }
+    return std::string::npos;
+}
+
+TEST(SpecParserTest, MatchesDocumentParser) {
+    std::string text = catalog_text(50);
+    nlohmann::json json_data = nlohmann::json::parse(text);
+    std::vector<CapacitorSpecification> expected = parse_capacitor_specifications(json_data);
+    std::vector<CapacitorSpecification> specs = parse_capacitor_specifications_text(text);
+
+    ASSERT_EQ(specs.size(), expected.size());
+    for (size_t k = 0; k < specs.size(); ++k)
+    {
+        ASSERT_EQ(specs[k].name, expected[k].name);
+        ASSERT_EQ(specs[k].capacitance, expected[k].capacitance);
+        ASSERT_EQ(specs[k].voltage, expected[k].voltage);
+        ASSERT_EQ(specs[k].current, expected[k].current);
+        ASSERT_EQ(specs[k].power, expected[k].power);
+    }
+    ASSERT_EQ(specs[0].name, "part0_\"q\"\xc2\xb5" "F, {x}");
+    ASSERT_TRUE(parse_capacitor_specifications_text(" [ ] ").empty());
+}
+
+TEST(SpecParserTest, ParallelMatchesSequential) {
+    // Large enough for several chunks.
+    std::string text = catalog_text(20000);
+    std::vector<CapacitorSpecification> sequential = parse_capacitor_specifications_text(text, 1);
+    std::vector<CapacitorSpecification> parallel = parse_capacitor_specifications_text(text, 4);
+    ASSERT_EQ(parallel.size(), 20000u);
+    for (size_t k = 0; k < sequential.size(); ++k)
+    {
+        ASSERT_EQ(parallel[k].name, sequential[k].name);
+        ASSERT_EQ(parallel[k].capacitance, sequential[k].capacitance);
+        ASSERT_EQ(parallel[k].voltage, sequential[k].voltage);
+    }
+
+    // An error deep in the text is found by its chunk, at the same offset.
+    std::string broken = text;
+    size_t at = broken.find("\"current\"", broken.size() / 2 + 1000);
+    broken[at + 11] = 'x';
+    ASSERT_EQ(error_offset(broken), at + 11);
+    ASSERT_EQ(error_offset(broken, 4), at + 11);
+
+    // So is a record error, at the start of the record.
+    std::string missing = text;
+    at = missing.find("\"power\"", missing.size() / 2 + 1000);
+    missing.replace(at, 7, "\"watts\"");
+    size_t record = missing.rfind('{', missing.rfind("\"name\"", at));
+    ASSERT_EQ(error_offset(missing), record);
+    ASSERT_EQ(error_offset(missing, 4), record);
+}
+
+TEST(SpecParserTest, FileMatchesText) {
+    std::string text = catalog_text(100);
+    std::string path = "spec_parser_test.json";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+    std::vector<CapacitorSpecification> specs = parse_capacitor_specifications_json_file(path);
+    std::vector<CapacitorSpecification> expected = parse_capacitor_specifications_text(text);
+    ASSERT_EQ(specs.size(), expected.size());
+    for (size_t k = 0; k < specs.size(); ++k)
+    {
+        ASSERT_EQ(specs[k].name, expected[k].name);
+        ASSERT_EQ(specs[k].power, expected[k].power);
+    }
+    std::remove(path.c_str());
+    ASSERT_THROW(parse_capacitor_specifications_json_file(path), std::runtime_error);
+}
+
+TEST(SpecParserTest, ReportsMalformedRecordsWithOffset) {
+    std::string missing = R"([{"name": "a", "capacitance": 1, "voltage": 1, "current": 1, "power": 1}, {"name": "b", "capacitance": 1}])";
+    ASSERT_EQ(error_offset(missing), missing.find("{\"name\": \"b\""));
+    std::string not_number = R"([{"name": "a", "capacitance": "1uF", "voltage": 1, "current": 1, "power": 1}])";
+    ASSERT_EQ(error_offset(not_number), not_number.find("\"1uF\""));
+    std::string trailing_comma = R"([{"name": "a", "capacitance": 1, "voltage": 1, "current": 1, "power": 1},])";
+    ASSERT_EQ(error_offset(trailing_comma), trailing_comma.size() - 1);
+    ASSERT_EQ(error_offset(R"({"name": "a"})"), 0u);
+    ASSERT_EQ(error_offset("[{\"name\": \"a"), 12u);
+    ASSERT_EQ(error_offset("[] x"), 3u);
+
+    // The document parser no longer returns the records before a malformed one.
+    nlohmann::json json_data = nlohmann::json::parse(missing);
+    ASSERT_THROW(parse_capacitor_specifications(json_data), std::invalid_argument);
+}
+
+}
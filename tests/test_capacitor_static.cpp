@@ -0,0 +1,71 @@
+#include <vector>
+#include <string>
+
+#include "capacitors.h"
+#include "capacitor_static.h"
+
+#include "gtest/gtest.h"
+namespace {
+
+struct Part23uF { static constexpr double cap_uF = 23, v_max = 500, i_max = 1000, power_max = 500e3; };
+struct Part1uF { static constexpr double cap_uF = 1, v_max = 1000, i_max = 500, power_max = 500e3; };
+struct Part3uF { static constexpr double cap_uF = 3.3, v_max = 800, i_max = 600, power_max = 400e3; };
+
+using Bank1 = Parallel<Cap<Part23uF>, Cap<Part1uF>, Cap<Part3uF>>;
+using Bank2 = Parallel<Cap<Part1uF>, Cap<Part1uF>>;
+using Tank = Series<Bank1, Bank2, Cap<Part3uF>>;
+
+// The aggregates are known when compiling.
+static_assert(Bank1::spec.get_cap_uF() == 23 + 1 + 3.3, "parallel capacitance is the sum");
+static_assert(Bank1::spec.get_v_max() == 500, "parallel voltage limit is the smallest");
+static_assert(Bank1::spec.get_i_max() == 2100, "parallel current limit is the sum");
+static_assert(Tank::spec.get_v_max() == 500 + 1000 + 800, "series voltage limit is the sum");
+static_assert(Tank::spec.get_i_max() == 600, "series current limit is the smallest");
+static_assert(Tank::size == 9, "every part and group is a node");
+static_assert(Tank::kind == CapacitorKind::Series, "root kind");
+static_assert(Tank::allowed_current(1000) > 0, "evaluation is constexpr too");
+
+class StaticTankTest : public ::testing::Test {
+protected:
+    Capacitor a{23, 500, 1000, 500e3, "a"};
+    Capacitor b{1, 1000, 500, 500e3, "b"};
+    Capacitor c{3.3, 800, 600, 400e3, "c"};
+    Capacitor d{1, 1000, 500, 500e3, "d"};
+    Capacitor e{1, 1000, 500, 500e3, "e"};
+    Capacitor g{3.3, 800, 600, 400e3, "g"};
+    ParallelCapacitor bank1{{&a, &b, &c}, "bank1"};
+    ParallelCapacitor bank2{{&d, &e}, "bank2"};
+    SeriesCapacitor tank{{&bank1, &bank2, &g}, "tank"};
+};
+
+void expect_same_spec(const CapacitorSpec &expected, const CapacitorSpec &actual)
+{
+    EXPECT_EQ(expected.get_cap_uF(), actual.get_cap_uF());
+    EXPECT_EQ(expected.get_cap_F(), actual.get_cap_F());
+    EXPECT_EQ(expected.get_v_max(), actual.get_v_max());
+    EXPECT_EQ(expected.get_i_max(), actual.get_i_max());
+    EXPECT_EQ(expected.get_power_max(), actual.get_power_max());
+}
+
+TEST_F(StaticTankTest, SpecsMatchRuntimeClasses) {
+    expect_same_spec(a.spec(), Cap<Part23uF>::spec);
+    expect_same_spec(bank1.spec(), Bank1::spec);
+    expect_same_spec(bank2.spec(), Bank2::spec);
+    expect_same_spec(tank.spec(), Tank::spec);
+}
+
+TEST_F(StaticTankTest, EvaluationMatchesRuntimeClasses) {
+    for (double f : {50.0, 60.0, 1000.0, 12345.6, 1e5})
+    {
+        ASSERT_EQ(tank.xc(f), Tank::xc(f));
+        ASSERT_EQ(tank.current(f, 1000), Tank::current(f, 1000));
+        ASSERT_EQ(tank.voltage(f, 30), Tank::voltage(f, 30));
+        ASSERT_EQ(tank.allowed_current(f), Tank::allowed_current(f));
+        ASSERT_EQ(bank1.xc(f), Bank1::xc(f));
+        ASSERT_EQ(bank1.current(f, 100), Bank1::current(f, 100));
+        ASSERT_EQ(bank1.voltage(f, 30), Bank1::voltage(f, 30));
+        ASSERT_EQ(bank1.allowed_current(f), Bank1::allowed_current(f));
+    }
+}
+
+} // namespace
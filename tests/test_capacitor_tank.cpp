@@ -1,13 +1,55 @@
 #include <vector>
 #include <stdexcept>
 #include <cmath>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
 
 #include "capacitors.h"
 #include "capacitor_tank.h"
 #include "capacitor_violation_check.h"
+#include "capacitor_batch.h"
 
 
 #include "gtest/gtest.h"
+
+// Allocations made on this thread while an AllocationCount is alive, for the tests checking that a path
+// does not allocate. Otherwise the replaced operator new only forwards to malloc.
+static thread_local size_t *allocation_count = nullptr;
+
+void *operator new(size_t size)
+{
+    if (allocation_count)
+    {
+        ++*allocation_count;
+    }
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+struct AllocationCount
+{
+    size_t count = 0;
+
+    AllocationCount() { allocation_count = &count; }
+    ~AllocationCount() { allocation_count = nullptr; }
+};
+
 namespace {
 
 
@@ -203,8 +245,333 @@ TEST(MainFunctionTest, NoSpecFiledddddddddddddddddddddd) {
 
     tank_calculator.compose_capacitors_tank(group1, group2);
     ASSERT_ANY_THROW(tank_calculator.calculate_capacitors_tank(10000000, 1000));
+
+    ViolationReport report;
+    ASSERT_NO_THROW(tank_calculator.check_capacitors_tank(10000000, 1000, report));
+    ASSERT_FALSE(report.empty());
     // auto current = tank_calculator.calculate_capacitors_tank(10000000, 1000);
     // ASSERT_NEAR(current, 0.006283185, 1e-4);
 }
 
+class TankResultTest : public ::testing::Test {
+protected:
+    std::vector<CapacitorSpecification> capacitor_spec = {
+        {1e-6f, 500, "1uF_1000V", 500e3, 1000},
+        {23e-6f, 1000, "23uF_500V", 500e3, 500}};
+    std::vector<std::string> group1 = {"23uF_500V", "1uF_1000V"};
+    std::vector<std::string> group2 = {"1uF_1000V"};
+};
+
+TEST_F(TankResultTest, ConsoleRenderer) {
+    TankCalculator tank_calculator(capacitor_spec);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    ASSERT_THROW(tank_calculator.calculate_capacitors_tank(10000, 100000), std::runtime_error);
+
+    std::ostringstream oss;
+    render_console(oss, tank_calculator.last_results(), &tank_calculator.last_violations());
+    ASSERT_EQ(oss.str(),
+        "Capacitor: 23uF_500V, Current: 5781, Voltage: 4000, Power: 23122121\n"
+        "Capacitor: 1uF_1000V, Current: 251, Voltage: 4000, Power: 1005310\n"
+        "Capacitor: parallel1, Current: 6032, Voltage: 4000, Power: 24127431\n"
+        "Warning: Overcurrent condition on parallel1. The current is 6032A, which exceeds the maximum current of 1500A!\n"
+        "Warning: Overpower condition on parallel1. The power is 24127431W, which exceeds the maximum power of 1000000W!\n"
+        "Capacitor: 1uF_1000V, Current: 6032, Voltage: 96000, Power: 579058358\n"
+        "Capacitor: parallel2, Current: 6032, Voltage: 96000, Power: 579058358\n"
+        "Warning: Overcurrent condition on parallel2. The current is 6032A, which exceeds the maximum current of 500A!\n"
+        "Warning: Overpower condition on parallel2. The power is 579058358W, which exceeds the maximum power of 500000W!\n"
+        "Capacitor: serial, Current: 6032, Voltage: 100000, Power: 603185789\n");
+}
+
+TEST_F(TankResultTest, CompiledTableMatchesDecorators) {
+    TankCalculator tank_calculator(capacitor_spec);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+    tank_calculator.calculate_capacitors_tank(60, 10);
+
+    TankResultTable table = tank_calculator.make_result_table();
+    tank_calculator.calculate_capacitors_tank(60, 10, table);
+
+    const TankResultTable &reference = tank_calculator.last_results();
+    ASSERT_EQ(table.rows.size(), reference.rows.size());
+    for (size_t r = 0; r < table.rows.size(); ++r)
+    {
+        ASSERT_EQ(table.names[table.rows[r].name], reference.names[reference.rows[r].name]);
+        ASSERT_EQ(table.rows[r].current, reference.rows[r].current);
+        ASSERT_EQ(table.rows[r].voltage, reference.rows[r].voltage);
+        ASSERT_EQ(table.rows[r].power, reference.rows[r].power);
+    }
+
+    std::ostringstream csv;
+    render_csv(csv, table);
+    std::string csv_text = csv.str();
+    ASSERT_EQ(csv_text.substr(0, csv_text.find('\n')), "name,current,voltage,power");
+    ASSERT_EQ(static_cast<size_t>(std::count(csv_text.begin(), csv_text.end(), '\n')), 1 + table.rows.size());
+
+    std::ostringstream json_text;
+    render_json(json_text, table);
+    nlohmann::json parsed = nlohmann::json::parse(json_text.str());
+    ASSERT_EQ(parsed["nodes"].size(), table.rows.size());
+    ASSERT_EQ(parsed["nodes"][2]["name"], "parallel1");
+    ASSERT_EQ(parsed["nodes"][2]["current"].get<double>(), table.rows[2].current);
+}
+
+TEST_F(TankResultTest, PartIndexInternsNames) {
+    std::vector<CapacitorSpecification> specs = capacitor_spec;
+    specs.push_back({2e-6f, 400, "1uF_1000V", 300e3, 900});
+    PartIndex parts(specs);
+    ASSERT_EQ(parts.size(), 2u);
+    // A repeated name keeps its first id and takes the specs of its last listing.
+    ASSERT_EQ(parts.find("1uF_1000V"), 0u);
+    ASSERT_EQ(parts.find("23uF_500V"), 1u);
+    ASSERT_EQ(parts.find("4uF_500V"), no_part);
+    ASSERT_EQ(parts.name(1), "23uF_500V");
+    ASSERT_EQ(parts.cap_uF(0), 2e-6f * 1e6);
+    ASSERT_EQ(parts.v_max(0), 900);
+    ASSERT_EQ(parts.i_max(0), 400);
+    ASSERT_EQ(parts.power_max(0), 300e3);
+}
+
+TEST_F(TankResultTest, ComposeByIdMatchesNames) {
+    TankCalculator by_name(capacitor_spec);
+    by_name.compose_capacitors_tank(group1, group2);
+    auto parts = std::make_shared<const PartIndex>(capacitor_spec);
+    TankCalculator by_id(parts);
+    by_id.compose_capacitors_tank(std::vector<PartId>{parts->find("23uF_500V"), parts->find("1uF_1000V")},
+                                  std::vector<PartId>{parts->find("1uF_1000V")});
+
+    // Evaluated twice, the decorated tank built at composition gives the same rows and names.
+    for (int k = 0; k < 2; ++k)
+    {
+        ASSERT_EQ(by_name.calculate_capacitors_tank(60, 10), by_id.calculate_capacitors_tank(60, 10));
+        ASSERT_EQ(by_id.last_results().rows.size(), 6u);
+        ASSERT_EQ(by_id.last_results().names, by_name.last_results().names);
+        for (size_t r = 0; r < 6; ++r)
+        {
+            ASSERT_EQ(by_id.last_results().rows[r].name, by_name.last_results().rows[r].name);
+            ASSERT_EQ(by_id.last_results().rows[r].current, by_name.last_results().rows[r].current);
+            ASSERT_EQ(by_id.last_results().rows[r].voltage, by_name.last_results().rows[r].voltage);
+        }
+    }
+    ASSERT_EQ(by_id.calculate_allowed_current(60), by_name.calculate_allowed_current(60));
+    ASSERT_EQ(by_id.compiled().names(), by_name.compiled().names());
+}
+
+TEST_F(TankResultTest, RecomposeMatchesFreshCalculator) {
+    auto parts = std::make_shared<const PartIndex>(capacitor_spec);
+    TankCalculator reused(parts);
+    // Growing past the first pool chunk and shrinking again, each composition evaluates like a new calculator.
+    for (size_t n : {1, 2, 7, 40, 3, 33, 1})
+    {
+        std::vector<PartId> ids1, ids2;
+        for (size_t k = 0; k < n; ++k)
+        {
+            ids1.push_back(static_cast<PartId>(k % 2));
+            ids2.push_back(static_cast<PartId>((k / 3) % 2));
+        }
+        reused.compose_capacitors_tank(ids1, ids2);
+        TankCalculator fresh(parts);
+        fresh.compose_capacitors_tank(ids1, ids2);
+
+        ASSERT_EQ(reused.calculate_capacitors_tank(60, 0.01f), fresh.calculate_capacitors_tank(60, 0.01f));
+        ASSERT_EQ(reused.last_results().names, fresh.last_results().names);
+        ASSERT_EQ(reused.last_results().rows.size(), 2 * n + 3);
+        for (size_t r = 0; r < 2 * n + 3; ++r)
+        {
+            ASSERT_EQ(reused.last_results().rows[r].name, fresh.last_results().rows[r].name);
+            ASSERT_EQ(reused.last_results().rows[r].current, fresh.last_results().rows[r].current);
+            ASSERT_EQ(reused.last_results().rows[r].voltage, fresh.last_results().rows[r].voltage);
+        }
+        ASSERT_EQ(reused.compiled().names(), fresh.compiled().names());
+        ASSERT_EQ(reused.calculate_allowed_current(60), fresh.calculate_allowed_current(60));
+
+        ViolationReport reused_report, fresh_report;
+        ASSERT_EQ(reused.check_capacitors_tank(10000, 100000, reused_report),
+                  fresh.check_capacitors_tank(10000, 100000, fresh_report));
+        ASSERT_EQ(reused_report.size(), fresh_report.size());
+        for (size_t v = 0; v < fresh_report.size(); ++v)
+        {
+            ASSERT_EQ(reused_report[v].node, fresh_report[v].node);
+            ASSERT_EQ(reused_report[v].kind, fresh_report[v].kind);
+        }
+    }
+}
+
+TEST_F(TankResultTest, RecomposeDoesNotAllocate) {
+    // Names beyond the small-string size, so reusing them is not left to the string.
+    std::vector<CapacitorSpecification> long_names = capacitor_spec;
+    long_names[0].name = "film_1uF_1000V_vendor_series_a";
+    long_names[1].name = "film_23uF_500V_vendor_series_b";
+    auto parts = std::make_shared<const PartIndex>(long_names);
+    TankCalculator tank_calculator(parts);
+    std::vector<PartId> large = {0, 1, 0, 1, 0, 1, 0};
+    std::vector<PartId> small = {1, 0};
+    {
+        // The first compositions build the nodes, and grow the kept name strings to the longest name each
+        // position has held.
+        AllocationCount first;
+        for (const auto *group1 : {&large, &small, &large})
+        {
+            tank_calculator.compose_capacitors_tank(*group1, large);
+            tank_calculator.calculate_capacitors_tank(60, 0.01f);
+        }
+        ASSERT_GT(first.count, 0u);
+    }
+
+    AllocationCount recompose;
+    for (int k = 0; k < 1000; ++k)
+    {
+        tank_calculator.compose_capacitors_tank(k % 2 == 0 ? small : large, large);
+        tank_calculator.calculate_capacitors_tank(60, 0.01f);
+    }
+    ASSERT_EQ(recompose.count, 0u);
+    ASSERT_EQ(tank_calculator.compiled().names()[0], "film_1uF_1000V_vendor_series_a");
+}
+
+TEST_F(TankResultTest, BatchStream) {
+    TankCalculator tank_calculator(capacitor_spec);
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    std::FILE *input = std::tmpfile();
+    std::FILE *output = std::tmpfile();
+    std::fputs("current,frequency\n1,50\n\n 2.5 , 60\r\nnot,a point\n100000,10000", input);
+    std::rewind(input);
+
+    BatchStats stats = run_batch(tank_calculator, input, output);
+    ASSERT_EQ(stats.points, 3u);
+    ASSERT_EQ(stats.skipped_lines, 1u);
+
+    std::rewind(output);
+    char line[256];
+    std::vector<std::string> lines;
+    while (std::fgets(line, sizeof(line), output))
+    {
+        lines.push_back(line);
+    }
+    std::fclose(input);
+    std::fclose(output);
+
+    ASSERT_EQ(lines.size(), 4u);
+    ASSERT_EQ(lines[0], "current,frequency,tank_current,allowed_current,violations\n");
+
+    ViolationReport report;
+    double current = tank_calculator.check_capacitors_tank(60, 2.5, report);
+    double allowed = tank_calculator.calculate_allowed_current(60);
+    double row_current, row_frequency, row_tank_current, row_allowed;
+    size_t row_violations;
+    ASSERT_EQ(std::sscanf(lines[2].c_str(), "%lf,%lf,%lf,%lf,%zu", &row_current, &row_frequency, &row_tank_current, &row_allowed, &row_violations), 5);
+    ASSERT_EQ(row_current, 2.5);
+    ASSERT_EQ(row_frequency, 60);
+    ASSERT_EQ(row_tank_current, current);
+    ASSERT_EQ(row_allowed, allowed);
+    ASSERT_EQ(row_violations, report.size());
+
+    report.clear();
+    tank_calculator.check_capacitors_tank(10000, 100000, report);
+    ASSERT_EQ(lines[3].substr(lines[3].rfind(',') + 1), std::to_string(report.size()) + "\n");
+}
+
+TEST(TankSweepTest, MatchesReferenceTree) {
+    std::vector<CapacitorSpecification> capacitor_spec = {
+        {1e-6f, 500, "1uF_1000V", 500e3, 1000},
+        {3.3e-6f, 600, "3.3uF_800V", 500e3, 800},
+        {23e-6f, 1000, "23uF_500V", 500e3, 500}};
+
+    TankCalculator tank_calculator(capacitor_spec);
+    std::vector<std::string> group1 = {"23uF_500V", "1uF_1000V"};
+    std::vector<std::string> group2 = {"3.3uF_800V"};
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    std::vector<float> frequencies = {50, 60, 1000, 10000};
+    std::vector<float> currents = {1, 10, 100, 1000};
+    TankSweepResult result;
+    tank_calculator.sweep_capacitors_tank(frequencies, currents, result);
+
+    Capacitor c23(capacitor_spec[2].capacitance * 1e6, 500, 1000, 500e3, "23uF_500V");
+    Capacitor c1(capacitor_spec[0].capacitance * 1e6, 1000, 500, 500e3, "1uF_1000V");
+    Capacitor c33(capacitor_spec[1].capacitance * 1e6, 800, 600, 500e3, "3.3uF_800V");
+    ParallelCapacitor parallel1({&c23, &c1}, "parallel1");
+    ParallelCapacitor parallel2({&c33}, "parallel2");
+    SeriesCapacitor serial({&parallel1, &parallel2}, "serial");
+
+    std::vector<std::string> names = {"23uF_500V", "1uF_1000V", "parallel1", "3.3uF_800V", "parallel2", "serial"};
+    ASSERT_EQ(result.node_names, names);
+    ASSERT_EQ(result.current.size(), frequencies.size() * names.size());
+
+    for (size_t p = 0; p < frequencies.size(); ++p)
+    {
+        double f = frequencies[p];
+        double current = serial.current(f, currents[p]);
+        double v1 = parallel1.xc(f) * current;
+        double v2 = parallel2.xc(f) * current;
+        const double *i = &result.current[p * names.size()];
+        const double *v = &result.voltage[p * names.size()];
+
+        EXPECT_DOUBLE_EQ(i[0], c23.current(f, v1));
+        EXPECT_DOUBLE_EQ(i[1], c1.current(f, v1));
+        EXPECT_DOUBLE_EQ(i[2], parallel1.current(f, v1));
+        EXPECT_DOUBLE_EQ(v[2], v1);
+        EXPECT_DOUBLE_EQ(i[3], c33.current(f, v2));
+        EXPECT_DOUBLE_EQ(i[4], parallel2.current(f, v2));
+        EXPECT_DOUBLE_EQ(i[5], current);
+        EXPECT_DOUBLE_EQ(v[5], currents[p]);
+        EXPECT_DOUBLE_EQ(result.power[p * names.size() + 5], current * currents[p]);
+        EXPECT_DOUBLE_EQ(result.allowed_current[p], tank_calculator.calculate_allowed_current(frequencies[p]));
+        EXPECT_DOUBLE_EQ(result.allowed_current[p], serial.allowed_current(frequencies[p]));
+    }
+}
+
+TEST(TankSweepTest, LanesMatchEvaluatorAndFloatWithinBound) {
+    std::vector<CapacitorSpecification> capacitor_spec = {
+        {1e-6f, 500, "1uF_1000V", 500e3, 1000},
+        {3.3e-6f, 600, "3.3uF_800V", 500e3, 800},
+        {23e-6f, 1000, "23uF_500V", 500e3, 500}};
+
+    TankCalculator tank_calculator(capacitor_spec);
+    std::vector<std::string> group1 = {"23uF_500V", "1uF_1000V", "1uF_1000V", "3.3uF_800V", "23uF_500V"};
+    std::vector<std::string> group2 = {"3.3uF_800V", "1uF_1000V", "23uF_500V", "3.3uF_800V"};
+    tank_calculator.compose_capacitors_tank(group1, group2);
+
+    // Not a multiple of the lanes, so the last block is partial.
+    std::vector<float> frequencies;
+    std::vector<float> currents;
+    for (int p = 0; p < 1001; ++p)
+    {
+        frequencies.push_back(50.0f + 97.3f * p);
+        currents.push_back(0.5f + 3.7f * (p % 211));
+    }
+    TankSweepResult result;
+    tank_calculator.sweep_capacitors_tank(frequencies, currents, result);
+    BasicTankSweepResult<float> single;
+    tank_calculator.sweep_capacitors_tank(frequencies, currents, single);
+
+    CompiledTankEvaluator evaluator(tank_calculator.compiled());
+    const size_t nodes = result.node_names.size();
+    const double bound = (2 * 9 + 16) * std::ldexp(1.0, -24);
+    ASSERT_EQ(single.node_names, result.node_names);
+    for (size_t p = 0; p < frequencies.size(); ++p)
+    {
+        evaluator.current(frequencies[p], currents[p]);
+        ASSERT_EQ(result.allowed_current[p], evaluator.allowed_current());
+        ASSERT_NEAR(single.allowed_current[p], result.allowed_current[p], bound * result.allowed_current[p]);
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            size_t index = p * nodes + n;
+            ASSERT_EQ(result.current[index], evaluator.node_current()[n]);
+            ASSERT_EQ(result.voltage[index], evaluator.node_voltage()[n]);
+            ASSERT_NEAR(single.current[index], result.current[index], bound * result.current[index]);
+            ASSERT_NEAR(single.voltage[index], result.voltage[index], bound * result.voltage[index]);
+            ASSERT_NEAR(single.power[index], result.power[index], bound * result.power[index]);
+        }
+    }
+}
+
+TEST(TankSweepTest, MismatchedInputs) {
+    std::vector<CapacitorSpecification> capacitor_spec = {{1e-6f, 500, "1uF_1000V", 500e3, 1000}};
+    TankCalculator tank_calculator(capacitor_spec);
+    std::vector<std::string> group = {"1uF_1000V"};
+    tank_calculator.compose_capacitors_tank(group, group);
+
+    TankSweepResult result;
+    ASSERT_THROW(tank_calculator.sweep_capacitors_tank({50, 60}, {1}, result), std::invalid_argument);
+}
+
 } // namespace
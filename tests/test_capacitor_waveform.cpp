@@ -0,0 +1,175 @@
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_waveform.h"
+
+#include "gtest/gtest.h"
+#include "tank_test_fixture.h"
+namespace {
+
+class WaveformTest : public ReferenceTankTest {
+protected:
+    // At 1 kHz, a 10 Hz corner under-reads voltages by 0.01% and settles in 0.16 s.
+    WaveformOptions options()
+    {
+        WaveformOptions options;
+        options.sample_rate = 1e6;
+        options.window = 10000;
+        options.highpass = 10.0;
+        return options;
+    }
+
+    // Sine of the given RMS current and frequency.
+    std::vector<float> sine(double rms, double f, size_t count, double sample_rate = 1e6)
+    {
+        std::vector<float> samples(count);
+        for (size_t k = 0; k < count; ++k)
+        {
+            samples[k] = static_cast<float>(rms * std::sqrt(2.0) * std::sin(2 * M_PI * f * k / sample_rate));
+        }
+        return samples;
+    }
+};
+
+TEST_F(WaveformTest, WindowedValuesMatchSteadyState) {
+    // 30 A at 1 kHz puts about 4.8 kV on c3, above all its limits.
+    WaveformAnalyzer analyzer(tank, options());
+    std::vector<float> samples = sine(30, 1000, analyzer.settle_samples() + 500000);
+    std::vector<Violation> last;
+    uint64_t last_window = 0;
+    analyzer.process(samples.data(), samples.size(), [&](uint64_t window, const ViolationReport &violations) {
+        last_window = window;
+        last.assign(violations.begin(), violations.end());
+    });
+    ASSERT_EQ(analyzer.samples(), 500000u);
+    ASSERT_EQ(analyzer.windows(), 50u);
+    ASSERT_EQ(last_window, 49u);
+
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(1000, 30);
+    int overvoltage = 0;
+    for (const Violation &violation : last)
+    {
+        double current = evaluator.node_current()[violation.node];
+        double voltage = evaluator.node_voltage()[violation.node];
+        switch (violation.kind)
+        {
+        case ViolationKind::Overcurrent:
+            ASSERT_NEAR(violation.value, current, 1e-3 * current);
+            break;
+        case ViolationKind::Overvoltage:
+            ASSERT_NEAR(violation.value, voltage, 1e-3 * voltage);
+            ASSERT_EQ(violation.limit, tank.v_max()[violation.node]);
+            ++overvoltage;
+            break;
+        case ViolationKind::Overpower:
+            ASSERT_NEAR(violation.value, current * voltage, 2e-3 * current * voltage);
+            break;
+        }
+    }
+    // c3, parallel2 and serial.
+    ASSERT_EQ(overvoltage, 3);
+}
+
+TEST_F(WaveformTest, NodeStatisticsMatchSteadyState) {
+    std::vector<float> samples = sine(30, 1000, 1000000);
+    WaveformAnalyzer analyzer(tank, options());
+    analyzer.process(samples.data(), samples.size(), [](uint64_t, const ViolationReport &) {});
+    analyzer.finish([](uint64_t, const ViolationReport &) {});
+
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(1000, 30);
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        WaveformNodeStatistics statistics = analyzer.node_statistics(n);
+        double current = evaluator.node_current()[n];
+        double voltage = evaluator.node_voltage()[n];
+        ASSERT_NEAR(statistics.rms_current, current, 1e-3 * current);
+        ASSERT_NEAR(statistics.peak_current, std::sqrt(2.0) * current, 1e-3 * current);
+        ASSERT_NEAR(statistics.rms_voltage, voltage, 1e-3 * voltage);
+        ASSERT_NEAR(statistics.peak_voltage, std::sqrt(2.0) * voltage, 1e-3 * voltage);
+    }
+}
+
+TEST_F(WaveformTest, MainsFrequenciesWithinFilterBound) {
+    // The default corner keeps the DC block error at mains frequencies below (fc / f)^2.
+    for (double f : {50.0, 60.0})
+    {
+        WaveformOptions mains;
+        mains.sample_rate = 1e4;
+        mains.window = 2000;
+        WaveformAnalyzer analyzer(tank, mains);
+        // Two seconds after settling, whole periods at both frequencies.
+        std::vector<float> samples = sine(2, f, analyzer.settle_samples() + 20000, mains.sample_rate);
+        analyzer.process(samples.data(), samples.size(), [](uint64_t, const ViolationReport &) {});
+        ASSERT_EQ(analyzer.samples(), 20000u);
+
+        CompiledTankEvaluator evaluator(tank);
+        evaluator.voltage(f, 2);
+        double bound = (mains.highpass / f) * (mains.highpass / f);
+        for (uint32_t n = 0; n < tank.size(); ++n)
+        {
+            WaveformNodeStatistics statistics = analyzer.node_statistics(n);
+            double current = evaluator.node_current()[n];
+            double voltage = evaluator.node_voltage()[n];
+            ASSERT_GE(statistics.rms_current, (1 - bound / 2 - 1e-5) * current);
+            ASSERT_LE(statistics.rms_current, (1 + 1e-5) * current);
+            ASSERT_GE(statistics.rms_voltage, (1 - bound - 1e-5) * voltage);
+            ASSERT_LE(statistics.rms_voltage, (1 + 1e-4) * voltage);
+        }
+    }
+}
+
+TEST_F(WaveformTest, NoEventsWithinLimits) {
+    std::vector<float> samples = sine(1, 10000, 100000);
+    WaveformAnalyzer analyzer(tank, options());
+    int events = 0;
+    analyzer.process(samples.data(), samples.size(), [&](uint64_t, const ViolationReport &) { ++events; });
+    analyzer.finish([&](uint64_t, const ViolationReport &) { ++events; });
+    ASSERT_EQ(events, 0);
+}
+
+TEST_F(WaveformTest, StreamMatchesProcess) {
+    // Not a multiple of the window nor of the stream buffers, so the last window is partial.
+    std::vector<float> samples = sine(30, 1000, 345678);
+    WaveformAnalyzer expected(tank, options());
+    std::vector<uint64_t> expected_windows;
+    auto record_expected = [&](uint64_t window, const ViolationReport &) { expected_windows.push_back(window); };
+    expected.process(samples.data(), samples.size(), record_expected);
+    expected.finish(record_expected);
+
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(std::fwrite(samples.data(), sizeof(float), samples.size(), file), samples.size());
+    std::rewind(file);
+
+    WaveformAnalyzer analyzer(tank, options());
+    std::vector<uint64_t> windows;
+    uint64_t count = stream_waveform(analyzer, file, [&](uint64_t window, const ViolationReport &) { windows.push_back(window); });
+    std::fclose(file);
+
+    ASSERT_EQ(count, samples.size() - analyzer.settle_samples());
+    ASSERT_EQ(analyzer.windows(), 19u);
+    ASSERT_EQ(windows, expected_windows);
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        WaveformNodeStatistics a = analyzer.node_statistics(n);
+        WaveformNodeStatistics b = expected.node_statistics(n);
+        ASSERT_NEAR(a.rms_current, b.rms_current, 1e-12 * b.rms_current);
+        ASSERT_NEAR(a.rms_voltage, b.rms_voltage, 1e-12 * b.rms_voltage);
+        ASSERT_EQ(a.peak_current, b.peak_current);
+        ASSERT_EQ(a.peak_voltage, b.peak_voltage);
+    }
+}
+
+TEST_F(WaveformTest, RejectsEmptyWindow) {
+    WaveformOptions bad = options();
+    bad.window = 0;
+    ASSERT_THROW(WaveformAnalyzer(tank, bad), std::invalid_argument);
+}
+
+}
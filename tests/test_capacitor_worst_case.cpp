@@ -0,0 +1,113 @@
+#include <vector>
+#include <cmath>
+#include <random>
+
+#include "capacitors.h"
+#include "capacitor_compiled.h"
+#include "capacitor_interval.h"
+#include "capacitor_worst_case.h"
+
+#include "gtest/gtest.h"
+#include "tank_test_fixture.h"
+namespace {
+
+class WorstCaseTest : public ReferenceTankTest {};
+
+TEST(IntervalTest, Operations) {
+    Interval a(1, 2);
+    Interval b(-3, 4);
+    ASSERT_TRUE((a + b).contains(-2) && (a + b).contains(6));
+    ASSERT_TRUE((a - b).contains(-3) && (a - b).contains(5));
+    ASSERT_TRUE((a * b).contains(-6) && (a * b).contains(8));
+    ASSERT_LT((a * b).width(), 14.0001);
+    ASSERT_EQ(a / b, Interval(-HUGE_VAL, HUGE_VAL));
+    ASSERT_TRUE((Interval(1) / Interval(3)).contains(1.0 / 3));
+    ASSERT_EQ(smaller(Interval(1, 5), Interval(2, 3)), Interval(1, 3));
+    ASSERT_EQ(upper(Interval(1, 5)), 5);
+}
+
+TEST_F(WorstCaseTest, PointIntervalsContainEvaluator) {
+    WorstCaseOptions options;
+    options.current = 30;
+    options.frequency = 1000;
+    options.capacitance_tolerance = 0;
+    WorstCaseResult result = run_worst_case(tank, options);
+
+    CompiledTankEvaluator evaluator(tank);
+    evaluator.voltage(options.frequency, options.current);
+    double allowed_current = evaluator.allowed_current();
+    ViolationReport report;
+    evaluator.check_limits(report);
+
+    ASSERT_EQ(result.nodes.size(), tank.size());
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        const NodeBounds &node = result.nodes[n];
+        ASSERT_TRUE(node.current.contains(evaluator.node_current()[n]));
+        ASSERT_TRUE(node.voltage.contains(evaluator.node_voltage()[n]));
+        ASSERT_TRUE(node.power.contains(evaluator.node_power(n)));
+        ASSERT_TRUE(node.allowed_current.contains(evaluator.node_allowed_current()[n]));
+        ASSERT_LT(node.current.width(), 1e-12 * node.current.hi);
+    }
+    ASSERT_TRUE(result.allowed_current.contains(allowed_current));
+    ASSERT_EQ(result.violations.size(), report.size());
+}
+
+TEST_F(WorstCaseTest, BoundsContainPerturbedTanks) {
+    WorstCaseOptions options;
+    options.current = 30;
+    options.frequency = 1000;
+    options.current_tolerance = 0.02;
+    options.frequency_tolerance = 0.01;
+    options.capacitance_tolerance = 0.1;
+    WorstCaseResult result = run_worst_case(tank, options);
+
+    std::mt19937_64 random(7);
+    std::uniform_real_distribution<double> factor(-1, 1);
+    CompiledTankEvaluator evaluator(tank);
+    std::vector<bool> violated(tank.size());
+    for (int sample = 0; sample < 2000; ++sample)
+    {
+        // Corners every other sample, where the extremes of a monotonic tank lie.
+        auto draw = [&](double tolerance) {
+            double u = factor(random);
+            return 1 + tolerance * (sample % 2 ? (u < 0 ? -1 : 1) : u);
+        };
+        for (uint32_t n = 0; n < tank.size(); ++n)
+        {
+            if (tank.kind()[n] == CapacitorKind::Single)
+            {
+                evaluator.set_cap_F(n, tank.cap_F()[n] * draw(options.capacitance_tolerance));
+            }
+        }
+        evaluator.voltage(options.frequency * draw(options.frequency_tolerance),
+                          options.current * draw(options.current_tolerance));
+        ASSERT_TRUE(result.allowed_current.contains(evaluator.allowed_current()));
+
+        ViolationReport report;
+        evaluator.check_limits(report);
+        for (const Violation &violation : report)
+        {
+            violated[violation.node] = true;
+        }
+        for (uint32_t n = 0; n < tank.size(); ++n)
+        {
+            ASSERT_TRUE(result.nodes[n].current.contains(evaluator.node_current()[n]));
+            ASSERT_TRUE(result.nodes[n].voltage.contains(evaluator.node_voltage()[n]));
+            ASSERT_TRUE(result.nodes[n].power.contains(evaluator.node_power(n)));
+        }
+    }
+
+    // Every violation a sample found is among the possible ones.
+    for (uint32_t n = 0; n < tank.size(); ++n)
+    {
+        bool possible = false;
+        for (const Violation &violation : result.violations)
+        {
+            possible = possible || violation.node == n;
+        }
+        ASSERT_TRUE(possible || !violated[n]);
+    }
+}
+
+} // namespace
@@ -109,6 +109,39 @@ TEST(CapacitorTest, TestCapacitorDecoratorExceedingRange)
     ASSERT_THROW(decoratedCap.voltage(f, 1001), std::runtime_error);
 }
 
+TEST(CapacitorTest, TestCapacitorDecoratorReportsAllViolations) 
+{
+    Capacitor cap(10, 1000, 500, 500e3, "C1");
+    ViolationReport report(4);
+    CapacitorMaxViolationCheckDecorator decoratedCap(&cap, &report, 7);
+
+    double f = 50000;
+    ASSERT_NO_THROW(decoratedCap.current(f, 1000));
+    ASSERT_EQ(report.size(), 2);
+    ASSERT_EQ(report[0].node, 7);
+    ASSERT_EQ(report[0].kind, ViolationKind::Overcurrent);
+    ASSERT_EQ(report[0].value, cap.current(f, 1000));
+    ASSERT_EQ(report[0].limit, 500);
+    ASSERT_EQ(report[1].kind, ViolationKind::Overpower);
+
+    CapacitorMaxViolationCheckDecorator throwingCap(&cap);
+    try {
+        throwingCap.current(f, 1000);
+        FAIL();
+    } catch (const std::runtime_error& e) {
+        ASSERT_EQ(format_violation(report[0], cap.name()), e.what());
+    }
+
+    ASSERT_NO_THROW(decoratedCap.voltage(50, 1001));
+    ASSERT_NO_THROW(decoratedCap.voltage(50, 1001));
+    ASSERT_EQ(report.size(), 4);
+    ASSERT_EQ(report[2].kind, ViolationKind::Overvoltage);
+    ASSERT_EQ(report.dropped(), 2);
+
+    report.clear();
+    ASSERT_TRUE(report.empty());
+}
+
 TEST(CapacitorTest, TestParallelGroupSingleCapacitorExceedingRange) {
     double f = 500000;
     CapacitorMaxViolationCheckDecorator cap1(new Capacitor(10, 1000, 500, 500e3));